@@ -0,0 +1,95 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include <daw/sqlite/sqlite3_class.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace daw::sqlite::bench {
+	/***
+	 * @brief Benchmarks taking a storage argument run once against an in
+	 * memory database and once against a file
+	 */
+	enum class storage : std::int64_t { Memory = 0, Disk = 1 };
+
+	inline void storage_args( benchmark::internal::Benchmark *b ) {
+		b->ArgName( "disk" )->Arg( 0 )->Arg( 1 );
+	}
+
+	[[nodiscard]] inline std::filesystem::path bench_file( ) {
+		return std::filesystem::temp_directory_path( ) / "daw_sqlite_bench.db";
+	}
+
+	/***
+	 * @brief Remove the file database and everything sqlite keeps next to it
+	 */
+	inline void remove_bench_file( ) {
+		auto const base = bench_file( ).string( );
+		for( auto const *suffix : { "", "-journal", "-wal", "-shm" } ) {
+			std::filesystem::remove( base + suffix );
+		}
+	}
+
+	[[nodiscard]] inline std::string bench_path( benchmark::State const &state ) {
+		if( static_cast<storage>( state.range( 0 ) ) == storage::Memory ) {
+			return ":memory:";
+		}
+		remove_bench_file( );
+		return bench_file( ).string( );
+	}
+
+	/***
+	 * @brief A fresh database for the benchmark.  On disk it uses WAL with
+	 * synchronous=NORMAL, the usual configuration for throughput
+	 */
+	[[nodiscard]] inline database open_bench_db( benchmark::State const &state ) {
+		auto options = open_options{ };
+		if( static_cast<storage>( state.range( 0 ) ) == storage::Disk ) {
+			options.journal = journal_mode::WAL;
+			options.synchronous = synchronous_mode::Normal;
+		}
+		return database( bench_path( state ), options );
+	}
+
+	/***
+	 * @brief A raw connection configured like open_bench_db, for the sqlite3 C
+	 * API baselines
+	 */
+	[[nodiscard]] inline sqlite3 *open_raw_db( benchmark::State const &state ) {
+		sqlite3 *db = nullptr;
+		(void)sqlite3_open( bench_path( state ).c_str( ), &db );
+		if( static_cast<storage>( state.range( 0 ) ) == storage::Disk ) {
+			(void)sqlite3_exec( db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;",
+			                    nullptr, nullptr, nullptr );
+		}
+		return db;
+	}
+
+	/***
+	 * @brief Fill tbl( id INTEGER, name TEXT, data BLOB, score REAL ) with
+	 * row_count rows
+	 */
+	inline void fill_table( database &db, std::int64_t row_count ) {
+		db.exec( "CREATE TABLE tbl( id INTEGER PRIMARY KEY, name TEXT, data BLOB, "
+		         "score REAL );" );
+		auto tx = transaction( db );
+		for( std::int64_t n = 0; n < row_count; ++n ) {
+			db.exec(
+			    "INSERT INTO tbl( id, name, data, score ) VALUES( ?, ?, "
+			    "randomblob( 32 ), ? );",
+			    n, "name_" + std::to_string( n ), static_cast<double>( n ) / 3.0 );
+		}
+		tx.commit( );
+	}
+} // namespace daw::sqlite::bench
@@ -0,0 +1,108 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "bench_common.h"
+
+#include <daw/sqlite/bulk_inserter.h>
+#include <daw/sqlite/sqlite3_class.h>
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <sqlite3.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace daw::sqlite::bench {
+	namespace {
+		constexpr std::int64_t rows_per_iteration = 1'000;
+		constexpr char const insert_sql[] = "INSERT INTO ins( a, b ) VALUES( ?, ? );";
+
+		void create_insert_table( database &db ) {
+			db.exec( "CREATE TABLE ins( a INTEGER, b TEXT );" );
+		}
+
+		void raw_insert( benchmark::State &state, bool use_transaction ) {
+			auto *db = open_raw_db( state );
+			(void)sqlite3_exec( db, "CREATE TABLE ins( a INTEGER, b TEXT );", nullptr,
+			                    nullptr, nullptr );
+			sqlite3_stmt *statement = nullptr;
+			(void)sqlite3_prepare_v2( db, insert_sql, -1, &statement, nullptr );
+			static constexpr std::string_view text = "some text value";
+			for( auto _ : state ) {
+				if( use_transaction ) {
+					(void)sqlite3_exec( db, "BEGIN;", nullptr, nullptr, nullptr );
+				}
+				for( std::int64_t n = 0; n < rows_per_iteration; ++n ) {
+					sqlite3_bind_int64( statement, 1, n );
+					sqlite3_bind_text( statement, 2, text.data( ),
+					                   static_cast<int>( text.size( ) ), SQLITE_STATIC );
+					(void)sqlite3_step( statement );
+					sqlite3_reset( statement );
+				}
+				if( use_transaction ) {
+					(void)sqlite3_exec( db, "COMMIT;", nullptr, nullptr, nullptr );
+				}
+			}
+			sqlite3_finalize( statement );
+			sqlite3_close( db );
+			state.SetItemsProcessed( state.iterations( ) * rows_per_iteration );
+		}
+		BENCHMARK_CAPTURE( raw_insert, autocommit, false )->Apply( storage_args );
+		BENCHMARK_CAPTURE( raw_insert, transaction, true )->Apply( storage_args );
+
+		void exec_insert( benchmark::State &state, bool use_transaction ) {
+			auto db = open_bench_db( state );
+			create_insert_table( db );
+			for( auto _ : state ) {
+				auto tx = std::optional<transaction>( );
+				if( use_transaction ) {
+					tx.emplace( db );
+				}
+				for( std::int64_t n = 0; n < rows_per_iteration; ++n ) {
+					db.exec( insert_sql, n, "some text value" );
+				}
+				if( tx ) {
+					tx->commit( );
+				}
+			}
+			state.SetItemsProcessed( state.iterations( ) * rows_per_iteration );
+		}
+		BENCHMARK_CAPTURE( exec_insert, autocommit, false )->Apply( storage_args );
+		BENCHMARK_CAPTURE( exec_insert, transaction, true )->Apply( storage_args );
+
+		/***
+		 * @param rows_per_statement 1 for a single row INSERT, 0 for as many
+		 * rows per INSERT as the variable limit allows
+		 */
+		void bulk_insert( benchmark::State &state, std::size_t rows_per_statement ) {
+			auto db = open_bench_db( state );
+			create_insert_table( db );
+			using row_t = std::tuple<std::int64_t, std::string>;
+			auto rows = std::vector<row_t>( );
+			for( std::int64_t n = 0; n < rows_per_iteration; ++n ) {
+				rows.emplace_back( n, "some text value" );
+			}
+			auto options = bulk_insert_options{ };
+			options.rows_per_statement = rows_per_statement;
+			for( auto _ : state ) {
+				auto inserter = bulk_inserter<row_t>( db, "ins", { "a", "b" }, options );
+				inserter.insert( rows );
+				inserter.finish( );
+			}
+			state.SetItemsProcessed( state.iterations( ) * rows_per_iteration );
+		}
+		BENCHMARK_CAPTURE( bulk_insert, single_row, std::size_t{ 1 } )
+		  ->Apply( storage_args );
+		BENCHMARK_CAPTURE( bulk_insert, multi_row, std::size_t{ 0 } )
+		  ->Apply( storage_args );
+	} // namespace
+} // namespace daw::sqlite::bench
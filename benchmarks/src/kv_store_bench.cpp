@@ -0,0 +1,115 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "bench_common.h"
+
+#include <daw/sqlite/kv_store.h>
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <sqlite3.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace daw::sqlite::bench {
+	namespace {
+		constexpr std::int64_t key_count = 10'000;
+		constexpr std::size_t value_bytes = 128;
+
+		/***
+		 * @param cache_bytes Size of the kv_store read cache, 0 disables it
+		 */
+		[[nodiscard]] daw::db::kv_store open_kv_store( benchmark::State const &state,
+		                                               std::size_t cache_bytes ) {
+			auto options = daw::db::kv_store_options{ };
+			options.read_cache_bytes = cache_bytes;
+			if( static_cast<storage>( state.range( 0 ) ) == storage::Memory ) {
+				// WAL is not supported by in memory databases
+				options.open.journal.reset( );
+			}
+			auto store = daw::db::kv_store( bench_path( state ), options );
+			auto const value = std::string( value_bytes, 'v' );
+			auto pairs = std::vector<std::pair<std::int64_t, std::string>>( );
+			for( std::int64_t n = 0; n < key_count; ++n ) {
+				pairs.emplace_back( n, value );
+			}
+			store.put_many( pairs );
+			return store;
+		}
+
+		// Baseline with the same schema and statements as kv_store
+		void raw_kv_get( benchmark::State &state ) {
+			auto *db = open_raw_db( state );
+			(void)sqlite3_exec( db,
+			                    "CREATE TABLE kv( key BLOB PRIMARY KEY, value BLOB ) "
+			                    "WITHOUT ROWID;",
+			                    nullptr, nullptr, nullptr );
+			sqlite3_stmt *put = nullptr;
+			(void)sqlite3_prepare_v2(
+			  db, "INSERT INTO kv( key, value ) VALUES( ?, ? );", -1, &put, nullptr );
+			auto const value = std::string( value_bytes, 'v' );
+			(void)sqlite3_exec( db, "BEGIN;", nullptr, nullptr, nullptr );
+			for( std::int64_t n = 0; n < key_count; ++n ) {
+				sqlite3_bind_blob( put, 1, &n, sizeof( n ), SQLITE_STATIC );
+				sqlite3_bind_blob( put, 2, value.data( ),
+				                   static_cast<int>( value.size( ) ), SQLITE_STATIC );
+				(void)sqlite3_step( put );
+				sqlite3_reset( put );
+			}
+			(void)sqlite3_exec( db, "COMMIT;", nullptr, nullptr, nullptr );
+			sqlite3_finalize( put );
+
+			sqlite3_stmt *get = nullptr;
+			(void)sqlite3_prepare_v2( db, "SELECT value FROM kv WHERE key=?;", -1,
+			                          &get, nullptr );
+			std::int64_t key = 0;
+			for( auto _ : state ) {
+				sqlite3_bind_blob( get, 1, &key, sizeof( key ), SQLITE_STATIC );
+				if( sqlite3_step( get ) == SQLITE_ROW ) {
+					auto const *first =
+					  static_cast<char const *>( sqlite3_column_blob( get, 0 ) );
+					auto result = std::string(
+					  first, static_cast<std::size_t>( sqlite3_column_bytes( get, 0 ) ) );
+					benchmark::DoNotOptimize( result );
+				}
+				sqlite3_reset( get );
+				key = ( key + 7919 ) % key_count;
+			}
+			sqlite3_finalize( get );
+			sqlite3_close( db );
+		}
+		BENCHMARK( raw_kv_get )->Apply( storage_args );
+
+		void kv_store_get( benchmark::State &state, std::size_t cache_bytes ) {
+			auto store = open_kv_store( state, cache_bytes );
+			std::int64_t key = 0;
+			for( auto _ : state ) {
+				auto result = store.get<std::string>( key );
+				benchmark::DoNotOptimize( result );
+				key = ( key + 7919 ) % key_count;
+			}
+		}
+		BENCHMARK_CAPTURE( kv_store_get, uncached, std::size_t{ 0 } )
+		  ->Apply( storage_args );
+		BENCHMARK_CAPTURE( kv_store_get, cached, std::size_t{ 64U << 20U } )
+		  ->Apply( storage_args );
+
+		void kv_store_put( benchmark::State &state ) {
+			auto store = open_kv_store( state, 0 );
+			auto const value = std::string( value_bytes, 'w' );
+			std::int64_t key = 0;
+			for( auto _ : state ) {
+				store.put( key, value );
+				key = ( key + 7919 ) % key_count;
+			}
+		}
+		BENCHMARK( kv_store_put )->Apply( storage_args );
+	} // namespace
+} // namespace daw::sqlite::bench
@@ -0,0 +1,84 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "bench_common.h"
+
+#include <daw/sqlite/sqlite3_class.h>
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <sqlite3.h>
+
+namespace daw::sqlite::bench {
+	namespace {
+		constexpr std::int64_t row_count = 10'000;
+		constexpr char const scan_sql[] = "SELECT id, name, data, score FROM tbl;";
+
+		// Baseline for result_row_t, reading every column through the C API
+		void raw_read_columns( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, row_count );
+			sqlite3_stmt *statement = nullptr;
+			(void)sqlite3_prepare_v2( db.get_handle( ), scan_sql, -1, &statement,
+			                          nullptr );
+			for( auto _ : state ) {
+				while( sqlite3_step( statement ) == SQLITE_ROW ) {
+					benchmark::DoNotOptimize( sqlite3_column_int64( statement, 0 ) );
+					benchmark::DoNotOptimize( sqlite3_column_text( statement, 1 ) );
+					benchmark::DoNotOptimize( sqlite3_column_blob( statement, 2 ) );
+					benchmark::DoNotOptimize( sqlite3_column_double( statement, 3 ) );
+				}
+				sqlite3_reset( statement );
+			}
+			sqlite3_finalize( statement );
+			state.SetItemsProcessed( state.iterations( ) * row_count );
+		}
+		BENCHMARK( raw_read_columns )->Apply( storage_args );
+
+		void result_row_construction( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, row_count );
+			for( auto _ : state ) {
+				for( auto it = db.exec( scan_sql ); it != it.end( ); ++it ) {
+					// Dereferencing materializes the result_row_t
+					benchmark::DoNotOptimize( &*it );
+				}
+			}
+			state.SetItemsProcessed( state.iterations( ) * row_count );
+		}
+		BENCHMARK( result_row_construction )->Apply( storage_args );
+
+		void lookup_by_index( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, row_count );
+			for( auto _ : state ) {
+				double sum = 0.0;
+				for( auto const &row : db.exec( scan_sql ) ) {
+					sum += row[3].value.get_float( );
+				}
+				benchmark::DoNotOptimize( sum );
+			}
+			state.SetItemsProcessed( state.iterations( ) * row_count );
+		}
+		BENCHMARK( lookup_by_index )->Arg( 0 );
+
+		void lookup_by_name( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, row_count );
+			for( auto _ : state ) {
+				double sum = 0.0;
+				for( auto const &row : db.exec( scan_sql ) ) {
+					sum += row["score"].get_float( );
+				}
+				benchmark::DoNotOptimize( sum );
+			}
+			state.SetItemsProcessed( state.iterations( ) * row_count );
+		}
+		BENCHMARK( lookup_by_name )->Arg( 0 );
+	} // namespace
+} // namespace daw::sqlite::bench
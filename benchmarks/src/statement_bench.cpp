@@ -0,0 +1,189 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "bench_common.h"
+
+#include <daw/sqlite/sqlite3_class.h>
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <sqlite3.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace daw::sqlite::bench {
+	namespace {
+		constexpr char const select_one_sql[] =
+		  "SELECT id, name, data, score FROM tbl WHERE id=?;";
+		constexpr std::int64_t scan_rows = 10'000;
+
+		// Prepare
+
+		void raw_prepare( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, 1 );
+			for( auto _ : state ) {
+				sqlite3_stmt *statement = nullptr;
+				(void)sqlite3_prepare_v2( db.get_handle( ), select_one_sql, -1,
+				                          &statement, nullptr );
+				benchmark::DoNotOptimize( statement );
+				sqlite3_finalize( statement );
+			}
+		}
+		BENCHMARK( raw_prepare )->Apply( storage_args );
+
+		void prepared_statement_prepare( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, 1 );
+			for( auto _ : state ) {
+				auto statement = prepared_statement( db, select_one_sql );
+				benchmark::DoNotOptimize( statement.get( ) );
+			}
+		}
+		BENCHMARK( prepared_statement_prepare )->Apply( storage_args );
+
+		void statement_cache_get( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, 1 );
+			auto &cache = db.get_statement_cache( );
+			for( auto _ : state ) {
+				auto statement = cache.get( db, select_one_sql );
+				benchmark::DoNotOptimize( statement.get( ) );
+			}
+		}
+		BENCHMARK( statement_cache_get )->Apply( storage_args );
+
+		// Bind
+
+		constexpr char const bind_sql[] = "SELECT ?, ?, ?;";
+		constexpr std::size_t bind_bytes = 256;
+
+		void raw_bind( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			auto const text = std::string( bind_bytes, 'x' );
+			auto const blob = std::vector<std::byte>( bind_bytes );
+			sqlite3_stmt *statement = nullptr;
+			(void)sqlite3_prepare_v2( db.get_handle( ), bind_sql, -1, &statement,
+			                          nullptr );
+			for( auto _ : state ) {
+				sqlite3_bind_int64( statement, 1, 42 );
+				sqlite3_bind_text( statement, 2, text.data( ),
+				                   static_cast<int>( text.size( ) ), SQLITE_STATIC );
+				sqlite3_bind_blob( statement, 3, blob.data( ),
+				                   static_cast<int>( blob.size( ) ), SQLITE_STATIC );
+				benchmark::ClobberMemory( );
+			}
+			sqlite3_finalize( statement );
+		}
+		BENCHMARK( raw_bind )->Arg( 0 );
+
+		void bind_copy( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			auto const text = std::string( bind_bytes, 'x' );
+			auto const blob = std::vector<std::byte>( bind_bytes );
+			auto statement = shared_prepared_statement( db, bind_sql );
+			for( auto _ : state ) {
+				statement.bind_parameters(
+				  std::int64_t{ 42 }, daw::string_view( text ),
+				  types::blob_t( blob.data( ), blob.size( ) ) );
+				benchmark::ClobberMemory( );
+			}
+		}
+		BENCHMARK( bind_copy )->Arg( 0 );
+
+		void bind_zero_copy( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			auto const text = std::string( bind_bytes, 'x' );
+			auto const blob = std::vector<std::byte>( bind_bytes );
+			auto statement = shared_prepared_statement( db, bind_sql );
+			for( auto _ : state ) {
+				statement.bind( 1, cell_value( std::int64_t{ 42 } ) );
+				statement.bind( 2, daw::string_view( text ), bind_lifetime::Static );
+				statement.bind( 3, types::blob_t( blob.data( ), blob.size( ) ),
+				                bind_lifetime::Static );
+				benchmark::ClobberMemory( );
+			}
+		}
+		BENCHMARK( bind_zero_copy )->Arg( 0 );
+
+		// Step
+
+		constexpr char const scan_sql[] = "SELECT id, name, data, score FROM tbl;";
+
+		void raw_step( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, scan_rows );
+			sqlite3_stmt *statement = nullptr;
+			(void)sqlite3_prepare_v2( db.get_handle( ), scan_sql, -1, &statement,
+			                          nullptr );
+			for( auto _ : state ) {
+				std::int64_t sum = 0;
+				while( sqlite3_step( statement ) == SQLITE_ROW ) {
+					sum += sqlite3_column_int64( statement, 0 );
+					benchmark::DoNotOptimize( sqlite3_column_text( statement, 1 ) );
+				}
+				sqlite3_reset( statement );
+				benchmark::DoNotOptimize( sum );
+			}
+			sqlite3_finalize( statement );
+			state.SetItemsProcessed( state.iterations( ) * scan_rows );
+		}
+		BENCHMARK( raw_step )->Apply( storage_args );
+
+		void query_iterator_step( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, scan_rows );
+			for( auto _ : state ) {
+				std::int64_t sum = 0;
+				for( auto const &row : db.exec( scan_sql ) ) {
+					sum += row.front( ).value.get_integer( );
+				}
+				benchmark::DoNotOptimize( sum );
+			}
+			state.SetItemsProcessed( state.iterations( ) * scan_rows );
+		}
+		BENCHMARK( query_iterator_step )->Apply( storage_args );
+
+		void typed_query_step( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, scan_rows );
+			for( auto _ : state ) {
+				std::int64_t sum = 0;
+				for( auto [id, name] :
+				     db.query_as<std::tuple<std::int64_t, std::string_view>>(
+				       "SELECT id, name FROM tbl;" ) ) {
+					sum += id;
+					benchmark::DoNotOptimize( name.data( ) );
+				}
+				benchmark::DoNotOptimize( sum );
+			}
+			state.SetItemsProcessed( state.iterations( ) * scan_rows );
+		}
+		BENCHMARK( typed_query_step )->Apply( storage_args );
+
+		void column_batch_step( benchmark::State &state ) {
+			auto db = open_bench_db( state );
+			fill_table( db, scan_rows );
+			auto batch = column_batch( );
+			for( auto _ : state ) {
+				std::int64_t sum = 0;
+				auto it = db.exec( scan_sql );
+				while( it.fetch_batch( batch, 1024 ) > 0 ) {
+					for( auto id : batch[0].integers( ) ) {
+						sum += id;
+					}
+				}
+				benchmark::DoNotOptimize( sum );
+			}
+			state.SetItemsProcessed( state.iterations( ) * scan_rows );
+		}
+		BENCHMARK( column_batch_step )->Apply( storage_args );
+	} // namespace
+} // namespace daw::sqlite::bench
@@ -0,0 +1,264 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/column_traits.h"
+#include "daw/sqlite/open_options.h"
+#include "daw/sqlite/sqlite3_class.h"
+
+#include <daw/daw_move.h>
+#include <daw/daw_string_view.h>
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace daw::sqlite {
+	struct async_database_options {
+		open_options open{ };
+		/***
+		 * Runs the continuation of a coroutine awaiting the database.  When not
+		 * set it is resumed on the worker thread, which then runs it before the
+		 * next queued task
+		 */
+		std::function<void( std::coroutine_handle<> )> resume_executor{ };
+	};
+
+	namespace async_impl {
+		struct task {
+			task( ) = default;
+			task( task const & ) = delete;
+			task &operator=( task const & ) = delete;
+			virtual ~task( ) = default;
+			virtual void run( database &db ) = 0;
+		};
+
+		template<typename Operation>
+		struct task_impl final : task {
+			Operation operation;
+
+			explicit task_impl( Operation op )
+			  : operation( std::move( op ) ) {}
+
+			void run( database &db ) override {
+				operation( db );
+			}
+		};
+
+		template<typename T>
+		using result_storage_t =
+		  std::conditional_t<std::is_void_v<T>, std::monostate, std::optional<T>>;
+	} // namespace async_impl
+
+	class async_database;
+
+	/***
+	 * @brief The result of co_await on an async_database operation.  The
+	 * operation is queued when the coroutine suspends
+	 */
+	template<typename Operation>
+	class [[nodiscard]] db_awaitable {
+		using result_t = std::invoke_result_t<Operation &, database &>;
+
+		async_database *m_db;
+		Operation m_operation;
+		async_impl::result_storage_t<result_t> m_result{ };
+		std::exception_ptr m_error{ };
+
+	public:
+		db_awaitable( async_database &db, Operation operation )
+		  : m_db( &db )
+		  , m_operation( std::move( operation ) ) {}
+
+		[[nodiscard]] bool await_ready( ) const noexcept {
+			return false;
+		}
+
+		void await_suspend( std::coroutine_handle<> handle );
+
+		result_t await_resume( ) {
+			if( m_error ) {
+				std::rethrow_exception( m_error );
+			}
+			if constexpr( not std::is_void_v<result_t> ) {
+				return std::move( *m_result );
+			}
+		}
+	};
+
+	/***
+	 * @brief A database connection owned by a worker thread.  Operations are
+	 * queued and run on the worker in the order they were submitted, the
+	 * caller gets a std::future or co_awaits the result.
+	 * Parameters and sql are copied into the queued operation, but views such
+	 * as daw::string_view parameters must stay valid until it has run.  Rows
+	 * returned must own their data, e.g. std::string rather than
+	 * std::string_view columns
+	 */
+	class async_database {
+		database m_db;
+		async_database_options m_options;
+		std::mutex m_mutex{ };
+		std::condition_variable m_has_work{ };
+		std::deque<std::unique_ptr<async_impl::task>> m_queue{ };
+		bool m_stopping = false;
+		std::thread m_worker{ };
+
+		template<typename>
+		friend class ::daw::sqlite::db_awaitable;
+
+		void enqueue( std::unique_ptr<async_impl::task> t );
+		void resume( std::coroutine_handle<> handle );
+		void run( );
+
+		template<typename Operation>
+		void post( Operation operation ) {
+			enqueue( std::make_unique<async_impl::task_impl<Operation>>(
+			  std::move( operation ) ) );
+		}
+
+		template<typename... Params>
+		[[nodiscard]] static auto exec_operation( daw::string_view sql,
+		                                          Params &&...params ) {
+			return [sql = static_cast<std::string>( sql ),
+			        ... ps = std::decay_t<Params>( DAW_FWD( params ) )](
+			         database &db ) mutable {
+				for( auto const &row : db.exec( sql, ps... ) ) {
+					(void)row;
+				}
+			};
+		}
+
+		template<ResultRow Row, typename... Params>
+		[[nodiscard]] static auto query_operation( daw::string_view sql,
+		                                           Params &&...params ) {
+			return [sql = static_cast<std::string>( sql ),
+			        ... ps = std::decay_t<Params>( DAW_FWD( params ) )](
+			         database &db ) mutable {
+				auto result = std::vector<Row>( );
+				for( auto &&row : db.query_as<Row>( sql, ps... ) ) {
+					result.push_back( std::move( row ) );
+				}
+				return result;
+			};
+		}
+
+	public:
+		explicit async_database(
+		  std::filesystem::path const &filename,
+		  async_database_options options = async_database_options{ } );
+
+		async_database( async_database const & ) = delete;
+		async_database &operator=( async_database const & ) = delete;
+
+		/***
+		 * @brief Runs the operations already queued, then stops the worker
+		 */
+		~async_database( );
+
+		/***
+		 * @brief Queue operation( database & ) to run on the worker
+		 */
+		template<typename Operation>
+		[[nodiscard]] auto submit( Operation operation )
+		  -> std::future<std::invoke_result_t<Operation &, database &>> {
+			using result_t = std::invoke_result_t<Operation &, database &>;
+			auto promise = std::promise<result_t>( );
+			auto result = promise.get_future( );
+			post( [op = std::move( operation ),
+			       p = std::move( promise )]( database &db ) mutable {
+				try {
+					if constexpr( std::is_void_v<result_t> ) {
+						op( db );
+						p.set_value( );
+					} else {
+						p.set_value( op( db ) );
+					}
+				} catch( ... ) {
+					p.set_exception( std::current_exception( ) );
+				}
+			} );
+			return result;
+		}
+
+		/***
+		 * @brief co_await operation( database & ) run on the worker
+		 */
+		template<typename Operation>
+		[[nodiscard]] db_awaitable<Operation> co_submit( Operation operation ) {
+			return db_awaitable<Operation>( *this, std::move( operation ) );
+		}
+
+		/***
+		 * @brief Run sql to completion on the worker
+		 */
+		template<typename... Params>
+			requires( Parameters<Params...> ) //
+		[[nodiscard]] std::future<void> async_exec( daw::string_view sql,
+		                                            Params &&...params ) {
+			return submit( exec_operation( sql, DAW_FWD( params )... ) );
+		}
+
+		/***
+		 * @brief Run sql on the worker and decode every row into Row
+		 */
+		template<ResultRow Row, typename... Params>
+			requires( Parameters<Params...> ) //
+		[[nodiscard]] std::future<std::vector<Row>>
+		async_query( daw::string_view sql, Params &&...params ) {
+			return submit( query_operation<Row>( sql, DAW_FWD( params )... ) );
+		}
+
+		template<typename... Params>
+			requires( Parameters<Params...> ) //
+		[[nodiscard]] auto co_exec( daw::string_view sql, Params &&...params ) {
+			return co_submit( exec_operation( sql, DAW_FWD( params )... ) );
+		}
+
+		template<ResultRow Row, typename... Params>
+			requires( Parameters<Params...> ) //
+		[[nodiscard]] auto co_query( daw::string_view sql, Params &&...params ) {
+			return co_submit( query_operation<Row>( sql, DAW_FWD( params )... ) );
+		}
+
+		/***
+		 * @brief Number of operations waiting for the worker
+		 */
+		[[nodiscard]] std::size_t queued( );
+	};
+
+	template<typename Operation>
+	void db_awaitable<Operation>::await_suspend( std::coroutine_handle<> handle ) {
+		m_db->post( [this, handle]( database &db ) {
+			try {
+				if constexpr( std::is_void_v<result_t> ) {
+					m_operation( db );
+				} else {
+					m_result.emplace( m_operation( db ) );
+				}
+			} catch( ... ) {
+				m_error = std::current_exception( );
+			}
+			m_db->resume( handle );
+		} );
+	}
+} // namespace daw::sqlite
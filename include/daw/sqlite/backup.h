@@ -0,0 +1,81 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace daw::sqlite {
+	struct backup_progress {
+		std::size_t remaining_pages = 0;
+		std::size_t total_pages = 0;
+	};
+
+	/***
+	 * @brief How an online backup is stepped.  The source is only locked while
+	 * a step copies its pages, so smaller steps with a pause between them let
+	 * writers in at the cost of a longer backup.  A write to the source through
+	 * another connection restarts the copy
+	 */
+	struct backup_options {
+		/// Pages copied per sqlite3_backup_step, negative copies everything in
+		/// one step
+		int pages_per_step = 1024;
+		/// Pause between steps
+		std::chrono::milliseconds step_delay{ 0 };
+		/// Steps retried after SQLITE_BUSY or SQLITE_LOCKED before giving up
+		std::size_t max_busy_retries = 100;
+		/// Pause before retrying a busy step
+		std::chrono::milliseconds busy_delay{ 10 };
+		/// Called after every step, returning false stops the backup
+		std::function<bool( backup_progress const & )> progress{ };
+		std::string source_schema = "main";
+		std::string destination_schema = "main";
+	};
+
+	namespace backup_impl {
+		struct sqlite_free_deleter {
+			void operator( )( std::byte *ptr ) const noexcept;
+		};
+	} // namespace backup_impl
+
+	/***
+	 * @brief A database image from sqlite3_serialize, in memory from
+	 * sqlite3_malloc
+	 */
+	class serialized_image {
+		std::unique_ptr<std::byte, backup_impl::sqlite_free_deleter> m_data{ };
+		std::size_t m_size = 0;
+
+	public:
+		explicit serialized_image( ) = default;
+
+		/***
+		 * @brief Take ownership of size bytes allocated by sqlite3_malloc
+		 */
+		serialized_image( std::byte *data, std::size_t size ) noexcept;
+
+		[[nodiscard]] std::byte const *data( ) const;
+		[[nodiscard]] std::size_t size( ) const;
+		[[nodiscard]] std::span<std::byte const> bytes( ) const;
+
+		/***
+		 * @brief Give up ownership, the memory must be freed with sqlite3_free
+		 */
+		[[nodiscard]] std::byte *release( ) noexcept;
+
+		explicit operator bool( ) const {
+			return static_cast<bool>( m_data );
+		}
+	};
+} // namespace daw::sqlite
@@ -0,0 +1,55 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/prepared_statement.h"
+
+#include <cstddef>
+#include <span>
+#include <sqlite3.h>
+#include <string_view>
+
+namespace daw::sqlite::bind_impl {
+	[[nodiscard]] inline sqlite3_destructor_type
+	to_destructor( bind_lifetime lifetime ) {
+		if( lifetime == bind_lifetime::Static ) {
+			return SQLITE_STATIC;
+		}
+		return SQLITE_TRANSIENT;
+	}
+
+	/***
+	 * @brief Bind text, returning the sqlite result code.  sqlite binds a null
+	 * pointer as NULL, so an empty value is given a valid one and stays ''
+	 */
+	inline int bind_text( sqlite3_stmt *stmt, int index, std::string_view value,
+	                      bind_lifetime lifetime ) {
+		return sqlite3_bind_text64( stmt,
+		                            index,
+		                            value.empty( ) ? "" : value.data( ),
+		                            value.size( ),
+		                            to_destructor( lifetime ),
+		                            SQLITE_UTF8 );
+	}
+
+	/***
+	 * @brief Bind a blob, returning the sqlite result code.  An empty value is
+	 * bound as x'', not NULL
+	 */
+	inline int bind_blob( sqlite3_stmt *stmt, int index,
+	                      std::span<std::byte const> value,
+	                      bind_lifetime lifetime ) {
+		void const *data = value.data( );
+		if( value.empty( ) ) {
+			data = "";
+		}
+		return sqlite3_bind_blob64(
+		  stmt, index, data, value.size( ), to_destructor( lifetime ) );
+	}
+} // namespace daw::sqlite::bind_impl
@@ -0,0 +1,139 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include <daw/daw_string_view.h>
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+struct sqlite3_blob;
+
+namespace daw::sqlite {
+	class database;
+
+	enum class blob_mode { ReadOnly, ReadWrite };
+
+	namespace blob_impl {
+		struct sqlite3_blob_closer {
+			void operator( )( sqlite3_blob *ptr ) const noexcept;
+		};
+	} // namespace blob_impl
+
+	/***
+	 * @brief Incremental I/O on one blob cell with sqlite3_blob_open, so large
+	 * values are read and written in chunks instead of as one buffer.  A blob
+	 * cannot change size through the stream, insert a zeroblob of the final size
+	 * first and fill it.  When the row is changed or deleted by anything other
+	 * than the stream, further access throws with SQLITE_ABORT
+	 */
+	class blob_stream {
+		std::unique_ptr<sqlite3_blob, blob_impl::sqlite3_blob_closer> m_blob{ };
+		std::size_t m_size = 0;
+		std::size_t m_position = 0;
+
+	public:
+		static constexpr std::size_t default_chunk_size = 64U * 1024U;
+
+		explicit blob_stream( ) = default;
+
+		/***
+		 * @brief Open the blob in column of the row with rowid in table
+		 */
+		blob_stream( database &db, daw::string_view table, daw::string_view column,
+		             std::int64_t rowid, blob_mode mode = blob_mode::ReadOnly,
+		             daw::string_view schema = "main" );
+
+		/***
+		 * @brief Move to the same column of another row, much cheaper than
+		 * opening a new stream.  The position is reset to the start
+		 */
+		void reopen( std::int64_t rowid );
+
+		void close( );
+
+		[[nodiscard]] std::size_t size( ) const;
+		[[nodiscard]] std::size_t position( ) const;
+		[[nodiscard]] std::size_t remaining( ) const;
+
+		/***
+		 * @brief Set the position of the next read or write, at most size( )
+		 */
+		void seek( std::size_t position );
+
+		/***
+		 * @brief Read from the position into buffer and advance
+		 * @return The bytes read, less than the buffer at the end of the blob
+		 */
+		std::size_t read( std::span<std::byte> buffer );
+
+		/***
+		 * @brief Read exactly buffer.size( ) bytes at offset, independent of the
+		 * position
+		 */
+		void read_at( std::size_t offset, std::span<std::byte> buffer );
+
+		/***
+		 * @brief Write data at the position and advance.  Throws when it would
+		 * write past the end of the blob
+		 */
+		void write( std::span<std::byte const> data );
+
+		void write_at( std::size_t offset, std::span<std::byte const> data );
+
+		/***
+		 * @brief Read from the position to the end in chunks, calling
+		 * sink( std::span<std::byte const> ) for each
+		 */
+		template<typename Sink>
+			requires( std::invocable<Sink &, std::span<std::byte const>> ) //
+		void read_all( Sink &&sink, std::size_t chunk_size = default_chunk_size ) {
+			auto buffer = std::vector<std::byte>( chunk_size > 0 ? chunk_size : 1U );
+			while( remaining( ) > 0 ) {
+				auto const count = read( buffer );
+				sink( std::span<std::byte const>( buffer.data( ), count ) );
+			}
+		}
+
+		/***
+		 * @brief Fill the blob from the position to the end in chunks.
+		 * source( std::span<std::byte> ) fills as much of the buffer as it can
+		 * and returns the bytes written, 0 ends the stream early
+		 * @return The bytes written
+		 */
+		template<typename Source>
+			requires( std::is_invocable_r_v<std::size_t, Source &, std::span<std::byte>> ) //
+		std::size_t write_all( Source &&source,
+		                       std::size_t chunk_size = default_chunk_size ) {
+			auto buffer = std::vector<std::byte>( chunk_size > 0 ? chunk_size : 1U );
+			auto total = std::size_t{ 0 };
+			while( remaining( ) > 0 ) {
+				auto const request = std::min( buffer.size( ), remaining( ) );
+				auto const count =
+				  source( std::span<std::byte>( buffer.data( ), request ) );
+				if( count == 0 ) {
+					break;
+				}
+				write( std::span<std::byte const>( buffer.data( ), std::min( count, request ) ) );
+				total += std::min( count, request );
+			}
+			return total;
+		}
+
+		explicit operator bool( ) const {
+			return static_cast<bool>( m_blob );
+		}
+	};
+} // namespace daw::sqlite
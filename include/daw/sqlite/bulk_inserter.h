@@ -0,0 +1,210 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/parameter_traits.h"
+#include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/transaction.h"
+
+#include <daw/daw_string_view.h>
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace daw::sqlite {
+	struct bulk_insert_options {
+		/// Commit after this many rows
+		std::size_t rows_per_transaction = 10'000;
+		/// Commit after roughly this many bytes of bound values
+		std::size_t bytes_per_transaction = 64U * 1024U * 1024U;
+		/// Rows per INSERT statement when inserting a range.  0 means as many as
+		/// SQLITE_LIMIT_VARIABLE_NUMBER allows
+		std::size_t rows_per_statement = 1;
+	};
+
+	namespace bulk_impl {
+		/***
+		 * @brief The part of bulk_inserter that does not depend on the row type
+		 */
+		class bulk_insert_state {
+			database *m_db;
+			std::string m_table;
+			std::vector<std::string> m_columns;
+			std::size_t m_column_count;
+			bulk_insert_options m_options;
+			shared_prepared_statement m_single{ };
+			shared_prepared_statement m_multi{ };
+			std::size_t m_rows_per_statement = 1;
+			bool m_owns_transaction;
+			std::optional<transaction> m_transaction{ };
+			std::size_t m_pending_rows = 0;
+			std::size_t m_pending_bytes = 0;
+			std::size_t m_total_rows = 0;
+
+			[[nodiscard]] std::string insert_sql( std::size_t row_count ) const;
+			void begin( );
+
+		public:
+			bulk_insert_state( database &db, daw::string_view table,
+			                   std::vector<std::string> columns,
+			                   std::size_t column_count,
+			                   bulk_insert_options const &options );
+
+			bulk_insert_state( bulk_insert_state const & ) = delete;
+			bulk_insert_state &operator=( bulk_insert_state const & ) = delete;
+
+			[[nodiscard]] std::size_t column_count( ) const;
+			[[nodiscard]] std::size_t rows_per_statement( ) const;
+
+			/***
+			 * @brief The statement inserting one row, or rows_per_statement( ) rows.
+			 * A transaction is started if needed
+			 */
+			[[nodiscard]] sqlite3_stmt *single_statement( );
+			[[nodiscard]] sqlite3_stmt *multi_statement( );
+
+			/***
+			 * @brief Run the bound statement and commit when a limit is reached
+			 */
+			void execute( sqlite3_stmt *statement, std::size_t row_count,
+			              std::size_t byte_count );
+
+			void commit( );
+			void rollback( ) noexcept;
+			[[nodiscard]] std::size_t rows_inserted( ) const;
+		};
+	} // namespace bulk_impl
+
+	/***
+	 * @brief Insert many rows through one reused prepared INSERT, binding the
+	 * values without copying them.  Unless a transaction is already open, the
+	 * rows are grouped into explicit transactions that are committed every
+	 * rows_per_transaction rows or bytes_per_transaction bytes.  finish( )
+	 * commits the last transaction, rows it has not committed are rolled back on
+	 * destruction.  Transactions already committed are not undone.  The
+	 * bindings are cleared after each row, the statement does not keep pointers
+	 * into the caller's rows
+	 * @tparam Row a std::tuple or a class with a row_contract providing to_tuple
+	 */
+	template<ParameterRow Row>
+	class bulk_inserter {
+		bulk_impl::bulk_insert_state m_state;
+
+		static constexpr std::size_t row_column_count = std::tuple_size_v<
+			std::remove_cvref_t<decltype( row_parameters( std::declval<Row const &>( ) ) )>>;
+
+	public:
+		/***
+		 * @param columns The columns of table to insert into, in the order of the
+		 * row members.  When empty all columns of the table are used
+		 */
+		bulk_inserter( database &db, daw::string_view table,
+		               std::vector<std::string> columns = { },
+		               bulk_insert_options const &options = { } )
+		  : m_state( db, table, std::move( columns ), row_column_count, options ) {}
+
+		bulk_inserter( bulk_inserter const & ) = delete;
+		bulk_inserter &operator=( bulk_inserter const & ) = delete;
+
+		~bulk_inserter( ) {
+			m_state.rollback( );
+		}
+
+		void insert( Row const &row ) {
+			auto *statement = m_state.single_statement( );
+			auto const bytes = bind_row( statement, 1, row, bind_lifetime::Static );
+			m_state.execute( statement, 1, bytes );
+		}
+
+		/***
+		 * @brief Insert each row of rows.  Forward ranges are inserted
+		 * rows_per_statement rows at a time with a multi row VALUES list
+		 */
+		template<std::ranges::input_range Rows>
+			requires( std::convertible_to<std::ranges::range_reference_t<Rows>,
+			                              Row const &> ) //
+		void insert( Rows &&rows ) {
+			auto first = std::ranges::begin( rows );
+			auto const last = std::ranges::end( rows );
+			if constexpr( std::ranges::forward_range<Rows> ) {
+				auto const per_statement = m_state.rows_per_statement( );
+				if( per_statement > 1 ) {
+					auto remaining =
+						static_cast<std::size_t>( std::ranges::distance( first, last ) );
+					while( remaining >= per_statement ) {
+						auto *statement = m_state.multi_statement( );
+						std::size_t bytes = 0;
+						int index = 1;
+						for( std::size_t n = 0; n < per_statement; ++n, ++first ) {
+							bytes += bind_row( statement,
+							                   index,
+							                   static_cast<Row const &>( *first ),
+							                   bind_lifetime::Static );
+							index += static_cast<int>( row_column_count );
+						}
+						m_state.execute( statement, per_statement, bytes );
+						remaining -= per_statement;
+					}
+				}
+			}
+			for( ; first != last; ++first ) {
+				insert( static_cast<Row const &>( *first ) );
+			}
+		}
+
+		/***
+		 * @brief Commit the rows inserted so far
+		 */
+		void commit( ) {
+			m_state.commit( );
+		}
+
+		/***
+		 * @brief Commit the remaining rows.  Without it they are rolled back when
+		 * the inserter is destroyed
+		 * @return The number of rows inserted
+		 */
+		std::size_t finish( ) {
+			m_state.commit( );
+			return m_state.rows_inserted( );
+		}
+
+		/***
+		 * @brief Roll back the rows inserted since the last commit
+		 */
+		void rollback( ) {
+			m_state.rollback( );
+		}
+
+		[[nodiscard]] std::size_t rows_inserted( ) const {
+			return m_state.rows_inserted( );
+		}
+	};
+
+	/***
+	 * @brief Insert all of rows into table using a bulk_inserter
+	 * @return The number of rows inserted
+	 */
+	template<std::ranges::input_range Rows>
+	std::size_t bulk_insert( database &db, daw::string_view table,
+	                         std::vector<std::string> columns, Rows &&rows,
+	                         bulk_insert_options const &options = { } ) {
+		using row_t = std::remove_cvref_t<std::ranges::range_reference_t<Rows>>;
+		auto inserter =
+			bulk_inserter<row_t>( db, table, std::move( columns ), options );
+		inserter.insert( DAW_FWD( rows ) );
+		return inserter.finish( );
+	}
+} // namespace daw::sqlite
@@ -0,0 +1,103 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+struct sqlite3_stmt;
+
+namespace daw::sqlite {
+	/***
+	 * @brief Exponential backoff with jitter.  Wait n is
+	 * min( initial_delay * multiplier^n, max_delay ), of which the jitter
+	 * fraction is randomized so that competing connections spread out
+	 */
+	struct busy_backoff {
+		std::chrono::microseconds initial_delay{ 100 };
+		std::chrono::microseconds max_delay{ 20'000 };
+		double multiplier = 2.0;
+		/// 0 waits the full delay, 1 waits a random time up to it
+		double jitter = 0.5;
+	};
+
+	/***
+	 * @brief What a connection does when the database is locked by another
+	 * connection
+	 */
+	struct busy_policy {
+		/// Longest time to wait for a lock before SQLITE_BUSY is returned.  0
+		/// returns it immediately
+		std::chrono::milliseconds timeout{ 0 };
+		/// When set a busy handler waits with backoff until timeout, instead of
+		/// sqlite3_busy_timeout's fixed schedule
+		std::optional<busy_backoff> backoff{ };
+		/// Times the first step of a statement is reset and retried after it
+		/// fails with SQLITE_BUSY or SQLITE_LOCKED.  Only done outside of an
+		/// explicit transaction, where retrying a single statement is safe
+		std::size_t step_retries = 0;
+	};
+
+	struct busy_stats {
+		/// Calls of the backoff busy handler
+		std::size_t handler_calls = 0;
+		/// Time slept by the backoff busy handler and step retries
+		std::chrono::microseconds waited{ 0 };
+		/// Initial steps retried
+		std::size_t step_retries = 0;
+		/// SQLITE_BUSY or SQLITE_LOCKED errors thrown after waiting and retrying
+		std::size_t busy_errors = 0;
+	};
+
+	namespace busy_impl {
+		/***
+		 * @brief Shared by a connection and its statements, so the busy handler
+		 * and step retries see the current policy and update one set of counters
+		 */
+		struct busy_state {
+			busy_policy policy{ };
+			// Only touched by the thread using the connection
+			std::chrono::steady_clock::time_point wait_start{ };
+			std::atomic<std::size_t> handler_calls = 0;
+			std::atomic<std::int64_t> waited_us = 0;
+			std::atomic<std::size_t> step_retries = 0;
+			std::atomic<std::size_t> busy_errors = 0;
+
+			[[nodiscard]] busy_stats stats( ) const;
+			void reset_stats( );
+		};
+
+		/***
+		 * @brief SQLITE_BUSY or SQLITE_LOCKED, including extended codes
+		 */
+		[[nodiscard]] bool is_busy_code( int rc ) noexcept;
+
+		/***
+		 * @brief The sqlite3_busy_handler callback, arg is a busy_state
+		 */
+		int backoff_handler( void *arg, int count ) noexcept;
+
+		/***
+		 * @brief Called when the first step of statement failed with rc.  Retries
+		 * the step while it is busy, as the policy allows, and returns the final
+		 * result code
+		 */
+		[[nodiscard]] int retry_initial_step( sqlite3_stmt *statement, int rc,
+		                                      busy_state &state );
+
+		/***
+		 * @brief sqlite3_step, with the initial step retried and busy errors
+		 * counted when state is not null
+		 */
+		[[nodiscard]] int step( sqlite3_stmt *statement, busy_state *state );
+	} // namespace busy_impl
+} // namespace daw::sqlite
@@ -0,0 +1,178 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/kv_lru_cache.h"
+#include "daw/sqlite/kv_store.h"
+
+#include <daw/daw_string_view.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace daw::db {
+	struct cached_kv_store_options {
+		/// Number of independently locked cache shards
+		std::size_t shard_count = 16;
+		/// Byte budget of the cache, split evenly between the shards
+		std::size_t cache_bytes = 64U * 1024U * 1024U;
+		/// Buffered writes that trigger a flush from the writing thread
+		std::size_t max_pending_writes = 4096;
+		/// Buffered bytes that trigger a flush from the writing thread
+		std::size_t max_pending_bytes = 16U * 1024U * 1024U;
+		/// Period of the background flush, 0 disables it
+		std::chrono::milliseconds flush_interval = std::chrono::milliseconds( 100 );
+		/// The underlying store, its own read cache is not used
+		kv_store_options store{ };
+	};
+
+	struct cached_kv_store_stats {
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+		std::size_t evictions = 0;
+		std::size_t flushes = 0;
+		std::size_t flushed_writes = 0;
+		std::size_t failed_flushes = 0;
+	};
+
+	/***
+	 * @brief A thread safe kv_store with a sharded in memory LRU in front of it.
+	 * Each shard has its own lock so lookups of different keys rarely contend.
+	 * Writes go to the cache and a write buffer, and the buffer is written in
+	 * one transaction when it reaches a size threshold, periodically from a
+	 * background thread, or when flush( ) is called.  Reads see buffered writes.
+	 * Buffered writes are lost if the process ends before they are flushed
+	 */
+	class cached_kv_store {
+		struct shard {
+			std::mutex mutex{ };
+			lru_cache cache{ };
+			// Changed by every write to the shard.  A read that missed only caches
+			// what it loaded when no write happened meanwhile
+			std::uint64_t generation = 0;
+		};
+
+		cached_kv_store_options m_options;
+		// Held while reading from or writing to m_store
+		std::mutex m_store_mutex{ };
+		kv_store m_store;
+		std::unique_ptr<shard[]> m_shards;
+
+		// The latest unflushed write of each key, nullopt is an erase
+		std::mutex m_pending_mutex{ };
+		struct key_hash {
+			using is_transparent = void;
+
+			[[nodiscard]] std::size_t operator( )( std::string_view key ) const {
+				return std::hash<std::string_view>{ }( key );
+			}
+		};
+		using pending_map_t = std::unordered_map<std::string,
+		                                         std::optional<std::string>,
+		                                         key_hash,
+		                                         std::equal_to<>>;
+		pending_map_t m_pending{ };
+		std::size_t m_pending_bytes = 0;
+		std::size_t m_flushes = 0;
+		std::size_t m_flushed_writes = 0;
+		std::size_t m_failed_flushes = 0;
+		// The last failure of a flush not started by flush( ), thrown by the
+		// next flush or write
+		std::exception_ptr m_flush_error{ };
+
+		std::condition_variable m_flush_wake{ };
+		bool m_stopping = false;
+		std::thread m_flusher{ };
+
+		[[nodiscard]] shard &shard_for( std::string_view key ) const;
+		void write( std::string const &key, std::optional<std::string> const &value );
+		void flush_pending( );
+		void flush_loop( );
+
+	public:
+		explicit cached_kv_store(
+		  std::filesystem::path const &filename,
+		  cached_kv_store_options const &options = cached_kv_store_options{ } );
+
+		cached_kv_store( cached_kv_store const & ) = delete;
+		cached_kv_store &operator=( cached_kv_store const & ) = delete;
+
+		/***
+		 * @brief Stops the background flush and flushes the buffered writes.
+		 * Errors are discarded, call flush( ) first to observe them
+		 */
+		~cached_kv_store( );
+
+		[[nodiscard]] std::optional<std::string>
+		get_encoded( daw::string_view key );
+		void put_encoded( daw::string_view key, daw::string_view value );
+		void erase_encoded( daw::string_view key );
+
+		template<KVDecodable Value = std::string, KVEncodable Key>
+		[[nodiscard]] std::optional<Value> get( Key const &key ) {
+			auto bytes = get_encoded( kv_encode( key ) );
+			if( not bytes ) {
+				return std::nullopt;
+			}
+			if constexpr( std::same_as<Value, std::string> ) {
+				return bytes;
+			} else {
+				return kv_codec<Value>::decode( *bytes );
+			}
+		}
+
+		/***
+		 * @brief Buffer the write and update the cache.  When the write fills the
+		 * buffer it is flushed, and a failure of that flush is kept for the next
+		 * flush or write.  A throw, e.g. of such an earlier failure, means the
+		 * write was not made
+		 */
+		template<KVEncodable Key, KVEncodable Value>
+		void put( Key const &key, Value const &value ) {
+			put_encoded( kv_encode( key ), kv_encode( value ) );
+		}
+
+		/***
+		 * @brief Buffer the removal of key, the same way as put
+		 */
+		template<KVEncodable Key>
+		void erase( Key const &key ) {
+			erase_encoded( kv_encode( key ) );
+		}
+
+		template<KVEncodable Key>
+		[[nodiscard]] bool contains( Key const &key ) {
+			return get_encoded( kv_encode( key ) ).has_value( );
+		}
+
+		/***
+		 * @brief Write the buffered writes in one transaction.  On failure they
+		 * stay buffered and the error is rethrown.  A failure of the background
+		 * flush, or of one started by a write filling the buffer, is thrown by
+		 * the next flush or write instead, which then does nothing else
+		 */
+		void flush( );
+
+		[[nodiscard]] std::size_t pending_writes( );
+		[[nodiscard]] cached_kv_store_stats stats( );
+		void reset_stats( );
+	};
+} // namespace daw::db
@@ -13,6 +13,7 @@
 #include <daw/daw_contiguous_view.h>
 #include <daw/daw_string_view.h>
 
+#include <concepts>
 #include <cstdint>
 #include <iostream>
 #include <string>
@@ -31,6 +32,7 @@ namespace daw::sqlite {
 
 	class prepared_statement;
 	class shared_prepared_statement;
+	class row_cursor;
 
 	struct cell_value {
 		struct null_cell_t {};
@@ -41,11 +43,23 @@ namespace daw::sqlite {
 	private:
 		value_t m_value = null_cell_t{};
 
+		template<std::integral Integer>
+		[[nodiscard]] static constexpr types::integer_t
+		to_integer( Integer value ) {
+			if( not std::in_range<types::integer_t>( value ) ) {
+				throw sqlite3_exception(
+					"Integer is out of the range of a 64 bit signed integer" );
+			}
+			return static_cast<types::integer_t>( value );
+		}
+
 	public:
 		explicit cell_value( ) = default;
 
 		explicit cell_value( prepared_statement &statement, size_t column );
 		explicit cell_value( shared_prepared_statement &statement, size_t column );
+		// The column is only checked with assert in debug builds
+		explicit cell_value( row_cursor const &cursor, size_t column ) noexcept;
 
 
 		template<std::same_as<bool> Bool>
@@ -58,6 +72,15 @@ namespace daw::sqlite {
 		explicit constexpr cell_value( types::integer_t value )
 			: m_value{std::in_place_type<types::integer_t>, value} {}
 
+		// Other integer types, e.g. an int literal, would otherwise convert to
+		// both integer_t and real_t.  Unsigned values above INT64_MAX throw
+		// rather than wrap around
+		template<std::integral Integer>
+			requires( not std::same_as<Integer, bool> ) //
+		explicit constexpr cell_value( Integer value )
+			: m_value{std::in_place_type<types::integer_t>,
+			          to_integer( value )} {}
+
 		explicit constexpr cell_value( types::text_t value )
 			: m_value{std::in_place_type<types::text_t>, value} {}
 
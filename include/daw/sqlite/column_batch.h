@@ -0,0 +1,202 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/cell_value.h"
+
+#include <daw/daw_string_view.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace daw::sqlite {
+	class row_cursor;
+	struct query_iterator;
+	class column_batch;
+
+	/***
+	 * @brief One column of a column_batch stored contiguously.  The column type
+	 * is taken from the first non null value, Integer and Float values are
+	 * mixed by widening the column to Float.  Any other mismatch throws.  Null
+	 * rows are flagged in the null bitmap and hold 0, or an empty range of the
+	 * arena, so the value arrays always have size( ) elements
+	 */
+	class batch_column {
+		std::string m_name{ };
+		column_type m_type = column_type::Null;
+		std::size_t m_size = 0;
+		std::size_t m_null_count = 0;
+		std::vector<std::int64_t> m_integers{ };
+		std::vector<double> m_floats{ };
+		// Bit n % 64 of word n / 64 is set when row n is null
+		std::vector<std::uint64_t> m_nulls{ };
+		// Text and blob values are stored back to back, row n is
+		// [m_offsets[n], m_offsets[n + 1])
+		std::vector<char> m_arena{ };
+		std::vector<std::size_t> m_offsets{ };
+
+		friend class ::daw::sqlite::column_batch;
+
+		void set_type( column_type type );
+		void start_row( );
+		void append_null( );
+		void append_integer( std::int64_t value );
+		void append_float( double value );
+		void append_bytes( char const *data, std::size_t size, column_type type );
+		void clear( );
+
+	public:
+		explicit batch_column( ) = default;
+
+		[[nodiscard]] daw::string_view name( ) const {
+			return m_name;
+		}
+
+		/***
+		 * @brief The type of the stored values, Null when every row is null
+		 */
+		[[nodiscard]] column_type type( ) const {
+			return m_type;
+		}
+
+		[[nodiscard]] std::size_t size( ) const {
+			return m_size;
+		}
+
+		[[nodiscard]] std::size_t null_count( ) const {
+			return m_null_count;
+		}
+
+		[[nodiscard]] bool is_null( std::size_t row ) const {
+			assert( row < m_size );
+			return ( ( m_nulls[row / 64U] >> ( row % 64U ) ) & 1U ) != 0;
+		}
+
+		/***
+		 * @brief One bit per row, set when the row is null.  Has
+		 * ( size( ) + 63 ) / 64 words
+		 */
+		[[nodiscard]] std::span<std::uint64_t const> null_bitmap( ) const {
+			return m_nulls;
+		}
+
+		/***
+		 * @brief The values of an Integer column, empty for other types
+		 */
+		[[nodiscard]] std::span<std::int64_t const> integers( ) const {
+			return m_integers;
+		}
+
+		/***
+		 * @brief The values of a Float column, empty for other types
+		 */
+		[[nodiscard]] std::span<double const> floats( ) const {
+			return m_floats;
+		}
+
+		/***
+		 * @brief The bytes of every Text or Blob value, indexed by offsets( )
+		 */
+		[[nodiscard]] std::span<char const> arena( ) const {
+			return m_arena;
+		}
+
+		/***
+		 * @brief size( ) + 1 offsets into arena( ) for Text or Blob columns, empty
+		 * for other types
+		 */
+		[[nodiscard]] std::span<std::size_t const> offsets( ) const {
+			return m_offsets;
+		}
+
+		[[nodiscard]] types::text_t text( std::size_t row ) const {
+			assert( row < m_size and not m_offsets.empty( ) );
+			return types::text_t( m_arena.data( ) + m_offsets[row],
+			                      m_offsets[row + 1] - m_offsets[row] );
+		}
+
+		[[nodiscard]] types::blob_t blob( std::size_t row ) const {
+			assert( row < m_size and not m_offsets.empty( ) );
+			return types::blob_t(
+			  reinterpret_cast<std::byte const *>( m_arena.data( ) ) +
+			    m_offsets[row],
+			  m_offsets[row + 1] - m_offsets[row] );
+		}
+	};
+
+	/***
+	 * @brief A block of rows stored column by column, filled by
+	 * query_iterator::fetch_batch.  Reusing a batch for later fetches keeps its
+	 * allocations
+	 */
+	class column_batch {
+		std::vector<batch_column> m_columns{ };
+		std::size_t m_size = 0;
+
+		friend struct ::daw::sqlite::query_iterator;
+
+		void reset_columns( std::size_t column_count );
+		void set_column_name( std::size_t column, daw::string_view name );
+		void append_row( row_cursor const &cursor );
+		void append_row( cell_value const *cells );
+
+	public:
+		explicit column_batch( ) = default;
+
+		/***
+		 * @brief Number of rows
+		 */
+		[[nodiscard]] std::size_t size( ) const {
+			return m_size;
+		}
+
+		[[nodiscard]] bool empty( ) const {
+			return m_size == 0;
+		}
+
+		[[nodiscard]] std::size_t column_count( ) const {
+			return m_columns.size( );
+		}
+
+		[[nodiscard]] batch_column const &operator[]( std::size_t column ) const {
+			return m_columns[column];
+		}
+
+		[[nodiscard]] std::optional<std::size_t>
+		get_index_of( daw::string_view name ) const;
+
+		/***
+		 * @brief The column with name, throws when there is none
+		 */
+		[[nodiscard]] batch_column const &column( daw::string_view name ) const;
+
+		[[nodiscard]] batch_column const &
+		operator[]( daw::string_view name ) const {
+			return column( name );
+		}
+
+		[[nodiscard]] auto begin( ) const {
+			return m_columns.begin( );
+		}
+
+		[[nodiscard]] auto end( ) const {
+			return m_columns.end( );
+		}
+
+		/***
+		 * @brief Remove every row, keeping the columns and their allocated storage
+		 */
+		void clear( );
+	};
+} // namespace daw::sqlite
@@ -0,0 +1,80 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include <daw/daw_string_view.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace daw::sqlite {
+	class row_cursor;
+
+	/***
+	 * @brief The column names of a result set with a flat open addressing hash
+	 * index over them.  Built once per query and shared by its rows.  When
+	 * names repeat, lookup finds the first column with the name
+	 */
+	class column_metadata {
+		std::vector<std::string> m_names{ };
+		std::vector<std::size_t> m_hashes{ };
+		// Power of two sized, each slot is a column index + 1 or 0 when empty
+		std::vector<std::uint32_t> m_slots{ };
+
+		[[nodiscard]] static constexpr std::size_t
+		hash( daw::string_view name ) noexcept {
+			// FNV-1a
+			auto result = std::size_t{ 14695981039346656037ULL };
+			for( char c : name ) {
+				result ^= static_cast<unsigned char>( c );
+				result *= std::size_t{ 1099511628211ULL };
+			}
+			return result;
+		}
+
+		void build_index( );
+
+	public:
+		explicit column_metadata( ) = default;
+		explicit column_metadata( std::vector<std::string> names );
+		explicit column_metadata( row_cursor const &cursor );
+
+		[[nodiscard]] std::size_t size( ) const noexcept {
+			return m_names.size( );
+		}
+
+		[[nodiscard]] daw::string_view name( std::size_t column ) const noexcept {
+			assert( column < m_names.size( ) );
+			return m_names[column];
+		}
+
+		[[nodiscard]] std::optional<std::size_t>
+		get_index_of( daw::string_view name ) const noexcept {
+			if( m_slots.empty( ) ) {
+				return std::nullopt;
+			}
+			auto const h = hash( name );
+			auto const mask = m_slots.size( ) - 1U;
+			for( auto pos = h & mask;; pos = ( pos + 1U ) & mask ) {
+				auto const slot = m_slots[pos];
+				if( slot == 0 ) {
+					return std::nullopt;
+				}
+				auto const column = static_cast<std::size_t>( slot - 1U );
+				if( m_hashes[column] == h and name == daw::string_view( m_names[column] ) ) {
+					return column;
+				}
+			}
+		}
+	};
+} // namespace daw::sqlite
@@ -0,0 +1,273 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/cell_value.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <daw/daw_string_view.h>
+
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <sqlite3.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace daw::sqlite {
+	/***
+	 * @brief Describes how to read a C++ type from a result column.
+	 * Specializations provide
+	 * 	static constexpr bool accepts( int sqlite_type ) - is the fundamental type
+	 * 		returned by sqlite3_column_type usable for this type
+	 * 	static T get( sqlite3_stmt *, int column ) - decode the column of the
+	 * 		current row
+	 */
+	template<typename T>
+	struct column_traits;
+
+	template<std::integral T>
+		requires( not std::same_as<T, bool> ) //
+	struct column_traits<T> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_INTEGER;
+		}
+
+		static T get( sqlite3_stmt *stmt, int column ) {
+			return static_cast<T>( sqlite3_column_int64( stmt, column ) );
+		}
+	};
+
+	template<>
+	struct column_traits<bool> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_INTEGER;
+		}
+
+		static bool get( sqlite3_stmt *stmt, int column ) {
+			return sqlite3_column_int64( stmt, column ) != 0;
+		}
+	};
+
+	template<std::floating_point T>
+	struct column_traits<T> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_FLOAT or sqlite_type == SQLITE_INTEGER;
+		}
+
+		static T get( sqlite3_stmt *stmt, int column ) {
+			return static_cast<T>( sqlite3_column_double( stmt, column ) );
+		}
+	};
+
+	// The views into text and blobs are only valid until the next step
+	template<>
+	struct column_traits<std::string_view> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_TEXT;
+		}
+
+		static std::string_view get( sqlite3_stmt *stmt, int column ) {
+			// sqlite3_column_text must be called before sqlite3_column_bytes
+			auto const *first =
+				reinterpret_cast<char const *>( sqlite3_column_text( stmt, column ) );
+			return std::string_view(
+				first,
+				static_cast<std::size_t>( sqlite3_column_bytes( stmt, column ) ) );
+		}
+	};
+
+	template<>
+	struct column_traits<types::text_t> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return column_traits<std::string_view>::accepts( sqlite_type );
+		}
+
+		static types::text_t get( sqlite3_stmt *stmt, int column ) {
+			auto const sv = column_traits<std::string_view>::get( stmt, column );
+			return types::text_t( sv.data( ), sv.size( ) );
+		}
+	};
+
+	template<>
+	struct column_traits<std::string> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return column_traits<std::string_view>::accepts( sqlite_type );
+		}
+
+		static std::string get( sqlite3_stmt *stmt, int column ) {
+			return std::string( column_traits<std::string_view>::get( stmt, column ) );
+		}
+	};
+
+	template<>
+	struct column_traits<types::blob_t> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_BLOB;
+		}
+
+		static types::blob_t get( sqlite3_stmt *stmt, int column ) {
+			// sqlite3_column_blob must be called before sqlite3_column_bytes
+			auto const *first =
+				static_cast<std::byte const *>( sqlite3_column_blob( stmt, column ) );
+			return types::blob_t(
+				first,
+				static_cast<std::size_t>( sqlite3_column_bytes( stmt, column ) ) );
+		}
+	};
+
+	template<>
+	struct column_traits<std::vector<std::byte>> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return column_traits<types::blob_t>::accepts( sqlite_type );
+		}
+
+		static std::vector<std::byte> get( sqlite3_stmt *stmt, int column ) {
+			auto const blob = column_traits<types::blob_t>::get( stmt, column );
+			return std::vector<std::byte>( blob.begin( ), blob.end( ) );
+		}
+	};
+
+	template<typename T>
+	struct column_traits<std::optional<T>> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_NULL or
+			       column_traits<T>::accepts( sqlite_type );
+		}
+
+		static std::optional<T> get( sqlite3_stmt *stmt, int column ) {
+			if( sqlite3_column_type( stmt, column ) == SQLITE_NULL ) {
+				return std::nullopt;
+			}
+			return column_traits<T>::get( stmt, column );
+		}
+	};
+
+	template<typename T>
+	concept Column = requires( sqlite3_stmt *stmt, int column ) {
+		{ column_traits<T>::accepts( SQLITE_NULL ) } -> std::same_as<bool>;
+		{ column_traits<T>::get( stmt, column ) } -> std::convertible_to<T>;
+	};
+
+	/***
+	 * @brief Specialize to map result rows onto a class.  The specialization
+	 * provides
+	 * 	using types = std::tuple<ColumnTypes...>; - the type of each column
+	 * The class is brace initialized from the columns in order.  To write the
+	 * class as parameters, e.g. with bulk_inserter, it also provides
+	 * 	static auto to_tuple( T const & ) - the members in column order, usually
+	 * 		via std::forward_as_tuple
+	 */
+	template<typename T>
+	struct row_contract;
+
+	namespace column_impl {
+		template<typename>
+		inline constexpr bool is_tuple_v = false;
+
+		template<typename... Ts>
+		inline constexpr bool is_tuple_v<std::tuple<Ts...>> = true;
+	} // namespace column_impl
+
+	/***
+	 * @brief The column types of a row, and how to construct the row from them.
+	 * A Row can be a std::tuple of Column types, a class with a row_contract,
+	 * or a single Column type for single column results
+	 */
+	template<typename Row>
+	struct row_traits;
+
+	template<Column... Ts>
+	struct row_traits<std::tuple<Ts...>> {
+		using types = std::tuple<Ts...>;
+
+		template<typename... Args>
+		static std::tuple<Ts...> construct( Args &&...args ) {
+			return std::tuple<Ts...>{ DAW_FWD( args )... };
+		}
+	};
+
+	template<typename Row>
+		requires( requires { typename row_contract<Row>::types; } ) //
+	struct row_traits<Row> {
+		using types = typename row_contract<Row>::types;
+
+		template<typename... Args>
+		static Row construct( Args &&...args ) {
+			return Row{ DAW_FWD( args )... };
+		}
+	};
+
+	template<Column T>
+		requires( not column_impl::is_tuple_v<T> ) //
+	struct row_traits<T> {
+		using types = std::tuple<T>;
+
+		static T construct( T value ) {
+			return value;
+		}
+	};
+
+	template<typename T>
+	concept ResultRow = requires { typename row_traits<T>::types; };
+
+	template<ResultRow R>
+	inline constexpr std::size_t row_size_v =
+		std::tuple_size_v<typename row_traits<R>::types>;
+
+	/***
+	 * @brief Throw if the result of stmt does not have the number of columns R
+	 * needs
+	 */
+	template<ResultRow R>
+	void validate_column_count( sqlite3_stmt *stmt ) {
+		if( static_cast<std::size_t>( sqlite3_column_count( stmt ) ) !=
+		    row_size_v<R> ) {
+			throw sqlite3_exception(
+				"Column count of result does not match the requested row type" );
+		}
+	}
+
+	/***
+	 * @brief Throw if the types of the current row cannot be decoded as R
+	 */
+	template<ResultRow R>
+	void validate_column_types( sqlite3_stmt *stmt ) {
+		using types = typename row_traits<R>::types;
+		[&]<std::size_t... Is>( std::index_sequence<Is...> ) {
+			bool const valid =
+				( column_traits<std::tuple_element_t<Is, types>>::accepts(
+						sqlite3_column_type( stmt, static_cast<int>( Is ) ) ) and
+				  ... );
+			if( not valid ) {
+				throw sqlite3_exception(
+					"Column types of result do not match the requested row type" );
+			}
+		}( std::make_index_sequence<row_size_v<R>>{ } );
+	}
+
+	/***
+	 * @brief Decode the current row of stmt directly from the sqlite3_column_*
+	 * functions
+	 */
+	template<ResultRow R>
+	[[nodiscard]] R decode_row( sqlite3_stmt *stmt ) {
+		using types = typename row_traits<R>::types;
+		return [&]<std::size_t... Is>( std::index_sequence<Is...> ) {
+			return row_traits<R>::construct(
+				column_traits<std::tuple_element_t<Is, types>>::get(
+					stmt,
+					static_cast<int>( Is ) )... );
+		}( std::make_index_sequence<row_size_v<R>>{ } );
+	}
+} // namespace daw::sqlite
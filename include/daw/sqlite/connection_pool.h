@@ -0,0 +1,112 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/open_options.h"
+#include "daw/sqlite/sqlite3_class.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace daw::sqlite {
+	struct connection_pool_options {
+		/// Number of read only connections.  0 uses the hardware concurrency
+		std::size_t reader_count = 0;
+		/// Options for the read only connections, read_only is always set
+		open_options reader_options = open_options::read_heavy( );
+		/// Options for the writer, the journal mode is always WAL
+		open_options writer_options = open_options::read_heavy( );
+	};
+
+	class connection_pool;
+
+	/***
+	 * @brief Exclusive use of a pooled connection, returned to the pool on
+	 * destruction
+	 */
+	class connection_lease {
+		connection_pool *m_pool = nullptr;
+		database *m_db = nullptr;
+		bool m_is_writer = false;
+
+		friend class ::daw::sqlite::connection_pool;
+		connection_lease( connection_pool &pool, database &db, bool is_writer );
+
+	public:
+		connection_lease( connection_lease &&other ) noexcept;
+		connection_lease &operator=( connection_lease &&rhs ) noexcept;
+		connection_lease( connection_lease const & ) = delete;
+		connection_lease &operator=( connection_lease const & ) = delete;
+		~connection_lease( );
+
+		/***
+		 * @brief Return the connection to the pool early
+		 */
+		void release( );
+
+		[[nodiscard]] database &get( ) const;
+		[[nodiscard]] database &operator*( ) const;
+		[[nodiscard]] database *operator->( ) const;
+		[[nodiscard]] bool is_writer( ) const;
+
+		explicit operator bool( ) const {
+			return m_db != nullptr;
+		}
+	};
+
+	/***
+	 * @brief A fixed set of read only connections and one writer connection to a
+	 * WAL database.  Readers are leased to one thread at a time and can run in
+	 * parallel, the writer lease serializes writes.  Each connection keeps its
+	 * own statement cache.  When a lease ends, statements still running on its
+	 * connection are reset and an open transaction is rolled back.  The pool
+	 * must outlive its leases
+	 */
+	class connection_pool {
+		database m_writer{ };
+		std::vector<database> m_readers{ };
+		std::vector<database *> m_idle_readers{ };
+		bool m_writer_in_use = false;
+		std::mutex m_mutex{ };
+		std::condition_variable m_reader_released{ };
+		std::condition_variable m_writer_released{ };
+
+		friend class ::daw::sqlite::connection_lease;
+		void release( database &db, bool is_writer );
+
+	public:
+		explicit connection_pool(
+		  std::filesystem::path const &filename,
+		  connection_pool_options const &options = connection_pool_options{ } );
+
+		connection_pool( connection_pool const & ) = delete;
+		connection_pool &operator=( connection_pool const & ) = delete;
+
+		/***
+		 * @brief Lease a read only connection, waiting for one to be available
+		 */
+		[[nodiscard]] connection_lease acquire_reader( );
+		[[nodiscard]] std::optional<connection_lease>
+		try_acquire_reader( std::chrono::milliseconds timeout );
+
+		/***
+		 * @brief Lease the writer connection, waiting until it is available
+		 */
+		[[nodiscard]] connection_lease acquire_writer( );
+		[[nodiscard]] std::optional<connection_lease>
+		try_acquire_writer( std::chrono::milliseconds timeout );
+
+		[[nodiscard]] std::size_t reader_count( ) const;
+	};
+} // namespace daw::sqlite
@@ -0,0 +1,661 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/cell_value.h"
+#include "daw/sqlite/functions.h"
+#include "daw/sqlite/identifier.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <daw/daw_move.h>
+#include <daw/daw_string_view.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <sqlite3.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace daw::sqlite {
+	/***
+	 * @brief What a container_table column can be searched by
+	 */
+	enum class vtab_index {
+		/// Constraints on the column are checked row by row
+		None,
+		/// The column is the container's key, equality is looked up with
+		/// container.find
+		Key,
+		/// The container is sorted by the column, equality and ranges are found
+		/// by binary search.  Requires a random access container
+		Sorted
+	};
+
+	/***
+	 * @brief A column of a container_table.  std::invoke( accessor, element )
+	 * gives the value of the column, accessor can be a lambda or a pointer to
+	 * member.  Text and blobs returned as references or views into the element
+	 * are given to sqlite without copying
+	 */
+	template<typename Accessor>
+	struct vtab_column {
+		std::string name;
+		Accessor accessor;
+		vtab_index index = vtab_index::None;
+
+		vtab_column( std::string column_name, Accessor column_accessor,
+		             vtab_index column_index = vtab_index::None )
+		  : name( std::move( column_name ) )
+		  , accessor( std::move( column_accessor ) )
+		  , index( column_index ) {}
+	};
+
+	namespace vtab_impl {
+		template<typename>
+		inline constexpr bool is_optional_v = false;
+
+		template<typename T>
+		inline constexpr bool is_optional_v<std::optional<T>> = true;
+
+		template<typename T>
+		inline constexpr bool is_text_v = std::same_as<T, std::string> or
+		                                  std::same_as<T, std::string_view> or
+		                                  std::same_as<T, types::text_t>;
+
+		template<typename T>
+		inline constexpr bool is_blob_v =
+		  std::same_as<T, std::vector<std::byte>> or
+		  std::same_as<T, std::span<std::byte const>> or
+		  std::same_as<T, types::blob_t>;
+
+		template<typename T>
+		inline constexpr bool is_view_v =
+		  std::same_as<T, std::string_view> or std::same_as<T, types::text_t> or
+		  std::same_as<T, std::span<std::byte const>> or
+		  std::same_as<T, types::blob_t>;
+
+		template<typename T>
+		concept Decodable = requires( sqlite3_value *value ) {
+			{ value_traits<T>::accepts( SQLITE_NULL ) } -> std::same_as<bool>;
+			T( value_traits<T>::get( value ) );
+		};
+
+		/***
+		 * @brief A value sqlite passed to xFilter as T, or nullopt when its type
+		 * does not match or it does not fit T, e.g. 4294967297 for an int
+		 */
+		template<Decodable T>
+		[[nodiscard]] std::optional<T> decode( sqlite3_value *value ) {
+			if( not can_decode<T>( value ) ) {
+				return std::nullopt;
+			}
+			return T( value_traits<T>::get( value ) );
+		}
+
+		/***
+		 * @brief The declared type of a column holding T
+		 */
+		template<typename T>
+		[[nodiscard]] constexpr char const *declared_type( ) {
+			if constexpr( is_optional_v<T> ) {
+				return declared_type<typename T::value_type>( );
+			} else if constexpr( std::integral<T> ) {
+				return "INTEGER";
+			} else if constexpr( std::floating_point<T> ) {
+				return "REAL";
+			} else if constexpr( is_text_v<T> ) {
+				return "TEXT";
+			} else if constexpr( is_blob_v<T> ) {
+				return "BLOB";
+			} else {
+				return "";
+			}
+		}
+
+		/***
+		 * @brief Set the result of xColumn.  Text and blobs that refer to the
+		 * container are passed with SQLITE_STATIC, values made by the accessor
+		 * are copied
+		 */
+		template<typename T>
+		void set_column_result( sqlite3_context *ctx, T &&value ) {
+			using U = std::remove_cvref_t<T>;
+			constexpr bool refers_to_container =
+			  std::is_lvalue_reference_v<T> or is_view_v<U>;
+			if constexpr( is_optional_v<U> ) {
+				if( not value ) {
+					sqlite3_result_null( ctx );
+				} else {
+					set_column_result( ctx, *DAW_FWD( value ) );
+				}
+			} else if constexpr( is_text_v<U> and refers_to_container ) {
+				sqlite3_result_text64(
+				  ctx, value.data( ), value.size( ), SQLITE_STATIC, SQLITE_UTF8 );
+			} else if constexpr( is_blob_v<U> and refers_to_container ) {
+				sqlite3_result_blob64( ctx, value.data( ), value.size( ), SQLITE_STATIC );
+			} else {
+				result_traits<U>::set( ctx, value );
+			}
+		}
+
+		/***
+		 * @brief Call f( std::integral_constant<std::size_t, index>{ } )
+		 */
+		template<std::size_t N, typename F>
+		void visit_index( std::size_t index, F &&f ) {
+			[&]<std::size_t... Is>( std::index_sequence<Is...> ) {
+				(void)( ( index == Is
+				            ? ( f( std::integral_constant<std::size_t, Is>{ } ), true )
+				            : false ) or
+				        ... );
+			}( std::make_index_sequence<N>{ } );
+		}
+
+		// xBestIndex plans, in the low byte of idxNum
+		enum plan_kind : int { FullScan, RowidEq, KeyEq, SortedRange };
+		// Bounds used by a SortedRange plan, in the second byte of idxNum.  The
+		// arguments are passed in this order
+		enum plan_bound : int {
+			HasEq = 1,
+			HasLower = 2,
+			LowerInclusive = 4,
+			HasUpper = 8,
+			UpperInclusive = 16
+		};
+
+		[[nodiscard]] constexpr int make_plan( plan_kind kind, int bounds = 0,
+		                                       std::size_t column = 0 ) {
+			return static_cast<int>( kind ) | ( bounds << 8 ) |
+			       ( static_cast<int>( column ) << 16 );
+		}
+
+		/***
+		 * @brief Set the error message of a virtual table, replacing any previous
+		 */
+		void set_error( sqlite3_vtab *vtab, char const *message ) noexcept;
+
+		/***
+		 * @brief Does constraint compare with the BINARY collation, the order
+		 * of the container.  Only callable from xBestIndex
+		 */
+		[[nodiscard]] bool has_binary_collation( sqlite3_index_info *info,
+		                                         std::size_t constraint ) noexcept;
+
+		/***
+		 * @brief sqlite3_create_module_v2, throwing on failure.  destroy( aux )
+		 * is called when the module is replaced, the connection is closed or
+		 * registration fails
+		 */
+		void create_module( sqlite3 *db, daw::string_view name,
+		                    sqlite3_module const *module, void *aux,
+		                    void ( *destroy )( void * ) );
+
+		/***
+		 * @brief An eponymous read only virtual table over a container, the
+		 * module's pAux
+		 */
+		template<typename Container, typename... Accessors>
+		struct container_table {
+			using iterator = std::ranges::iterator_t<Container const>;
+			using element_reference = std::ranges::range_reference_t<Container const>;
+			static constexpr bool is_random_access =
+			  std::ranges::random_access_range<Container const>;
+			static constexpr std::size_t column_count = sizeof...( Accessors );
+			static constexpr bool has_find = requires( Container const &c ) {
+				typename Container::key_type;
+				requires Decodable<typename Container::key_type>;
+				{
+					c.find( std::declval<typename Container::key_type const &>( ) )
+				} -> std::same_as<iterator>;
+			};
+
+			template<std::size_t I>
+			using column_value_t = std::remove_cvref_t<std::invoke_result_t<
+			  std::tuple_element_t<I, std::tuple<Accessors...>> const &,
+			  element_reference>>;
+
+			Container const *container;
+			std::tuple<vtab_column<Accessors>...> columns;
+
+			struct table_t : sqlite3_vtab {
+				container_table *self = nullptr;
+			};
+
+			struct cursor_t : sqlite3_vtab_cursor {
+				container_table *self = nullptr;
+				iterator current{ };
+				iterator last{ };
+				// Position of current in the container, unknown after a key lookup
+				// of a container that is not random access
+				std::optional<std::int64_t> rowid{ };
+			};
+
+			[[nodiscard]] static container_table &get( sqlite3_vtab *vtab ) {
+				return *static_cast<table_t *>( vtab )->self;
+			}
+
+			[[nodiscard]] static cursor_t &get( sqlite3_vtab_cursor *cursor ) {
+				return *static_cast<cursor_t *>( cursor );
+			}
+
+			[[nodiscard]] double row_estimate( ) const {
+				if constexpr( std::ranges::sized_range<Container const> ) {
+					return static_cast<double>( std::ranges::size( *container ) );
+				} else {
+					return 1'000'000.0;
+				}
+			}
+
+			[[nodiscard]] std::string declaration( ) const {
+				auto result = std::string( "CREATE TABLE x(" );
+				[&]<std::size_t... Is>( std::index_sequence<Is...> ) {
+					( ( result += ( Is == 0 ? "" : ", " ),
+					    result += sql_impl::quote_identifier( std::get<Is>( columns ).name ),
+					    result += ' ',
+					    result += declared_type<column_value_t<Is>>( ) ),
+					  ... );
+				}( std::make_index_sequence<column_count>{ } );
+				result += ')';
+				return result;
+			}
+
+			[[nodiscard]] vtab_index column_index( int column ) const {
+				auto result = vtab_index::None;
+				if( column >= 0 ) {
+					visit_index<column_count>( static_cast<std::size_t>( column ),
+					                           [&]( auto I ) {
+						                           result = std::get<I>( columns ).index;
+					                           } );
+				}
+				return result;
+			}
+
+			static int x_connect( sqlite3 *db, void *aux, int, char const *const *,
+			                      sqlite3_vtab **vtab, char **error ) noexcept {
+				auto &self = *static_cast<container_table *>( aux );
+				try {
+					auto const rc = sqlite3_declare_vtab( db, self.declaration( ).c_str( ) );
+					if( rc != SQLITE_OK ) {
+						return rc;
+					}
+					auto table = std::make_unique<table_t>( );
+					table->self = &self;
+					*vtab = table.release( );
+					return SQLITE_OK;
+				} catch( std::exception const &ex ) {
+					*error = sqlite3_mprintf( "%s", ex.what( ) );
+				} catch( ... ) {
+				}
+				return SQLITE_ERROR;
+			}
+
+			static int x_disconnect( sqlite3_vtab *vtab ) noexcept {
+				delete static_cast<table_t *>( vtab );
+				return SQLITE_OK;
+			}
+
+			static int x_best_index( sqlite3_vtab *vtab,
+			                         sqlite3_index_info *info ) noexcept {
+				auto const &self = get( vtab );
+				auto const rows = self.row_estimate( );
+				auto const search_cost = std::max( 1.0, std::log2( rows + 1.0 ) );
+				auto const constraints =
+				  std::span( info->aConstraint,
+				             static_cast<std::size_t>( info->nConstraint ) );
+				auto const use = [&]( std::size_t constraint, int argv_index ) {
+					// sqlite checks the constraint again, a bound that cannot be used
+					// falls back to scanning more rows than needed
+					info->aConstraintUsage[constraint].argvIndex = argv_index;
+					info->aConstraintUsage[constraint].omit = 0;
+				};
+				auto const find = [&]( auto &&pred ) -> std::optional<std::size_t> {
+					for( std::size_t n = 0; n < constraints.size( ); ++n ) {
+						if( constraints[n].usable and pred( constraints[n] ) ) {
+							return n;
+						}
+					}
+					return std::nullopt;
+				};
+				auto const is_eq = []( int op ) {
+					return op == SQLITE_INDEX_CONSTRAINT_EQ;
+				};
+				// A lookup compares as the container does, e.g. a key = 'x' COLLATE
+				// NOCASE has to be checked row by row
+				auto const is_binary = [&]( auto const &con ) {
+					return has_binary_collation(
+					  info, static_cast<std::size_t>( &con - constraints.data( ) ) );
+				};
+
+				// Rows come out in container order, which is rowid order and the
+				// order of a Sorted column
+				if( info->nOrderBy == 1 and not info->aOrderBy[0].desc ) {
+					auto const column = info->aOrderBy[0].iColumn;
+					if( column < 0 or
+					    self.column_index( column ) == vtab_index::Sorted ) {
+						info->orderByConsumed = 1;
+					}
+				}
+
+				if constexpr( is_random_access ) {
+					if( auto const c = find( [&]( auto const &con ) {
+						    return con.iColumn < 0 and is_eq( con.op );
+					    } ) ) {
+						use( *c, 1 );
+						info->idxNum = make_plan( RowidEq );
+						info->estimatedCost = 1.0;
+						info->estimatedRows = 1;
+						info->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+						return SQLITE_OK;
+					}
+				}
+				if( auto const c = find( [&]( auto const &con ) {
+					    return is_eq( con.op ) and
+					           self.column_index( con.iColumn ) == vtab_index::Key and
+					           is_binary( con );
+				    } ) ) {
+					use( *c, 1 );
+					info->idxNum = make_plan( KeyEq, 0, static_cast<std::size_t>(
+					                                      constraints[*c].iColumn ) );
+					info->estimatedCost = 2.0;
+					info->estimatedRows = 1;
+					return SQLITE_OK;
+				}
+				if constexpr( is_random_access ) {
+					for( std::size_t n = 0; n < constraints.size( ); ++n ) {
+						auto const column = constraints[n].iColumn;
+						if( not constraints[n].usable or
+						    self.column_index( column ) != vtab_index::Sorted ) {
+							continue;
+						}
+						auto const on_column = [&]( auto const &ops ) {
+							return find( [&]( auto const &con ) {
+								return con.iColumn == column and
+								       std::ranges::find( ops, con.op ) != ops.end( ) and
+								       is_binary( con );
+							} );
+						};
+						int bounds = 0;
+						int argv_index = 0;
+						auto matched = 1.0;
+						if( auto const eq = on_column(
+						      std::array{ int{ SQLITE_INDEX_CONSTRAINT_EQ } } ) ) {
+							bounds |= HasEq;
+							use( *eq, ++argv_index );
+						} else {
+							auto const lower = on_column( std::array{
+							  int{ SQLITE_INDEX_CONSTRAINT_GT },
+							  int{ SQLITE_INDEX_CONSTRAINT_GE } } );
+							auto const upper = on_column( std::array{
+							  int{ SQLITE_INDEX_CONSTRAINT_LT },
+							  int{ SQLITE_INDEX_CONSTRAINT_LE } } );
+							if( not lower and not upper ) {
+								// e.g. != or LIKE, checked row by row
+								continue;
+							}
+							if( lower ) {
+								bounds |= HasLower;
+								if( constraints[*lower].op == SQLITE_INDEX_CONSTRAINT_GE ) {
+									bounds |= LowerInclusive;
+								}
+								use( *lower, ++argv_index );
+							}
+							if( upper ) {
+								bounds |= HasUpper;
+								if( constraints[*upper].op == SQLITE_INDEX_CONSTRAINT_LE ) {
+									bounds |= UpperInclusive;
+								}
+								use( *upper, ++argv_index );
+							}
+							matched = rows / ( lower and upper ? 4.0 : 2.0 );
+						}
+						info->idxNum =
+						  make_plan( SortedRange, bounds, static_cast<std::size_t>( column ) );
+						info->estimatedCost = search_cost + matched;
+						info->estimatedRows = static_cast<sqlite3_int64>( matched );
+						return SQLITE_OK;
+					}
+				}
+				info->idxNum = make_plan( FullScan );
+				info->estimatedCost = rows;
+				info->estimatedRows = static_cast<sqlite3_int64>( rows );
+				return SQLITE_OK;
+			}
+
+			static int x_open( sqlite3_vtab *vtab,
+			                   sqlite3_vtab_cursor **cursor ) noexcept {
+				auto *result = new( std::nothrow ) cursor_t{ };
+				if( not result ) {
+					return SQLITE_NOMEM;
+				}
+				result->self = &get( vtab );
+				*cursor = result;
+				return SQLITE_OK;
+			}
+
+			static int x_close( sqlite3_vtab_cursor *cursor ) noexcept {
+				delete static_cast<cursor_t *>( cursor );
+				return SQLITE_OK;
+			}
+
+			// Narrow [current, last) to the elements whose column I is within the
+			// bounds in argv.  A bound of another type is not used, leaving more
+			// rows for sqlite to check
+			template<std::size_t I>
+			void narrow_sorted( cursor_t &cursor, int bounds,
+			                    sqlite3_value **argv ) const {
+				using value_t = column_value_t<I>;
+				if constexpr( Decodable<value_t> and std::totally_ordered<value_t> ) {
+					auto const &accessor = std::get<I>( columns ).accessor;
+					// The first element not before bound, or the first after it
+					auto const position = [&]( value_t const &bound, bool after ) {
+						return std::partition_point(
+						  cursor.current, cursor.last, [&]( auto const &element ) {
+							  auto const &value = std::invoke( accessor, element );
+							  return after ? not( bound < value ) : value < bound;
+						  } );
+					};
+					if( bounds & HasEq ) {
+						if( auto const bound = decode<value_t>( argv[0] ) ) {
+							cursor.current = position( *bound, false );
+							cursor.last = position( *bound, true );
+						}
+						return;
+					}
+					auto arg = 0;
+					if( bounds & HasLower ) {
+						if( auto const bound = decode<value_t>( argv[arg++] ) ) {
+							cursor.current =
+							  position( *bound, ( bounds & LowerInclusive ) == 0 );
+						}
+					}
+					if( bounds & HasUpper ) {
+						if( auto const bound = decode<value_t>( argv[arg] ) ) {
+							cursor.last = position( *bound, ( bounds & UpperInclusive ) != 0 );
+						}
+					}
+				}
+			}
+
+			static int x_filter( sqlite3_vtab_cursor *vtab_cursor, int plan,
+			                     char const *, int,
+			                     sqlite3_value **argv ) noexcept {
+				auto &cursor = get( vtab_cursor );
+				auto const &self = *cursor.self;
+				try {
+					auto const &container = *self.container;
+					auto const first = std::ranges::begin( container );
+					cursor.current = first;
+					cursor.last = std::ranges::end( container );
+					cursor.rowid = 0;
+					auto const column = static_cast<std::size_t>( plan >> 16 );
+					switch( plan & 0xFF ) {
+					case RowidEq:
+						if constexpr( is_random_access ) {
+							if( not value_traits<std::int64_t>::accepts(
+							      sqlite3_value_type( argv[0] ) ) ) {
+								break;
+							}
+							auto const rowid = sqlite3_value_int64( argv[0] );
+							auto const size = cursor.last - first;
+							if( rowid < 0 or rowid >= static_cast<std::int64_t>( size ) ) {
+								cursor.current = cursor.last;
+							} else {
+								cursor.current = first + rowid;
+								cursor.last = std::next( cursor.current );
+							}
+						}
+						break;
+					case KeyEq:
+						if constexpr( has_find ) {
+							auto const key =
+							  decode<typename Container::key_type>( argv[0] );
+							if( not key ) {
+								break;
+							}
+							auto const found = container.find( *key );
+							if( found == cursor.last ) {
+								cursor.current = cursor.last;
+							} else {
+								cursor.current = found;
+								cursor.last = std::next( found );
+								cursor.rowid.reset( );
+							}
+						}
+						break;
+					case SortedRange:
+						if constexpr( is_random_access ) {
+							visit_index<column_count>( column, [&]( auto I ) {
+								self.template narrow_sorted<I>( cursor, ( plan >> 8 ) & 0xFF, argv );
+							} );
+						}
+						break;
+					default:
+						break;
+					}
+					if constexpr( is_random_access ) {
+						cursor.rowid = cursor.current - first;
+					}
+					return SQLITE_OK;
+				} catch( std::exception const &ex ) {
+					set_error( vtab_cursor->pVtab, ex.what( ) );
+				} catch( ... ) {
+					set_error( vtab_cursor->pVtab, "Unknown exception in container_table" );
+				}
+				return SQLITE_ERROR;
+			}
+
+			static int x_next( sqlite3_vtab_cursor *vtab_cursor ) noexcept {
+				auto &cursor = get( vtab_cursor );
+				++cursor.current;
+				if( cursor.rowid ) {
+					++*cursor.rowid;
+				}
+				return SQLITE_OK;
+			}
+
+			static int x_eof( sqlite3_vtab_cursor *vtab_cursor ) noexcept {
+				auto &cursor = get( vtab_cursor );
+				return cursor.current == cursor.last ? 1 : 0;
+			}
+
+			static int x_column( sqlite3_vtab_cursor *vtab_cursor,
+			                     sqlite3_context *ctx, int column ) noexcept {
+				auto &cursor = get( vtab_cursor );
+				try {
+					visit_index<column_count>(
+					  static_cast<std::size_t>( column ), [&]( auto I ) {
+						  set_column_result(
+						    ctx,
+						    std::invoke( std::get<I>( cursor.self->columns ).accessor,
+						                 *cursor.current ) );
+					  } );
+				} catch( ... ) {
+					function_impl::report_exception( ctx );
+				}
+				return SQLITE_OK;
+			}
+
+			static int x_rowid( sqlite3_vtab_cursor *vtab_cursor,
+			                    sqlite3_int64 *rowid ) noexcept {
+				auto &cursor = get( vtab_cursor );
+				if( not cursor.rowid ) {
+					cursor.rowid = static_cast<std::int64_t>( std::distance(
+					  std::ranges::begin( *cursor.self->container ), cursor.current ) );
+				}
+				*rowid = *cursor.rowid;
+				return SQLITE_OK;
+			}
+
+			[[nodiscard]] static sqlite3_module const *module( ) {
+				static sqlite3_module const result = [] {
+					auto m = sqlite3_module{ };
+					// Without xCreate the table is eponymous only, it exists as soon
+					// as the module is registered and cannot be created or dropped
+					m.iVersion = 1;
+					m.xConnect = &x_connect;
+					m.xBestIndex = &x_best_index;
+					m.xDisconnect = &x_disconnect;
+					m.xDestroy = &x_disconnect;
+					m.xOpen = &x_open;
+					m.xClose = &x_close;
+					m.xFilter = &x_filter;
+					m.xNext = &x_next;
+					m.xEof = &x_eof;
+					m.xColumn = &x_column;
+					m.xRowid = &x_rowid;
+					return m;
+				}( );
+				return &result;
+			}
+
+			static void destroy( void *ptr ) noexcept {
+				delete static_cast<container_table *>( ptr );
+			}
+		};
+
+		template<std::ranges::forward_range Container, typename... Accessors>
+		void register_container( sqlite3 *db, daw::string_view name,
+		                         Container const &container,
+		                         vtab_column<Accessors>... columns ) {
+			static_assert( sizeof...( Accessors ) > 0,
+			               "A container table needs at least one column" );
+			using table_t = container_table<Container, Accessors...>;
+			if( not table_t::is_random_access and
+			    ( ( columns.index == vtab_index::Sorted ) or ... ) ) {
+				throw sqlite3_exception(
+				  "Sorted columns require a random access container" );
+			}
+			if( not table_t::has_find and
+			    ( ( columns.index == vtab_index::Key ) or ... ) ) {
+				throw sqlite3_exception(
+				  "Key columns require a container with key_type and find" );
+			}
+			auto ptr = std::make_unique<table_t>(
+			  table_t{ &container, std::tuple( std::move( columns )... ) } );
+			create_module( db, name, table_t::module( ), ptr.release( ),
+			               &table_t::destroy );
+		}
+	} // namespace vtab_impl
+} // namespace daw::sqlite
@@ -0,0 +1,560 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/cell_value.h"
+
+#include <daw/daw_move.h>
+#include <daw/daw_string_view.h>
+
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <sqlite3.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace daw::sqlite {
+	/***
+	 * @brief How sqlite may use a function registered from C++
+	 */
+	struct function_options {
+		/// SQLITE_DETERMINISTIC, the same arguments always give the same result.
+		/// Calls with constant arguments are evaluated once and the function can
+		/// be used in indexes and generated columns
+		bool deterministic = false;
+		/// SQLITE_INNOCUOUS, the function has no side effects and is safe to use
+		/// from the schema of an untrusted database
+		bool innocuous = false;
+		/// SQLITE_DIRECTONLY, the function can only be called from top level SQL,
+		/// not from triggers, views or the schema
+		bool direct_only = false;
+
+		/***
+		 * @brief The eTextRep and flags to pass to sqlite3_create_function_v2
+		 */
+		[[nodiscard]] int flags( ) const;
+	};
+
+	/***
+	 * @brief Describes how to read a C++ type from a function argument.
+	 * Specializations provide
+	 * 	static constexpr bool accepts( int sqlite_type ) - is the fundamental type
+	 * 		returned by sqlite3_value_type usable for this type
+	 * 	static T get( sqlite3_value * ) - decode the argument
+	 * and can provide
+	 * 	static bool fits( sqlite3_value * ) - can the accepted value be
+	 * 		represented, e.g. is an integer within the range of T
+	 * Text and blob views are only valid during the call
+	 */
+	template<typename T>
+	struct value_traits;
+
+	template<std::integral T>
+		requires( not std::same_as<T, bool> ) //
+	struct value_traits<T> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_INTEGER;
+		}
+
+		static bool fits( sqlite3_value *value ) {
+			return std::in_range<T>( sqlite3_value_int64( value ) );
+		}
+
+		static T get( sqlite3_value *value ) {
+			return static_cast<T>( sqlite3_value_int64( value ) );
+		}
+	};
+
+	template<>
+	struct value_traits<bool> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_INTEGER;
+		}
+
+		static bool get( sqlite3_value *value ) {
+			return sqlite3_value_int64( value ) != 0;
+		}
+	};
+
+	template<std::floating_point T>
+	struct value_traits<T> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_FLOAT or sqlite_type == SQLITE_INTEGER;
+		}
+
+		static T get( sqlite3_value *value ) {
+			return static_cast<T>( sqlite3_value_double( value ) );
+		}
+	};
+
+	template<>
+	struct value_traits<std::string_view> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_TEXT;
+		}
+
+		static std::string_view get( sqlite3_value *value ) {
+			// sqlite3_value_text must be called before sqlite3_value_bytes
+			auto const *first =
+			  reinterpret_cast<char const *>( sqlite3_value_text( value ) );
+			return std::string_view(
+			  first, static_cast<std::size_t>( sqlite3_value_bytes( value ) ) );
+		}
+	};
+
+	template<>
+	struct value_traits<types::text_t> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return value_traits<std::string_view>::accepts( sqlite_type );
+		}
+
+		static types::text_t get( sqlite3_value *value ) {
+			auto const sv = value_traits<std::string_view>::get( value );
+			return types::text_t( sv.data( ), sv.size( ) );
+		}
+	};
+
+	template<>
+	struct value_traits<std::string> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return value_traits<std::string_view>::accepts( sqlite_type );
+		}
+
+		static std::string get( sqlite3_value *value ) {
+			return std::string( value_traits<std::string_view>::get( value ) );
+		}
+	};
+
+	template<>
+	struct value_traits<types::blob_t> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_BLOB;
+		}
+
+		static types::blob_t get( sqlite3_value *value ) {
+			// sqlite3_value_blob must be called before sqlite3_value_bytes
+			auto const *first =
+			  static_cast<std::byte const *>( sqlite3_value_blob( value ) );
+			return types::blob_t(
+			  first, static_cast<std::size_t>( sqlite3_value_bytes( value ) ) );
+		}
+	};
+
+	template<>
+	struct value_traits<std::vector<std::byte>> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return value_traits<types::blob_t>::accepts( sqlite_type );
+		}
+
+		static std::vector<std::byte> get( sqlite3_value *value ) {
+			auto const blob = value_traits<types::blob_t>::get( value );
+			return std::vector<std::byte>( blob.begin( ), blob.end( ) );
+		}
+	};
+
+	template<typename T>
+	struct value_traits<std::optional<T>> {
+		static constexpr bool accepts( int sqlite_type ) {
+			return sqlite_type == SQLITE_NULL or
+			       value_traits<T>::accepts( sqlite_type );
+		}
+
+		static bool fits( sqlite3_value *value ) {
+			if constexpr( requires { value_traits<T>::fits( value ); } ) {
+				return sqlite3_value_type( value ) == SQLITE_NULL or
+				       value_traits<T>::fits( value );
+			} else {
+				return true;
+			}
+		}
+
+		static std::optional<T> get( sqlite3_value *value ) {
+			if( sqlite3_value_type( value ) == SQLITE_NULL ) {
+				return std::nullopt;
+			}
+			return value_traits<T>::get( value );
+		}
+	};
+
+	/***
+	 * @brief Can value be decoded as T without losing it.  Its type must be
+	 * accepted and, when value_traits<T> has fits, be in range
+	 */
+	template<typename T>
+	[[nodiscard]] bool can_decode( sqlite3_value *value ) {
+		if( not value_traits<T>::accepts( sqlite3_value_type( value ) ) ) {
+			return false;
+		}
+		if constexpr( requires { value_traits<T>::fits( value ); } ) {
+			return value_traits<T>::fits( value );
+		} else {
+			return true;
+		}
+	}
+
+	template<typename T>
+	concept FunctionArgument = requires( sqlite3_value *value ) {
+		{ value_traits<T>::accepts( SQLITE_NULL ) } -> std::same_as<bool>;
+		{ value_traits<T>::get( value ) } -> std::convertible_to<T>;
+	};
+
+	/***
+	 * @brief Describes how to return a C++ type from a function.
+	 * Specializations provide
+	 * 	static void set( sqlite3_context *, T const & ) - set the result, text
+	 * 		and blobs are copied by sqlite
+	 */
+	template<typename T>
+	struct result_traits;
+
+	template<std::integral T>
+	struct result_traits<T> {
+		static void set( sqlite3_context *ctx, T value ) {
+			sqlite3_result_int64( ctx, static_cast<sqlite3_int64>( value ) );
+		}
+	};
+
+	template<std::floating_point T>
+	struct result_traits<T> {
+		static void set( sqlite3_context *ctx, T value ) {
+			sqlite3_result_double( ctx, static_cast<double>( value ) );
+		}
+	};
+
+	template<>
+	struct result_traits<std::nullptr_t> {
+		static void set( sqlite3_context *ctx, std::nullptr_t ) {
+			sqlite3_result_null( ctx );
+		}
+	};
+
+	template<typename T>
+		requires( std::same_as<T, std::string_view> or
+		          std::same_as<T, std::string> or
+		          std::same_as<T, types::text_t> ) //
+	struct result_traits<T> {
+		static void set( sqlite3_context *ctx, T const &value ) {
+			sqlite3_result_text64( ctx,
+			                       value.data( ),
+			                       value.size( ),
+			                       SQLITE_TRANSIENT,
+			                       SQLITE_UTF8 );
+		}
+	};
+
+	template<typename T>
+		requires( std::same_as<T, types::blob_t> or
+		          std::same_as<T, std::vector<std::byte>> or
+		          std::same_as<T, std::span<std::byte const>> ) //
+	struct result_traits<T> {
+		static void set( sqlite3_context *ctx, T const &value ) {
+			sqlite3_result_blob64( ctx, value.data( ), value.size( ), SQLITE_TRANSIENT );
+		}
+	};
+
+	template<typename T>
+	struct result_traits<std::optional<T>> {
+		static void set( sqlite3_context *ctx, std::optional<T> const &value ) {
+			if( not value ) {
+				sqlite3_result_null( ctx );
+				return;
+			}
+			result_traits<T>::set( ctx, *value );
+		}
+	};
+
+	template<>
+	struct result_traits<cell_value> {
+		static void set( sqlite3_context *ctx, cell_value const &value );
+	};
+
+	template<typename T>
+	concept FunctionResult =
+	  std::is_void_v<T> or requires( sqlite3_context *ctx, T const &value ) {
+		  result_traits<T>::set( ctx, value );
+	  };
+
+	namespace function_impl {
+		/***
+		 * @brief The argument types and result of a callable with one
+		 * non-template call operator
+		 */
+		template<typename F>
+		struct callable_traits
+		  : callable_traits<decltype( &std::remove_cvref_t<F>::operator( ) )> {};
+
+		template<typename R, typename... Args>
+		struct callable_traits<R ( * )( Args... )> {
+			using result_type = R;
+			using args_type = std::tuple<std::remove_cvref_t<Args>...>;
+		};
+
+		template<typename R, typename... Args>
+		struct callable_traits<R ( * )( Args... ) noexcept>
+		  : callable_traits<R ( * )( Args... )> {};
+
+		template<typename R, typename C, typename... Args>
+		struct callable_traits<R ( C::* )( Args... )>
+		  : callable_traits<R ( * )( Args... )> {};
+
+		template<typename R, typename C, typename... Args>
+		struct callable_traits<R ( C::* )( Args... ) const>
+		  : callable_traits<R ( * )( Args... )> {};
+
+		template<typename R, typename C, typename... Args>
+		struct callable_traits<R ( C::* )( Args... ) noexcept>
+		  : callable_traits<R ( * )( Args... )> {};
+
+		template<typename R, typename C, typename... Args>
+		struct callable_traits<R ( C::* )( Args... ) const noexcept>
+		  : callable_traits<R ( * )( Args... )> {};
+
+		template<typename F>
+		using args_t = typename callable_traits<std::decay_t<F>>::args_type;
+
+		template<typename F>
+		using result_t = typename callable_traits<std::decay_t<F>>::result_type;
+
+		/***
+		 * @brief Set the result of ctx from the exception being handled
+		 */
+		void report_exception( sqlite3_context *ctx ) noexcept;
+
+		void report_argument_mismatch( sqlite3_context *ctx );
+
+		/***
+		 * @brief Register the callbacks with sqlite3_create_function_v2, or
+		 * sqlite3_create_window_function when x_inverse is set.  destroy( app )
+		 * is called when the function is replaced, the connection is closed or
+		 * registration fails
+		 */
+		void create_function(
+		  sqlite3 *db, daw::string_view name, int arg_count,
+		  function_options const &options, void *app,
+		  void ( *x_func )( sqlite3_context *, int, sqlite3_value ** ),
+		  void ( *x_step )( sqlite3_context *, int, sqlite3_value ** ),
+		  void ( *x_final )( sqlite3_context * ),
+		  void ( *x_value )( sqlite3_context * ),
+		  void ( *x_inverse )( sqlite3_context *, int, sqlite3_value ** ),
+		  void ( *destroy )( void * ) );
+
+		// Are argv[0, N) usable as the elements [Offset, Offset + N) of Args
+		template<typename Args, std::size_t Offset>
+		[[nodiscard]] bool accepts_all( sqlite3_value **argv ) {
+			return [&]<std::size_t... Is>( std::index_sequence<Is...> ) {
+				return ( can_decode<std::tuple_element_t<Is + Offset, Args>>( argv[Is] ) and
+				         ... );
+			}( std::make_index_sequence<std::tuple_size_v<Args> - Offset>{ } );
+		}
+
+		// Call fn( prefix..., args... ) with the arguments decoded as the
+		// elements [Offset, end) of Args
+		template<typename Args, std::size_t Offset, typename F, typename... Prefix>
+		decltype( auto ) call( F &fn, sqlite3_value **argv, Prefix &...prefix ) {
+			return [&]<std::size_t... Is>( std::index_sequence<Is...> )
+			         -> decltype( auto ) {
+				return fn(
+				  prefix...,
+				  value_traits<std::tuple_element_t<Is + Offset, Args>>::get( argv[Is] )... );
+			}( std::make_index_sequence<std::tuple_size_v<Args> - Offset>{ } );
+		}
+
+		template<typename T>
+		void set_result( sqlite3_context *ctx, T const &value ) {
+			result_traits<std::remove_cvref_t<T>>::set( ctx, value );
+		}
+
+		template<typename Fn>
+		struct scalar_function {
+			using args_type = args_t<Fn>;
+			using result_type = result_t<Fn>;
+
+			Fn fn;
+
+			static void x_func( sqlite3_context *ctx, int,
+			                    sqlite3_value **argv ) noexcept {
+				auto &self = *static_cast<scalar_function *>( sqlite3_user_data( ctx ) );
+				try {
+					if( not accepts_all<args_type, 0>( argv ) ) {
+						report_argument_mismatch( ctx );
+						return;
+					}
+					if constexpr( std::is_void_v<result_type> ) {
+						call<args_type, 0>( self.fn, argv );
+						sqlite3_result_null( ctx );
+					} else {
+						set_result( ctx, call<args_type, 0>( self.fn, argv ) );
+					}
+				} catch( ... ) {
+					report_exception( ctx );
+				}
+			}
+
+			static void destroy( void *ptr ) noexcept {
+				delete static_cast<scalar_function *>( ptr );
+			}
+		};
+
+		/***
+		 * @brief The state of one aggregate group, kept in place in the memory of
+		 * sqlite3_aggregate_context, which is zeroed when first allocated
+		 */
+		template<typename State>
+		struct aggregate_slot {
+			alignas( State ) std::byte storage[sizeof( State )];
+			bool constructed;
+
+			[[nodiscard]] State &state( ) {
+				return *std::launder( reinterpret_cast<State *>( storage ) );
+			}
+		};
+
+		template<typename Init, typename Step, typename Final, typename Inverse>
+		struct aggregate_function {
+			using state_type = std::invoke_result_t<Init &>;
+			using step_args = args_t<Step>;
+			using slot_type = aggregate_slot<state_type>;
+
+			// sqlite only guarantees 8 byte alignment of its allocations
+			static_assert( alignof( state_type ) <= 8,
+			               "Aggregate states must not be over aligned" );
+
+			Init init;
+			Step step;
+			Final final;
+			Inverse inverse;
+
+			[[nodiscard]] static aggregate_function &self( sqlite3_context *ctx ) {
+				return *static_cast<aggregate_function *>( sqlite3_user_data( ctx ) );
+			}
+
+			template<typename F>
+			static void update( sqlite3_context *ctx, F &fn, sqlite3_value **argv ) {
+				auto *slot = static_cast<slot_type *>(
+				  sqlite3_aggregate_context( ctx, sizeof( slot_type ) ) );
+				if( not slot ) {
+					sqlite3_result_error_nomem( ctx );
+					return;
+				}
+				if( not slot->constructed ) {
+					std::construct_at( &slot->state( ), self( ctx ).init( ) );
+					slot->constructed = true;
+				}
+				if( not accepts_all<args_t<F>, 1>( argv ) ) {
+					report_argument_mismatch( ctx );
+					return;
+				}
+				call<args_t<F>, 1>( fn, argv, slot->state( ) );
+			}
+
+			static void x_step( sqlite3_context *ctx, int,
+			                    sqlite3_value **argv ) noexcept {
+				try {
+					update( ctx, self( ctx ).step, argv );
+				} catch( ... ) {
+					report_exception( ctx );
+				}
+			}
+
+			static void x_inverse( sqlite3_context *ctx, int,
+			                       sqlite3_value **argv ) noexcept {
+				if constexpr( not std::is_same_v<Inverse, std::nullptr_t> ) {
+					try {
+						update( ctx, self( ctx ).inverse, argv );
+					} catch( ... ) {
+						report_exception( ctx );
+					}
+				}
+			}
+
+			static void x_value( sqlite3_context *ctx ) noexcept {
+				// With no rows the group has no context yet, its result is that of
+				// a fresh state
+				auto *slot =
+				  static_cast<slot_type *>( sqlite3_aggregate_context( ctx, 0 ) );
+				try {
+					if( slot and slot->constructed ) {
+						set_result( ctx, self( ctx ).final( slot->state( ) ) );
+					} else {
+						auto state = self( ctx ).init( );
+						set_result( ctx, self( ctx ).final( state ) );
+					}
+				} catch( ... ) {
+					report_exception( ctx );
+				}
+			}
+
+			static void x_final( sqlite3_context *ctx ) noexcept {
+				x_value( ctx );
+				auto *slot =
+				  static_cast<slot_type *>( sqlite3_aggregate_context( ctx, 0 ) );
+				if( slot and slot->constructed ) {
+					std::destroy_at( &slot->state( ) );
+					slot->constructed = false;
+				}
+			}
+
+			static void destroy( void *ptr ) noexcept {
+				delete static_cast<aggregate_function *>( ptr );
+			}
+		};
+
+		template<typename Fn>
+		void register_scalar( sqlite3 *db, daw::string_view name, Fn &&fn,
+		                      function_options const &options ) {
+			using function_t = scalar_function<std::decay_t<Fn>>;
+			auto ptr = std::make_unique<function_t>( function_t{ DAW_FWD( fn ) } );
+			create_function( db,
+			                 name,
+			                 static_cast<int>(
+			                   std::tuple_size_v<typename function_t::args_type> ),
+			                 options,
+			                 ptr.release( ),
+			                 &function_t::x_func,
+			                 nullptr,
+			                 nullptr,
+			                 nullptr,
+			                 nullptr,
+			                 &function_t::destroy );
+		}
+
+		template<typename Init, typename Step, typename Final, typename Inverse>
+		void register_aggregate( sqlite3 *db, daw::string_view name, Init &&init,
+		                         Step &&step, Final &&final, Inverse &&inverse,
+		                         function_options const &options ) {
+			using function_t =
+			  aggregate_function<std::decay_t<Init>, std::decay_t<Step>,
+			                     std::decay_t<Final>, std::decay_t<Inverse>>;
+			constexpr auto is_window =
+			  not std::is_same_v<std::decay_t<Inverse>, std::nullptr_t>;
+			auto ptr = std::make_unique<function_t>( function_t{
+			  DAW_FWD( init ), DAW_FWD( step ), DAW_FWD( final ), DAW_FWD( inverse ) } );
+			create_function(
+			  db,
+			  name,
+			  static_cast<int>( std::tuple_size_v<typename function_t::step_args> - 1U ),
+			  options,
+			  ptr.release( ),
+			  nullptr,
+			  &function_t::x_step,
+			  &function_t::x_final,
+			  is_window ? &function_t::x_value : nullptr,
+			  is_window ? &function_t::x_inverse : nullptr,
+			  &function_t::destroy );
+		}
+	} // namespace function_impl
+} // namespace daw::sqlite
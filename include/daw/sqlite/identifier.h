@@ -0,0 +1,21 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include <daw/daw_string_view.h>
+
+#include <string>
+
+namespace daw::sqlite::sql_impl {
+	/***
+	 * @brief name as a double quoted SQL identifier, with embedded quotes
+	 * doubled, so it can be spliced into generated SQL
+	 */
+	[[nodiscard]] std::string quote_identifier( daw::string_view name );
+} // namespace daw::sqlite::sql_impl
@@ -0,0 +1,78 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace daw::db {
+	struct lru_cache_stats {
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+		std::size_t evictions = 0;
+	};
+
+	/***
+	 * @brief A least recently used map of encoded keys to encoded values bounded
+	 * by the bytes its entries use.  Not thread safe
+	 */
+	class lru_cache {
+		struct entry_t {
+			std::string key;
+			std::string value;
+		};
+		using entries_t = std::list<entry_t>;
+
+		// Keys are views into the key member of the list nodes, which are stable
+		entries_t m_entries{ };
+		std::unordered_map<std::string_view, entries_t::iterator> m_index{ };
+		std::size_t m_bytes = 0;
+		std::size_t m_capacity_bytes = 0;
+		lru_cache_stats m_stats{ };
+
+		void evict_to( std::size_t bytes );
+
+	public:
+		explicit lru_cache( ) = default;
+		explicit lru_cache( std::size_t capacity_bytes );
+
+		/***
+		 * @brief The bytes an entry is charged for, its key and value plus the
+		 * bookkeeping of the list node and index
+		 */
+		[[nodiscard]] static std::size_t entry_bytes( std::size_t key_size,
+		                                              std::size_t value_size );
+
+		/***
+		 * @brief The cached value of key, marking it most recently used.  The
+		 * pointer is valid until the cache is next modified
+		 */
+		[[nodiscard]] std::string const *find( std::string_view key );
+
+		/***
+		 * @brief Store value for key, evicting the least recently used entries
+		 * to stay within the capacity.  Entries larger than the capacity are not
+		 * kept
+		 */
+		void insert_or_assign( std::string_view key, std::string_view value );
+
+		bool erase( std::string_view key );
+		void clear( );
+
+		void set_capacity_bytes( std::size_t capacity_bytes );
+		[[nodiscard]] std::size_t capacity_bytes( ) const;
+		[[nodiscard]] std::size_t bytes( ) const;
+		[[nodiscard]] std::size_t size( ) const;
+		[[nodiscard]] lru_cache_stats const &stats( ) const;
+		void reset_stats( );
+	};
+} // namespace daw::db
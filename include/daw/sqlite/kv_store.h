@@ -8,34 +8,283 @@
 
 #pragma once
 
+#include "daw/sqlite/kv_lru_cache.h"
+#include "daw/sqlite/open_options.h"
+#include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
 #include <daw/daw_string_view.h>
 
 #include <concepts>
-#include <sstream>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <ranges>
+#include <span>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace daw::db {
-	struct kv_store {
-		explicit kv_store( daw::string_view filename );
-		virtual ~kv_store( );
-		[[nodiscard]] std::string operator( )( size_t hash );
-
-		template<typename Key>
-			requires( not std::same_as<std::size_t, Key> )
-		[[nodiscard]] std::string operator( )( Key key ) {
-			static std::hash<Key> const hash{};
-			return get( hash( key ) );
-		}
-
-		template<typename Key, typename Value>
-			requires( not std::same_as<std::string, Value> )
-		[[nodiscard]] Value operator( )( Key key ) const {
-			std::stringstream ss;
-			auto tmp = get( hash( key ) );
-			ss << tmp;
-			Value result;
-			ss >> result;
+	/***
+	 * @brief Binary encoding of keys and values.  Specialize with
+	 * static void encode( T const &, std::string &out ) appending the bytes of
+	 * the value, and static T decode( daw::string_view bytes ) when the type can
+	 * be read back
+	 */
+	template<typename T>
+	struct kv_codec;
+
+	namespace kv_impl {
+		/***
+		 * @brief Types whose bytes refer to memory elsewhere, storing them would
+		 * store an address
+		 */
+		template<typename T>
+		inline constexpr bool is_view_v =
+		  std::is_pointer_v<T> or std::is_member_pointer_v<T> or
+		  std::ranges::view<T> or std::ranges::borrowed_range<T> or
+		  std::same_as<T, sqlite::types::blob_t> or
+		  std::same_as<T, sqlite::types::text_t>;
+	} // namespace kv_impl
+
+	/***
+	 * @brief Trivially copyable types where equal values have equal bytes, i.e.
+	 * without padding or floating point members, are stored as their object
+	 * representation.  Pointers and views are not, nor can a class holding a
+	 * pointer be detected, those need their own codec
+	 */
+	template<typename T>
+		requires( std::is_trivially_copyable_v<T> and
+		          std::has_unique_object_representations_v<T> and
+		          not kv_impl::is_view_v<T> )
+	struct kv_codec<T> {
+		static void encode( T const &value, std::string &out ) {
+			out.append( reinterpret_cast<char const *>( &value ), sizeof( T ) );
+		}
+
+		[[nodiscard]] static T decode( daw::string_view bytes ) {
+			if( bytes.size( ) != sizeof( T ) ) {
+				throw sqlite::sqlite3_exception(
+				  "Stored value size does not match the requested type" );
+			}
+			T result;
+			std::memcpy( &result, bytes.data( ), sizeof( T ) );
 			return result;
 		}
 	};
-}
\ No newline at end of file
+
+	template<>
+	struct kv_codec<std::string> {
+		static void encode( std::string const &value, std::string &out ) {
+			out.append( value );
+		}
+
+		[[nodiscard]] static std::string decode( daw::string_view bytes ) {
+			return std::string( bytes.data( ), bytes.size( ) );
+		}
+	};
+
+	template<>
+	struct kv_codec<std::string_view> {
+		static void encode( std::string_view value, std::string &out ) {
+			out.append( value );
+		}
+	};
+
+	template<>
+	struct kv_codec<daw::string_view> {
+		static void encode( daw::string_view value, std::string &out ) {
+			out.append( value.data( ), value.size( ) );
+		}
+	};
+
+	template<>
+	struct kv_codec<char const *> {
+		static void encode( char const *value, std::string &out ) {
+			out.append( value );
+		}
+	};
+
+	template<>
+	struct kv_codec<char *> : kv_codec<char const *> {};
+
+	template<>
+	struct kv_codec<std::vector<std::byte>> {
+		static void encode( std::vector<std::byte> const &value,
+		                    std::string &out ) {
+			out.append( reinterpret_cast<char const *>( value.data( ) ),
+			            value.size( ) );
+		}
+
+		[[nodiscard]] static std::vector<std::byte>
+		decode( daw::string_view bytes ) {
+			auto const *first = reinterpret_cast<std::byte const *>( bytes.data( ) );
+			return std::vector<std::byte>( first, first + bytes.size( ) );
+		}
+	};
+
+	template<typename T>
+	concept KVEncodable = requires( T const &value, std::string &out ) {
+		kv_codec<std::decay_t<T>>::encode( value, out );
+	};
+
+	template<typename T>
+	concept KVDecodable = requires( daw::string_view bytes ) {
+		{ kv_codec<T>::decode( bytes ) } -> std::same_as<T>;
+	};
+
+	template<KVEncodable T>
+	[[nodiscard]] std::string kv_encode( T const &value ) {
+		auto result = std::string( );
+		kv_codec<std::decay_t<T>>::encode( value, result );
+		return result;
+	}
+
+	struct kv_store_options {
+		/// Table holding the pairs, created when missing
+		std::string table = "kv_store";
+		sqlite::open_options open = sqlite::open_options::read_heavy( );
+		/// Byte budget of the in memory read through cache, 0 disables it
+		std::size_t read_cache_bytes = 0;
+	};
+
+	/***
+	 * @brief A key/value store in a WITHOUT ROWID table of BLOB keys and values.
+	 * Keys and values are encoded with kv_codec.  The get, put and erase
+	 * statements are prepared once and reused.  A store is a single connection
+	 * and must only be used by one thread at a time.
+	 * When the read cache is enabled, writes update it, or invalidate the key
+	 * when they are made inside a caller's transaction so that a rollback
+	 * cannot leave stale values cached
+	 */
+	class kv_store {
+		sqlite::database m_db{ };
+		sqlite::shared_prepared_statement m_get{ };
+		sqlite::shared_prepared_statement m_put{ };
+		sqlite::shared_prepared_statement m_erase{ };
+		std::optional<lru_cache> m_cache{ };
+
+		[[nodiscard]] std::optional<std::string> fetch( daw::string_view key );
+		void store( daw::string_view key, daw::string_view value );
+
+	public:
+		explicit kv_store( std::filesystem::path const &filename,
+		                   kv_store_options const &options = kv_store_options{ } );
+		virtual ~kv_store( );
+
+		kv_store( kv_store && ) noexcept = default;
+		kv_store &operator=( kv_store && ) noexcept = default;
+
+		/***
+		 * @brief The stored bytes of an encoded key
+		 */
+		[[nodiscard]] std::optional<std::string>
+		get_encoded( daw::string_view key );
+
+		void put_encoded( daw::string_view key, daw::string_view value );
+
+		/***
+		 * @return true when the key existed
+		 */
+		bool erase_encoded( daw::string_view key );
+
+		/***
+		 * @brief Look up every key within one read transaction.  The result is in
+		 * the order of keys
+		 */
+		[[nodiscard]] std::vector<std::optional<std::string>>
+		get_many_encoded( std::span<std::string const> keys );
+
+		/***
+		 * @brief Store every pair within one write transaction
+		 */
+		void put_many_encoded(
+		  std::span<std::pair<std::string, std::string> const> pairs );
+
+		template<KVDecodable Value = std::string, KVEncodable Key>
+		[[nodiscard]] std::optional<Value> get( Key const &key ) {
+			auto bytes = get_encoded( kv_encode( key ) );
+			if( not bytes ) {
+				return std::nullopt;
+			}
+			if constexpr( std::same_as<Value, std::string> ) {
+				return bytes;
+			} else {
+				return kv_codec<Value>::decode( *bytes );
+			}
+		}
+
+		template<KVEncodable Key, KVEncodable Value>
+		void put( Key const &key, Value const &value ) {
+			put_encoded( kv_encode( key ), kv_encode( value ) );
+		}
+
+		template<KVEncodable Key>
+		bool erase( Key const &key ) {
+			return erase_encoded( kv_encode( key ) );
+		}
+
+		template<KVEncodable Key>
+		[[nodiscard]] bool contains( Key const &key ) {
+			return get_encoded( kv_encode( key ) ).has_value( );
+		}
+
+		/***
+		 * @brief The value of key, or an empty string when it is not stored
+		 */
+		template<KVEncodable Key>
+		[[nodiscard]] std::string operator( )( Key const &key ) {
+			return get_encoded( kv_encode( key ) ).value_or( std::string( ) );
+		}
+
+		template<KVDecodable Value = std::string, std::ranges::input_range Keys>
+			requires( KVEncodable<std::ranges::range_value_t<Keys>> )
+		[[nodiscard]] std::vector<std::optional<Value>>
+		get_many( Keys const &keys ) {
+			auto encoded = std::vector<std::string>( );
+			for( auto const &key : keys ) {
+				encoded.push_back( kv_encode( key ) );
+			}
+			auto values = get_many_encoded( encoded );
+			if constexpr( std::same_as<Value, std::string> ) {
+				return values;
+			} else {
+				auto result = std::vector<std::optional<Value>>( );
+				result.reserve( values.size( ) );
+				for( auto const &value : values ) {
+					if( value ) {
+						result.emplace_back( kv_codec<Value>::decode( *value ) );
+					} else {
+						result.emplace_back( );
+					}
+				}
+				return result;
+			}
+		}
+
+		/***
+		 * @brief Store a range of pairs, or tuples of key and value, within one
+		 * write transaction
+		 */
+		template<std::ranges::input_range Pairs>
+		void put_many( Pairs const &pairs ) {
+			auto encoded = std::vector<std::pair<std::string, std::string>>( );
+			for( auto const &pair : pairs ) {
+				auto const &[key, value] = pair;
+				encoded.emplace_back( kv_encode( key ), kv_encode( value ) );
+			}
+			put_many_encoded( encoded );
+		}
+
+		[[nodiscard]] sqlite::database &get_database( );
+
+		/***
+		 * @brief Counters of the read cache, all 0 when it is disabled
+		 */
+		[[nodiscard]] lru_cache_stats cache_stats( ) const;
+	};
+} // namespace daw::db
@@ -0,0 +1,79 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/busy_policy.h"
+#include "daw/sqlite/statement_cache.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace daw::sqlite {
+	enum class journal_mode { Delete, Truncate, Persist, Memory, WAL, Off };
+	enum class synchronous_mode { Off, Normal, Full, Extra };
+	enum class temp_store_mode { Default, File, Memory };
+
+	/***
+	 * @brief How a database connection is opened and configured.  Pragmas left
+	 * unset keep sqlite's, or the database file's, current setting
+	 */
+	struct open_options {
+		/// SQLITE_OPEN_READONLY instead of SQLITE_OPEN_READWRITE
+		bool read_only = false;
+		/// SQLITE_OPEN_CREATE, ignored when read_only
+		bool create = true;
+		/// SQLITE_OPEN_NOMUTEX, the connection must only be used by one thread at
+		/// a time
+		bool no_mutex = false;
+		/// SQLITE_OPEN_SHAREDCACHE
+		bool shared_cache = false;
+		/// SQLITE_OPEN_URI, the filename is interpreted as a URI
+		bool uri = false;
+
+		/// PRAGMA page_size, only has an effect before the database is created
+		std::optional<std::int64_t> page_size{ };
+		/// PRAGMA journal_mode, not applied to read only connections
+		std::optional<journal_mode> journal{ };
+		/// PRAGMA synchronous
+		std::optional<synchronous_mode> synchronous{ };
+		/// PRAGMA cache_size, positive values are pages and negative values KiB
+		std::optional<std::int64_t> cache_size{ };
+		/// PRAGMA mmap_size in bytes
+		std::optional<std::int64_t> mmap_size{ };
+		/// PRAGMA temp_store
+		std::optional<temp_store_mode> temp_store{ };
+		/// sqlite3_busy_timeout
+		std::optional<std::chrono::milliseconds> busy_timeout{ };
+		/// Backoff and retry on lock contention, replaces busy_timeout when set
+		std::optional<busy_policy> busy{ };
+
+		/// Capacity of the connection's statement cache
+		std::size_t statement_cache_capacity = statement_cache::default_capacity;
+
+		/***
+		 * @brief The flags to pass to sqlite3_open_v2
+		 */
+		[[nodiscard]] int flags( ) const;
+
+		/***
+		 * @brief WAL with synchronous=NORMAL, a 256MiB mmap, a 64MiB page cache,
+		 * in memory temporary storage and a 5s busy timeout
+		 */
+		[[nodiscard]] static open_options read_heavy( );
+
+		/***
+		 * @brief WAL with synchronous=OFF, a 256MiB page cache and in memory
+		 * temporary storage.  Durability is traded for write throughput, a power
+		 * loss or OS crash can lose or corrupt recent transactions
+		 */
+		[[nodiscard]] static open_options bulk_load( );
+	};
+} // namespace daw::sqlite
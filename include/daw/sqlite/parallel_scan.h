@@ -0,0 +1,151 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/connection_pool.h"
+#include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/row_cursor.h"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace daw::sqlite {
+	/***
+	 * @brief A range of keys scanned by one call, first and last are inclusive
+	 */
+	struct scan_partition {
+		std::size_t index = 0;
+		std::int64_t first = 0;
+		std::int64_t last = 0;
+	};
+
+	struct parallel_scan_options {
+		/// The table scanned
+		std::string table{ };
+		/// The result columns, SQL text placed between SELECT and FROM
+		std::string columns = "*";
+		/// An integer column the range is split on, ideally the rowid or indexed
+		std::string key_column = "rowid";
+		/// An extra condition rows must meet, SQL text.  Empty for none
+		std::string where{ };
+		/// The range of keys scanned, the minimum and maximum key when not set
+		std::optional<std::int64_t> first_key{ };
+		std::optional<std::int64_t> last_key{ };
+		/// Number of partitions, more than threads so fast workers take more of
+		/// them.  0 uses 4 per thread
+		std::size_t partition_count = 0;
+		/// Number of threads, at most the pool's reader count.  0 uses all of
+		/// the readers.  Only readers idle when the scan starts are used
+		std::size_t thread_count = 0;
+		/// Throw when the partitions cannot be read from one snapshot because
+		/// sqlite was built without SQLITE_ENABLE_SNAPSHOT.  When false each
+		/// thread reads the database as of when it started instead
+		bool require_snapshot = true;
+	};
+
+	/***
+	 * @brief Can every partition of a scan be read from the same snapshot
+	 */
+	[[nodiscard]] bool parallel_scan_has_snapshots( );
+
+	/***
+	 * @brief Split [first, last] into at most count ranges of nearly equal size
+	 */
+	[[nodiscard]] std::vector<scan_partition>
+	make_partitions( std::int64_t first, std::int64_t last, std::size_t count );
+
+	namespace scan_impl {
+		/// Called once, before any partition is scanned
+		using plan_fn = std::function<void( std::span<scan_partition const> )>;
+		/// Called for each partition with the statement selecting its rows
+		/// bound and ready to step
+		using partition_fn = std::function<void( scan_partition const &,
+		                                         shared_prepared_statement & )>;
+
+		void run( connection_pool &pool, parallel_scan_options const &options,
+		          plan_fn const &on_plan, partition_fn const &on_partition );
+	} // namespace scan_impl
+
+	/***
+	 * @brief Scan the table in partitions of the key range on several read
+	 * connections of pool at once.  One connection opens a read transaction.
+	 * With snapshot support the others open the same WAL snapshot, so every
+	 * partition sees the same database, otherwise see require_snapshot.  A
+	 * thread that finds no idle reader does not wait for one.  Threads take
+	 * the next unscanned partition as they finish one.  on_row( row_cursor const &, scan_partition const & ) is called
+	 * from the scanning threads concurrently.  The first exception thrown
+	 * stops the scan and is rethrown
+	 */
+	template<typename OnRow>
+		requires( std::invocable<OnRow &, row_cursor const &,
+		                         scan_partition const &> ) //
+	void parallel_scan( connection_pool &pool,
+	                    parallel_scan_options const &options,
+	                    OnRow &&on_row ) {
+		scan_impl::run(
+		  pool,
+		  options,
+		  []( std::span<scan_partition const> ) {},
+		  [&]( scan_partition const &partition,
+		       shared_prepared_statement &statement ) {
+			  auto const cursor = row_cursor( statement );
+			  while( statement.step( ) ) {
+				  on_row( cursor, partition );
+			  }
+		  } );
+	}
+
+	/***
+	 * @brief Scan as parallel_scan, folding the rows of each partition into a
+	 * State made by init( ) with on_row( State &, row_cursor const & ).  The
+	 * partition states are then combined in key order with
+	 * merge( State &into, State &&from ), so the result does not depend on
+	 * which thread scanned what.  init and on_row are called from the scanning
+	 * threads concurrently, merge from the calling thread
+	 */
+	template<typename Init, typename OnRow, typename Merge,
+	         typename State = std::invoke_result_t<Init &>>
+		requires( std::invocable<OnRow &, State &, row_cursor const &> and
+		          std::invocable<Merge &, State &, State &&> ) //
+	[[nodiscard]] State parallel_reduce( connection_pool &pool,
+	                                     parallel_scan_options const &options,
+	                                     Init init, OnRow on_row, Merge merge ) {
+		auto states = std::vector<std::optional<State>>( );
+		scan_impl::run(
+		  pool,
+		  options,
+		  [&]( std::span<scan_partition const> partitions ) {
+			  states.resize( partitions.size( ) );
+		  },
+		  [&]( scan_partition const &partition,
+		       shared_prepared_statement &statement ) {
+			  auto state = init( );
+			  auto const cursor = row_cursor( statement );
+			  while( statement.step( ) ) {
+				  on_row( state, cursor );
+			  }
+			  states[partition.index] = std::move( state );
+		  } );
+		auto result = init( );
+		for( auto &state : states ) {
+			if( state ) {
+				merge( result, std::move( *state ) );
+			}
+		}
+		return result;
+	}
+} // namespace daw::sqlite
@@ -0,0 +1,219 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/bind_helpers.h"
+#include "daw/sqlite/cell_value.h"
+#include "daw/sqlite/column_traits.h"
+#include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <daw/daw_string_view.h>
+
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <sqlite3.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace daw::sqlite {
+	/***
+	 * @brief Describes how to bind a C++ type to a statement parameter without
+	 * going through cell_value.  Specializations provide
+	 * 	static int bind( sqlite3_stmt *, int index, T const &, bind_lifetime ) -
+	 * 		bind the value, returning the sqlite result code
+	 * 	static std::size_t size( T const & ) - the number of bytes the value
+	 * 		occupies in the database, approximately
+	 */
+	template<typename T>
+	struct parameter_traits;
+
+	template<std::integral T>
+	struct parameter_traits<T> {
+		static int bind( sqlite3_stmt *stmt, int index, T value, bind_lifetime ) {
+			return sqlite3_bind_int64( stmt,
+			                           index,
+			                           static_cast<sqlite3_int64>( value ) );
+		}
+
+		static constexpr std::size_t size( T ) {
+			return sizeof( sqlite3_int64 );
+		}
+	};
+
+	template<std::floating_point T>
+	struct parameter_traits<T> {
+		static int bind( sqlite3_stmt *stmt, int index, T value, bind_lifetime ) {
+			return sqlite3_bind_double( stmt, index, static_cast<double>( value ) );
+		}
+
+		static constexpr std::size_t size( T ) {
+			return sizeof( double );
+		}
+	};
+
+	template<>
+	struct parameter_traits<std::nullptr_t> {
+		static int bind( sqlite3_stmt *stmt, int index, std::nullptr_t,
+		                 bind_lifetime ) {
+			return sqlite3_bind_null( stmt, index );
+		}
+
+		static constexpr std::size_t size( std::nullptr_t ) {
+			return 0;
+		}
+	};
+
+	template<typename T>
+		requires( std::same_as<T, std::string_view> or
+		          std::same_as<T, std::string> or
+		          std::same_as<T, types::text_t> ) //
+	struct parameter_traits<T> {
+		static int bind( sqlite3_stmt *stmt, int index, T const &value,
+		                 bind_lifetime lifetime ) {
+			return bind_impl::bind_text(
+				stmt,
+				index,
+				std::string_view( value.data( ), value.size( ) ),
+				lifetime );
+		}
+
+		static std::size_t size( T const &value ) {
+			return value.size( );
+		}
+	};
+
+	template<>
+	struct parameter_traits<char const *> {
+		static int bind( sqlite3_stmt *stmt, int index, char const *value,
+		                 bind_lifetime lifetime ) {
+			if( not value ) {
+				return sqlite3_bind_null( stmt, index );
+			}
+			return bind_impl::bind_text( stmt, index, std::string_view( value ), lifetime );
+		}
+
+		static std::size_t size( char const *value ) {
+			return value ? std::string_view( value ).size( ) : 0;
+		}
+	};
+
+	template<typename T>
+		requires( std::same_as<T, types::blob_t> or
+		          std::same_as<T, std::vector<std::byte>> or
+		          std::same_as<T, std::span<std::byte const>> ) //
+	struct parameter_traits<T> {
+		static int bind( sqlite3_stmt *stmt, int index, T const &value,
+		                 bind_lifetime lifetime ) {
+			return bind_impl::bind_blob(
+				stmt,
+				index,
+				std::span<std::byte const>( value.data( ), value.size( ) ),
+				lifetime );
+		}
+
+		static std::size_t size( T const &value ) {
+			return value.size( );
+		}
+	};
+
+	template<>
+	struct parameter_traits<zeroblob> {
+		static int bind( sqlite3_stmt *stmt, int index, zeroblob value,
+		                 bind_lifetime ) {
+			return sqlite3_bind_zeroblob64( stmt, index, value.size );
+		}
+
+		static constexpr std::size_t size( zeroblob value ) {
+			return static_cast<std::size_t>( value.size );
+		}
+	};
+
+	template<typename T>
+	struct parameter_traits<std::optional<T>> {
+		static int bind( sqlite3_stmt *stmt, int index,
+		                 std::optional<T> const &value, bind_lifetime lifetime ) {
+			if( not value ) {
+				return sqlite3_bind_null( stmt, index );
+			}
+			return parameter_traits<T>::bind( stmt, index, *value, lifetime );
+		}
+
+		static std::size_t size( std::optional<T> const &value ) {
+			return value ? parameter_traits<T>::size( *value ) : 0;
+		}
+	};
+
+	template<typename T>
+	concept Parameter = requires( sqlite3_stmt *stmt, T const &value ) {
+		{
+			parameter_traits<T>::bind( stmt, 1, value, bind_lifetime::Static )
+		} -> std::same_as<int>;
+		{ parameter_traits<T>::size( value ) } -> std::convertible_to<std::size_t>;
+	};
+
+	/***
+	 * @brief Bind value to the parameter index, throwing on error
+	 */
+	template<Parameter T>
+	void bind_parameter( sqlite3_stmt *stmt, int index, T const &value,
+	                     bind_lifetime lifetime ) {
+		auto const rc = parameter_traits<T>::bind( stmt, index, value, lifetime );
+		if( rc != SQLITE_OK ) {
+			throw sqlite3_exception( rc );
+		}
+	}
+
+	template<typename Row>
+	concept ParameterRow =
+		column_impl::is_tuple_v<Row> or requires( Row const &row ) {
+			{ row_contract<Row>::to_tuple( row ) };
+		};
+
+	/***
+	 * @brief The values of a row as a tuple, in column order.  Classes with a
+	 * row_contract must provide to_tuple
+	 */
+	template<ParameterRow Row>
+	[[nodiscard]] decltype( auto ) row_parameters( Row const &row ) {
+		if constexpr( column_impl::is_tuple_v<Row> ) {
+			return ( row );
+		} else {
+			return row_contract<Row>::to_tuple( row );
+		}
+	}
+
+	/***
+	 * @brief Bind each value of row to consecutive parameters starting at
+	 * first_index
+	 * @return The approximate number of bytes bound
+	 */
+	template<ParameterRow Row>
+	std::size_t bind_row( sqlite3_stmt *stmt, int first_index, Row const &row,
+	                      bind_lifetime lifetime ) {
+		return std::apply(
+			[&]( auto const &...values ) {
+				int index = first_index;
+				std::size_t bytes = 0;
+				auto const bind_one = [&]<typename T>( T const &value ) {
+					bind_parameter( stmt, index++, value, lifetime );
+					bytes += parameter_traits<T>::size( value );
+				};
+				( bind_one( values ), ... );
+				return bytes;
+			},
+			row_parameters( row ) );
+	}
+} // namespace daw::sqlite
@@ -13,27 +13,78 @@
 
 #include <daw/daw_string_view.h>
 
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
 
 typedef struct sqlite3_stmt sqlite3_stmt;
 
 namespace daw::sqlite {
 	class database;
 
+	namespace busy_impl {
+		struct busy_state;
+	} // namespace busy_impl
+
 	namespace ps_impl {
 		struct sqlite3_stmt_deleter {
 			void operator( )( sqlite3_stmt *ptr ) const;
 		};
+
+		/***
+		 * @brief Buffers moved into a statement by bind, keyed by parameter index.
+		 * The map nodes are stable so the bound data pointers stay valid
+		 */
+		using owned_buffers_t =
+			std::map<std::size_t,
+			         std::variant<std::string, std::vector<std::byte>>>;
+
+		struct shared_statement_state {
+			owned_buffers_t owned_buffers{};
+			std::unique_ptr<sqlite3_stmt, sqlite3_stmt_deleter> statement = nullptr;
+			// The busy policy and counters of the connection it was prepared on
+			std::shared_ptr<busy_impl::busy_state> busy = nullptr;
+		};
 	} // namespace ps_impl
 
+	/***
+	 * @brief How sqlite treats the memory of a bound text or blob value
+	 */
+	enum class bind_lifetime {
+		/// The caller guarantees the buffer outlives the binding, no copy is made
+		Static,
+		/// sqlite makes its own copy of the buffer during the bind
+		Transient
+	};
+
+	/***
+	 * @brief A parameter bound as a blob of size zero bytes with
+	 * sqlite3_bind_zeroblob64, without allocating it.  The space is then filled
+	 * through a blob_stream
+	 */
+	struct zeroblob {
+		std::uint64_t size = 0;
+	};
+
 	class shared_prepared_statement;
 
 	template<typename... Ts>
-	concept Parameters = ( constructible_from<cell_value, Ts> and ... );
+	concept Parameters =
+	  ( ( constructible_from<cell_value, Ts> or
+	      std::same_as<std::remove_cvref_t<Ts>, zeroblob> ) and
+	    ... );
 
 	class prepared_statement {
+		ps_impl::owned_buffers_t m_owned_buffers{};
 		std::unique_ptr<sqlite3_stmt, ps_impl::sqlite3_stmt_deleter> m_statement =
 			nullptr;
+		std::shared_ptr<busy_impl::busy_state> m_busy = nullptr;
 
 	public:
 		using i_am_a_prepared_statement = void;
@@ -48,10 +99,18 @@ namespace daw::sqlite {
 		prepared_statement( database &db, daw::string_view sql, Param &&param,
 		                    Params &&... params )
 			: prepared_statement( db, sql ) {
-			[&]<std::size_t... Is>( std::index_sequence<Is...> ) {
-				bind( 1, cell_value( DAW_FWD( param ) ) );
-				(void)( ( bind( Is + 2, DAW_FWD( params ) ), 1 ) + ... + 0 );
-			}( std::make_index_sequence<sizeof...( Params )>{} );
+			bind_parameters( DAW_FWD( param ), DAW_FWD( params )... );
+		}
+
+		/***
+		 * @brief Bind each parameter to the placeholders 1 through N in order.
+		 * Rvalue std::string's are moved into the statement instead of copied
+		 */
+		template<typename... Params>
+			requires( Parameters<Params...> ) //
+		void bind_parameters( Params &&... params ) {
+			std::size_t index = 0;
+			( bind_parameter( ++index, DAW_FWD( params ) ), ... );
 		}
 
 		[[nodiscard]] sqlite3_stmt *get( );
@@ -77,9 +136,40 @@ namespace daw::sqlite {
 		void reset( );
 		void reset_to_default_init( );
 
+		/***
+		 * @brief Bind a value, text and blobs are copied by sqlite
+		 */
 		void bind( std::size_t index, cell_value const &value );
 		void bind( std::size_t index ); // bind a null to that value
 
+		/***
+		 * @brief Bind text or a blob without our own copy.  With Static the buffer
+		 * must stay valid until it is rebound, the bindings are cleared, or the
+		 * statement is finalized
+		 */
+		void bind( std::size_t index, types::text_t value, bind_lifetime lifetime );
+		void bind( std::size_t index, types::blob_t value, bind_lifetime lifetime );
+
+		/***
+		 * @brief Bind text or a blob, taking ownership of the buffer.  The buffer
+		 * lives as long as the binding, no copy is made
+		 */
+		void bind( std::size_t index, std::string &&value );
+		void bind( std::size_t index, std::vector<std::byte> &&value );
+
+		void bind( std::size_t index, zeroblob value );
+
+		template<typename Param>
+		void bind_parameter( std::size_t index, Param &&param ) {
+			if constexpr( std::same_as<Param, std::string> ) {
+				bind( index, std::move( param ) );
+			} else if constexpr( std::same_as<std::remove_cvref_t<Param>, zeroblob> ) {
+				bind( index, param );
+			} else {
+				bind( index, cell_value( DAW_FWD( param ) ) );
+			}
+		}
+
 		explicit operator bool( ) const {
 			return static_cast<bool>(m_statement);
 		}
@@ -98,7 +188,7 @@ namespace daw::sqlite {
 	};
 
 	class shared_prepared_statement {
-		std::shared_ptr<sqlite3_stmt> m_statement = nullptr;
+		std::shared_ptr<ps_impl::shared_statement_state> m_state = nullptr;
 
 	public:
 		using i_am_a_prepared_statement = void;
@@ -112,11 +202,18 @@ namespace daw::sqlite {
 		shared_prepared_statement( database &db, daw::string_view sql,
 		                           Param &&param, Params &&... params )
 			: shared_prepared_statement( db, sql ) {
-			[&]<std::size_t... Is>( std::index_sequence<Is...> ) {
-				bind( 1, cell_value( DAW_FWD( param ) ) );
-				(void)( ( bind( Is + 2, cell_value( DAW_FWD( params ) ) ), 1 ) + ... + 0
-				);
-			}( std::make_index_sequence<sizeof...( Params )>{} );
+			bind_parameters( DAW_FWD( param ), DAW_FWD( params )... );
+		}
+
+		/***
+		 * @brief Bind each parameter to the placeholders 1 through N in order.
+		 * Rvalue std::string's are moved into the statement instead of copied
+		 */
+		template<typename... Params>
+			requires( Parameters<Params...> ) //
+		void bind_parameters( Params &&... params ) {
+			std::size_t index = 0;
+			( bind_parameter( ++index, DAW_FWD( params ) ), ... );
 		}
 
 		[[nodiscard]] sqlite3_stmt *get( );
@@ -142,22 +239,74 @@ namespace daw::sqlite {
 		void reset( );
 		void reset_to_default_init( );
 
+		/***
+		 * @brief Bind a value, text and blobs are copied by sqlite
+		 */
 		void bind( std::size_t index, cell_value const &value );
 		void bind( std::size_t index ); // bind a null to that value
 
+		/***
+		 * @brief Bind text or a blob without our own copy.  With Static the buffer
+		 * must stay valid until it is rebound, the bindings are cleared, or the
+		 * statement is finalized
+		 */
+		void bind( std::size_t index, types::text_t value, bind_lifetime lifetime );
+		void bind( std::size_t index, types::blob_t value, bind_lifetime lifetime );
+
+		/***
+		 * @brief Bind text or a blob, taking ownership of the buffer.  The buffer
+		 * lives as long as the binding, no copy is made
+		 */
+		void bind( std::size_t index, std::string &&value );
+		void bind( std::size_t index, std::vector<std::byte> &&value );
+
+		void bind( std::size_t index, zeroblob value );
+
+		template<typename Param>
+		void bind_parameter( std::size_t index, Param &&param ) {
+			if constexpr( std::same_as<Param, std::string> ) {
+				bind( index, std::move( param ) );
+			} else if constexpr( std::same_as<std::remove_cvref_t<Param>, zeroblob> ) {
+				bind( index, param );
+			} else {
+				bind( index, cell_value( DAW_FWD( param ) ) );
+			}
+		}
+		void clear_bindings( );
+
+		/***
+		 * @brief Advance to the next row of the result.  A first step that fails
+		 * with SQLITE_BUSY is retried as the connection's busy_policy allows
+		 * @return true if a row is available, false when the result is done
+		 */
+		[[nodiscard]] bool step( );
+
+		/***
+		 * @brief The number of owners sharing the underlying statement
+		 */
+		[[nodiscard]] long use_count( ) const;
+
+		/***
+		 * @brief Share the statement through a handle that resets it and clears
+		 * its bindings when the handle's last copy is destroyed, so a result
+		 * dropped before it is done does not keep its read transaction open.
+		 * An outstanding handle counts once in use_count( )
+		 */
+		[[nodiscard]] shared_prepared_statement lease( ) const;
+
 		explicit operator bool( ) const {
-			return static_cast<bool>(m_statement);
+			return m_state and m_state->statement;
 		}
 
 		// clang-format off
 		[[nodiscard]] auto operator<=>( shared_prepared_statement const &rhs ) const {
-			return m_statement.get( ) <=> rhs.m_statement.get( );
+			return m_state.get( ) <=> rhs.m_state.get( );
 		}
 		// clang-format on
 
 		[[nodiscard]] bool operator
 		==( shared_prepared_statement const &rhs ) const {
-			return m_statement.get( ) == rhs.m_statement.get( );
+			return m_state.get( ) == rhs.m_state.get( );
 		}
 
 		[[nodiscard]] bool operator!=( shared_prepared_statement const & ) const
@@ -0,0 +1,150 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace daw::sqlite {
+	/***
+	 * @brief A log-linear histogram of latencies.  Each power of two is split
+	 * into 8 buckets, so percentiles are within 12.5% of the recorded values
+	 */
+	class latency_histogram {
+	public:
+		static constexpr std::size_t sub_buckets = 8;
+		static constexpr std::size_t bucket_count = 512;
+
+	private:
+		std::array<std::uint64_t, bucket_count> m_buckets{ };
+		std::uint64_t m_count = 0;
+		std::chrono::nanoseconds m_total{ 0 };
+		std::chrono::nanoseconds m_max{ 0 };
+
+	public:
+		void record( std::chrono::nanoseconds latency );
+
+		[[nodiscard]] std::uint64_t count( ) const;
+		[[nodiscard]] std::chrono::nanoseconds total( ) const;
+		[[nodiscard]] std::chrono::nanoseconds max( ) const;
+
+		/***
+		 * @param q The quantile, between 0 and 1
+		 * @return The upper bound of the bucket holding the q'th latency, at most
+		 * max( )
+		 */
+		[[nodiscard]] std::chrono::nanoseconds percentile( double q ) const;
+
+		void merge( latency_histogram const &other );
+	};
+
+	/***
+	 * @brief What was recorded for one normalized SQL text
+	 */
+	struct statement_profile {
+		std::string sql;
+		/// Completed runs of statements with this SQL
+		std::uint64_t calls = 0;
+		/// Rows returned over all calls
+		std::uint64_t rows = 0;
+		/// Time from the first step until the statement finished or was reset
+		latency_histogram latency{ };
+		/// sqlite3_stmt_status counters summed over all calls
+		std::uint64_t fullscan_steps = 0;
+		std::uint64_t sorts = 0;
+		std::uint64_t autoindexes = 0;
+		std::uint64_t vm_steps = 0;
+
+		[[nodiscard]] std::chrono::nanoseconds p50( ) const;
+		[[nodiscard]] std::chrono::nanoseconds p99( ) const;
+		[[nodiscard]] std::chrono::nanoseconds max( ) const;
+	};
+
+	struct profiler_options {
+		/// Count rows returned, one trace callback per row
+		bool count_rows = true;
+		/// Read the sqlite3_stmt_status counters after each call
+		bool statement_status = true;
+		/// Distinct SQL texts tracked, further ones are recorded under "<other>"
+		std::size_t max_statements = 1024;
+	};
+
+	/***
+	 * @brief Replace literals with ?, drop comments and collapse whitespace, so
+	 * statements differing only in their constants are profiled together
+	 */
+	[[nodiscard]] std::string normalize_sql( std::string_view sql );
+
+	namespace profile_impl {
+		/***
+		 * @brief The sqlite3_trace_v2 context of a connection.  Recording happens
+		 * on the thread using the connection, snapshots can be taken from any
+		 * thread
+		 */
+		class profiler {
+			profiler_options m_options;
+			mutable std::mutex m_mutex{ };
+			std::unordered_map<std::string, statement_profile> m_profiles{ };
+			// Changed by reset, invalidating the profiles statements point to
+			std::uint64_t m_generation = 0;
+			struct statement_t {
+				// The SQL text key was normalized from, a statement finalized and
+				// another prepared at its address is detected by it differing
+				std::string sql{ };
+				std::string key{ };
+				bool has_key = false;
+				statement_profile *profile = nullptr;
+				std::uint64_t generation = 0;
+				bool is_running = false;
+				std::chrono::steady_clock::time_point start{ };
+				std::uint64_t rows = 0;
+			};
+			// Statements seen, so their SQL is normalized once and not on every
+			// call.  Only touched by the thread using the connection
+			std::unordered_map<sqlite3_stmt *, statement_t> m_statements{ };
+			// Rows of a statement are traced one after another, so the last
+			// statement a row was counted for saves the lookup
+			sqlite3_stmt *m_row_statement = nullptr;
+			statement_t *m_row_entry = nullptr;
+
+			[[nodiscard]] statement_t &entry( sqlite3_stmt *statement );
+
+			void on_start( sqlite3_stmt *statement );
+			void on_row( sqlite3_stmt *statement );
+			void on_profile( sqlite3_stmt *statement, std::int64_t nanoseconds );
+
+		public:
+			explicit profiler( profiler_options const &options );
+
+			[[nodiscard]] profiler_options const &options( ) const;
+			[[nodiscard]] unsigned trace_mask( ) const;
+
+			/***
+			 * @brief The sqlite3_trace_v2 callback, context is a profiler
+			 */
+			static int trace( unsigned type, void *context, void *p, void *x );
+
+			/***
+			 * @brief The profiles sorted by total time, longest first
+			 */
+			[[nodiscard]] std::vector<statement_profile> snapshot( ) const;
+			void reset( );
+		};
+	} // namespace profile_impl
+} // namespace daw::sqlite
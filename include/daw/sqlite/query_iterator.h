@@ -8,17 +8,27 @@
 
 #pragma once
 
+#include "daw/sqlite/column_batch.h"
+#include "daw/sqlite/column_metadata.h"
 #include "daw/sqlite/result_row.h"
 #include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/result_set.h"
+#include "daw/sqlite/row_cursor.h"
 
 #include <daw/vector.h>
 
+#include <cstddef>
+#include <memory>
 #include <optional>
 #include <utility>
 
 namespace daw::sqlite {
 	class database;
 
+	namespace ps_impl {
+		struct row_buffer;
+	} // namespace ps_impl
+
 	struct query_iterator {
 		using iterator_type = query_iterator;
 		using value_type = result_row_t;
@@ -32,11 +42,19 @@ namespace daw::sqlite {
 
 	private:
 		shared_prepared_statement m_statement{};
+		row_cursor m_cursor{};
 		std::size_t m_row = static_cast<std::size_t>(-1);
 		std::optional<result_row_t> m_last_value{};
+		// Rows already stepped by count( ), m_row indexes into it when set
+		std::shared_ptr<ps_impl::row_buffer const> m_buffer{};
+		// Column names shared by the rows, built on first use
+		std::shared_ptr<column_metadata const> m_metadata{};
+
+		void buffer_remaining_rows( );
 
 		explicit query_iterator( prepared_statement statement )
-			: m_statement( std::move( statement ) ) {
+			: m_statement( std::move( statement ) )
+			  , m_cursor( m_statement ) {
 			operator++( );
 		}
 
@@ -44,12 +62,18 @@ namespace daw::sqlite {
 		explicit query_iterator( ) = default;
 
 		explicit query_iterator( shared_prepared_statement statement )
-			: m_statement( std::move( statement ) ) {
+			: m_statement( std::move( statement ) )
+			  , m_cursor( m_statement ) {
 			operator++( );
 		}
 
 		[[nodiscard]] const_reference front( );
 
+		/***
+		 * @brief The column names and name index of the result
+		 */
+		[[nodiscard]] std::shared_ptr<column_metadata const> const &metadata( );
+
 		[[nodiscard]] const_reference operator*( ) {
 			return front( );
 		}
@@ -89,33 +113,45 @@ namespace daw::sqlite {
 			return m_row;
 		}
 
-		void reset( ) {
-			if(m_statement) {
-				m_statement.reset( );
-				m_row = static_cast<std::size_t>(-1);
-				operator++( );
-			}
-		}
-
-		[[nodiscard]] std::size_t count( ) {
-			auto f = *this;
-			auto result = static_cast<std::size_t>(-1);
-			try {
-				result = static_cast<std::size_t>(std::distance( f, f.end( ) ));
-			} catch(...) {
-				reset( );
-				throw;
-			}
-			reset( );
-			return result;
-		}
+		/***
+		 * @brief Restart iteration at the first row.  When every row has been
+		 * buffered by count( ) they are replayed, otherwise the query is run again
+		 */
+		void reset( );
+
+		/***
+		 * @brief The number of rows from the current one to the end.  The
+		 * remaining rows are stepped once and buffered, further iteration reads
+		 * the buffer instead of running the query again
+		 */
+		[[nodiscard]] std::size_t count( );
+
+		/***
+		 * @brief Copy up to max_rows rows, starting at the current one, into
+		 * batch column by column and advance past them.  batch is cleared first
+		 * and keeps its allocations.  When a value does not fit its column's type
+		 * the batch is cleared and sqlite3_exception is thrown
+		 * @return The number of rows copied, 0 when there are none left
+		 */
+		std::size_t fetch_batch( column_batch &batch, std::size_t max_rows );
+
+		[[nodiscard]] column_batch fetch_batch( std::size_t max_rows );
+
+		/***
+		 * @brief Copy the current row and every row after it into a result_set
+		 * that owns its values, and advance to the end
+		 */
+		[[nodiscard]] result_set fetch_all( );
 
 		[[nodiscard]] std::size_t size( ) {
 			return count( );
 		}
 
-		[[nodiscard]] bool empty( ) {
-			return count( ) == 0u;
+		/***
+		 * @brief True when there are no rows left.  Does not step the statement
+		 */
+		[[nodiscard]] bool empty( ) const {
+			return m_row == static_cast<std::size_t>(-1);
 		}
 
 		explicit operator bool( ) const {
@@ -9,84 +9,171 @@
 #pragma once
 
 #include "daw/sqlite/cell_value.h"
+#include "daw/sqlite/column_metadata.h"
 
 #include <daw/daw_string_view.h>
 #include <daw/daw_ensure.h>
 #include <daw/daw_move.h>
 #include <daw/vector.h>
 
+#include <cstddef>
 #include <cstdint>
-#include <ranges>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
 
 namespace daw::sqlite {
+	/***
+	 * @brief The cells of one row.  Column names live in a column_metadata
+	 * shared by every row of the result, so name lookup is a hash probe and
+	 * rows only store values.  Cells are produced on access as result_cell_t
+	 * values
+	 */
 	class result_row_t {
-		daw::vector<result_cell_t> m_columns{};
+		std::shared_ptr<column_metadata const> m_metadata{};
+		daw::vector<cell_value> m_values{};
 
 	public:
+		class const_iterator {
+			result_row_t const *m_row = nullptr;
+			std::size_t m_index = 0;
+
+		public:
+			using value_type = result_cell_t;
+			using reference = result_cell_t;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::input_iterator_tag;
+			using iterator_concept = std::forward_iterator_tag;
+
+			struct pointer {
+				result_cell_t cell;
+
+				[[nodiscard]] result_cell_t const *operator->( ) const {
+					return &cell;
+				}
+			};
+
+			const_iterator( ) = default;
+
+			const_iterator( result_row_t const &row, std::size_t index )
+				: m_row( &row )
+				  , m_index( index ) {}
+
+			[[nodiscard]] reference operator*( ) const {
+				return ( *m_row )[m_index];
+			}
+
+			[[nodiscard]] pointer operator->( ) const {
+				return pointer{ operator*( ) };
+			}
+
+			const_iterator &operator++( ) {
+				++m_index;
+				return *this;
+			}
+
+			const_iterator operator++( int ) {
+				auto result = *this;
+				++m_index;
+				return result;
+			}
+
+			[[nodiscard]] bool operator==( const_iterator const & ) const = default;
+		};
+
 		explicit result_row_t( ) = default;
 
-		explicit constexpr result_row_t( daw::vector<result_cell_t> columns )
-			: m_columns( std::move( columns ) ) {}
+		explicit result_row_t( std::shared_ptr<column_metadata const> metadata,
+		                       daw::vector<cell_value> values )
+			: m_metadata( std::move( metadata ) )
+			  , m_values( std::move( values ) ) {
+			daw_ensure( m_metadata and m_metadata->size( ) == m_values.size( ) );
+		}
 
-		explicit constexpr result_row_t( daw::do_resize_and_overwrite_t,
-		                                 std::size_t sz, auto &&operation )
-			: m_columns( daw::do_resize_and_overwrite, sz, DAW_FWD( operation ) ) {}
+		explicit result_row_t( std::shared_ptr<column_metadata const> metadata,
+		                       daw::do_resize_and_overwrite_t,
+		                       auto &&operation )
+			: m_metadata( std::move( metadata ) )
+			  , m_values( daw::do_resize_and_overwrite,
+			              m_metadata->size( ),
+			              DAW_FWD( operation ) ) {}
+
+		/***
+		 * @brief Builds the column metadata from the names of the cells
+		 */
+		explicit result_row_t( daw::vector<result_cell_t> const &columns )
+			: m_values( daw::do_resize_and_overwrite,
+			            columns.size( ),
+			            [&]( cell_value *ptr, std::size_t sz ) {
+				            for( auto const &column : columns ) {
+					            std::construct_at( ptr++, column.value );
+				            }
+				            return sz;
+			            } ) {
+			auto names = std::vector<std::string>( );
+			names.reserve( columns.size( ) );
+			for( auto const &column : columns ) {
+				names.emplace_back( column.name.data( ), column.name.size( ) );
+			}
+			m_metadata = std::make_shared<column_metadata const>( std::move( names ) );
+		}
 
-		[[nodiscard]] constexpr result_cell_t const &operator[](
-			std::size_t idx ) const {
-			return m_columns[idx];
+		[[nodiscard]] result_cell_t operator[]( std::size_t idx ) const {
+			return result_cell_t( m_metadata->name( idx ), m_values[idx] );
 		}
 
-		[[nodiscard]] constexpr cell_value const &operator[](
-			daw::string_view name ) const {
+		[[nodiscard]] cell_value const &operator[]( daw::string_view name ) const {
 			auto const idx = get_index_of( name );
 			daw_ensure( idx.has_value( ) );
-			return m_columns[*idx].value;
+			return m_values[*idx];
 		}
 
-		[[nodiscard]] constexpr std::optional<std::size_t> get_index_of(
+		[[nodiscard]] std::optional<std::size_t> get_index_of(
 			daw::string_view name ) const noexcept {
-			auto const pos = std::ranges::find( m_columns,
-			                                    name,
-			                                    &result_cell_t::name );
-			if(pos == m_columns.cend( )) {
+			if( not m_metadata ) {
 				return std::nullopt;
 			}
-			return static_cast<std::size_t>(std::ranges::distance(
-				m_columns.cbegin( ),
-				pos ));
+			return m_metadata->get_index_of( name );
+		}
+
+		[[nodiscard]] std::shared_ptr<column_metadata const> const &
+		metadata( ) const {
+			return m_metadata;
 		}
 
-		[[nodiscard]] auto const &front( ) const {
-			return m_columns.front( );
+		[[nodiscard]] std::span<cell_value const> values( ) const {
+			return std::span<cell_value const>( m_values.data( ), m_values.size( ) );
 		}
 
-		[[nodiscard]] auto const &back( ) const {
-			return m_columns.back( );
+		[[nodiscard]] result_cell_t front( ) const {
+			return operator[]( 0 );
 		}
 
-		[[nodiscard]] auto begin( ) const {
-			return m_columns.begin( );
+		[[nodiscard]] result_cell_t back( ) const {
+			return operator[]( size( ) - 1U );
 		}
 
-		[[nodiscard]] auto end( ) const {
-			return m_columns.end( );
+		[[nodiscard]] const_iterator begin( ) const {
+			return const_iterator( *this, 0 );
 		}
 
-		[[nodiscard]] auto cbegin( ) const {
-			return m_columns.cbegin( );
+		[[nodiscard]] const_iterator end( ) const {
+			return const_iterator( *this, size( ) );
 		}
 
-		[[nodiscard]] auto cend( ) const {
-			return m_columns.cend( );
+		[[nodiscard]] const_iterator cbegin( ) const {
+			return begin( );
 		}
 
-		[[nodiscard]] auto *data( ) const {
-			return m_columns.data( );
+		[[nodiscard]] const_iterator cend( ) const {
+			return end( );
 		}
 
 		[[nodiscard]] std::size_t size( ) const {
-			return m_columns.size( );
+			return m_values.size( );
 		}
 	};
-}
\ No newline at end of file
+} // namespace daw::sqlite
@@ -0,0 +1,336 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/cell_value.h"
+#include "daw/sqlite/column_metadata.h"
+
+#include <daw/daw_ensure.h>
+#include <daw/daw_string_view.h>
+
+#include <algorithm>
+#include <cassert>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace daw::sqlite {
+	struct query_iterator;
+
+	/***
+	 * @brief Order two cells the way sqlite does with the BINARY collation.
+	 * Null sorts first, then Integer and Float by value, compared exactly, then
+	 * Text and Blob by their bytes
+	 * @return Less than 0, 0 or greater than 0 when lhs is before, equal to or
+	 * after rhs
+	 */
+	[[nodiscard]] int compare_cells( cell_value const &lhs,
+	                                 cell_value const &rhs );
+
+	/***
+	 * @brief A view of one row of a result_set.  Valid while the result_set is
+	 * alive and unsorted
+	 */
+	class result_set_row {
+		column_metadata const *m_metadata = nullptr;
+		cell_value const *m_cells = nullptr;
+		std::size_t m_size = 0;
+
+	public:
+		explicit result_set_row( ) = default;
+
+		explicit result_set_row( column_metadata const &metadata,
+		                         cell_value const *cells, std::size_t size )
+		  : m_metadata( &metadata )
+		  , m_cells( cells )
+		  , m_size( size ) {}
+
+		[[nodiscard]] cell_value const &operator[]( std::size_t column ) const {
+			assert( column < m_size );
+			return m_cells[column];
+		}
+
+		[[nodiscard]] cell_value const &
+		operator[]( daw::string_view name ) const {
+			auto const idx = get_index_of( name );
+			daw_ensure( idx.has_value( ) );
+			return m_cells[*idx];
+		}
+
+		[[nodiscard]] std::optional<std::size_t>
+		get_index_of( daw::string_view name ) const noexcept {
+			if( not m_metadata ) {
+				return std::nullopt;
+			}
+			return m_metadata->get_index_of( name );
+		}
+
+		[[nodiscard]] daw::string_view name( std::size_t column ) const {
+			return m_metadata->name( column );
+		}
+
+		[[nodiscard]] std::span<cell_value const> values( ) const {
+			return std::span<cell_value const>( m_cells, m_size );
+		}
+
+		[[nodiscard]] cell_value const *begin( ) const {
+			return m_cells;
+		}
+
+		[[nodiscard]] cell_value const *end( ) const {
+			return m_cells + m_size;
+		}
+
+		[[nodiscard]] std::size_t size( ) const {
+			return m_size;
+		}
+	};
+
+	namespace result_set_impl {
+		struct block_deleter {
+			void operator( )( std::byte *ptr ) const noexcept;
+		};
+	} // namespace result_set_impl
+
+	/***
+	 * @brief Rows of a query copied out of sqlite into one allocation.  The
+	 * cells of every row are stored row major, followed by the bytes of the
+	 * text and blob values they view, so the values stay valid for the life of
+	 * the result_set and moving it does not move or copy them.  Filled by
+	 * query_iterator::fetch_all or database::fetch_all
+	 */
+	class result_set {
+		std::shared_ptr<column_metadata const> m_metadata{ };
+		std::unique_ptr<std::byte[], result_set_impl::block_deleter> m_block{ };
+		std::size_t m_row_count = 0;
+		std::size_t m_column_count = 0;
+		std::size_t m_byte_count = 0;
+
+		friend struct ::daw::sqlite::query_iterator;
+
+		static_assert( std::is_trivially_destructible_v<cell_value> );
+		static_assert( alignof( cell_value ) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ );
+
+		/***
+		 * @brief Copy cells, whose text and blob values view into bytes, and
+		 * bytes into a new block
+		 */
+		explicit result_set( std::shared_ptr<column_metadata const> metadata,
+		                     std::size_t row_count,
+		                     std::span<cell_value const> cells,
+		                     std::span<std::byte const> bytes );
+
+		[[nodiscard]] cell_value *cells( ) const {
+			return reinterpret_cast<cell_value *>( m_block.get( ) );
+		}
+
+		// Reorder the rows so that row n is the old row order[n]
+		void apply_order( std::span<std::size_t const> order );
+
+	public:
+		class const_iterator {
+			result_set const *m_set = nullptr;
+			std::size_t m_index = 0;
+
+		public:
+			using value_type = result_set_row;
+			using reference = result_set_row;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::input_iterator_tag;
+			using iterator_concept = std::random_access_iterator_tag;
+
+			struct pointer {
+				result_set_row row;
+
+				[[nodiscard]] result_set_row const *operator->( ) const {
+					return &row;
+				}
+			};
+
+			const_iterator( ) = default;
+
+			const_iterator( result_set const &set, std::size_t index )
+			  : m_set( &set )
+			  , m_index( index ) {}
+
+			[[nodiscard]] reference operator*( ) const {
+				return ( *m_set )[m_index];
+			}
+
+			[[nodiscard]] pointer operator->( ) const {
+				return pointer{ operator*( ) };
+			}
+
+			[[nodiscard]] reference operator[]( difference_type n ) const {
+				return ( *m_set )[static_cast<std::size_t>(
+				  static_cast<difference_type>( m_index ) + n )];
+			}
+
+			const_iterator &operator++( ) {
+				++m_index;
+				return *this;
+			}
+
+			const_iterator operator++( int ) {
+				auto result = *this;
+				++m_index;
+				return result;
+			}
+
+			const_iterator &operator--( ) {
+				--m_index;
+				return *this;
+			}
+
+			const_iterator operator--( int ) {
+				auto result = *this;
+				--m_index;
+				return result;
+			}
+
+			const_iterator &operator+=( difference_type n ) {
+				m_index = static_cast<std::size_t>(
+				  static_cast<difference_type>( m_index ) + n );
+				return *this;
+			}
+
+			const_iterator &operator-=( difference_type n ) {
+				return operator+=( -n );
+			}
+
+			[[nodiscard]] friend const_iterator operator+( const_iterator it,
+			                                               difference_type n ) {
+				return it += n;
+			}
+
+			[[nodiscard]] friend const_iterator operator+( difference_type n,
+			                                               const_iterator it ) {
+				return it += n;
+			}
+
+			[[nodiscard]] friend const_iterator operator-( const_iterator it,
+			                                               difference_type n ) {
+				return it -= n;
+			}
+
+			[[nodiscard]] friend difference_type
+			operator-( const_iterator const &lhs, const_iterator const &rhs ) {
+				return static_cast<difference_type>( lhs.m_index ) -
+				       static_cast<difference_type>( rhs.m_index );
+			}
+
+			[[nodiscard]] bool operator==( const_iterator const & ) const = default;
+
+			[[nodiscard]] std::strong_ordering
+			operator<=>( const_iterator const &rhs ) const {
+				return m_index <=> rhs.m_index;
+			}
+		};
+
+		explicit result_set( ) = default;
+
+		[[nodiscard]] std::size_t size( ) const {
+			return m_row_count;
+		}
+
+		[[nodiscard]] bool empty( ) const {
+			return m_row_count == 0;
+		}
+
+		[[nodiscard]] std::size_t column_count( ) const {
+			return m_column_count;
+		}
+
+		/***
+		 * @brief The column names and name index of the result
+		 */
+		[[nodiscard]] std::shared_ptr<column_metadata const> const &
+		metadata( ) const {
+			return m_metadata;
+		}
+
+		/***
+		 * @brief The size of the allocation holding the cells and their bytes
+		 */
+		[[nodiscard]] std::size_t allocated_bytes( ) const {
+			return m_row_count * m_column_count * sizeof( cell_value ) +
+			       m_byte_count;
+		}
+
+		[[nodiscard]] result_set_row operator[]( std::size_t row ) const {
+			assert( row < m_row_count );
+			return result_set_row(
+			  *m_metadata, cells( ) + row * m_column_count, m_column_count );
+		}
+
+		[[nodiscard]] cell_value const &at( std::size_t row,
+		                                    std::size_t column ) const {
+			daw_ensure( row < m_row_count and column < m_column_count );
+			return cells( )[row * m_column_count + column];
+		}
+
+		[[nodiscard]] result_set_row front( ) const {
+			return operator[]( 0 );
+		}
+
+		[[nodiscard]] result_set_row back( ) const {
+			return operator[]( m_row_count - 1U );
+		}
+
+		[[nodiscard]] const_iterator begin( ) const {
+			return const_iterator( *this, 0 );
+		}
+
+		[[nodiscard]] const_iterator end( ) const {
+			return const_iterator( *this, m_row_count );
+		}
+
+		[[nodiscard]] const_iterator cbegin( ) const {
+			return begin( );
+		}
+
+		[[nodiscard]] const_iterator cend( ) const {
+			return end( );
+		}
+
+		/***
+		 * @brief Stable sort of the rows with
+		 * compare( result_set_row const &, result_set_row const & ) as less than.
+		 * Cells are moved within the block, their text and blob bytes stay where
+		 * they are
+		 */
+		template<typename Compare>
+			requires( std::predicate<Compare &, result_set_row const &,
+			                         result_set_row const &> ) //
+		void sort( Compare compare ) {
+			auto order = std::vector<std::size_t>( m_row_count );
+			std::iota( order.begin( ), order.end( ), std::size_t{ 0 } );
+			std::stable_sort( order.begin( ),
+			                  order.end( ),
+			                  [&]( std::size_t lhs, std::size_t rhs ) {
+				                  return compare( operator[]( lhs ),
+				                                  operator[]( rhs ) );
+			                  } );
+			apply_order( order );
+		}
+
+		/***
+		 * @brief Stable sort of the rows by the value of column, ordered by
+		 * compare_cells
+		 */
+		void sort_by( std::size_t column, bool ascending = true );
+	};
+} // namespace daw::sqlite
@@ -0,0 +1,120 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/cell_value.h"
+#include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <cassert>
+#include <cstddef>
+#include <sqlite3.h>
+
+namespace daw::sqlite {
+	/***
+	 * @brief Column access to the current row of a statement that is validated
+	 * once, when the cursor is created, instead of on every call.  The
+	 * accessors only check the column index with assert in debug builds.  The
+	 * cursor does not own the statement and must not outlive it
+	 */
+	class row_cursor {
+		sqlite3_stmt *m_statement = nullptr;
+		std::size_t m_column_count = 0;
+
+		[[nodiscard]] int to_column( std::size_t column ) const noexcept {
+			assert( column < m_column_count );
+			return static_cast<int>( column );
+		}
+
+		explicit row_cursor( sqlite3_stmt *statement )
+		  : m_statement( statement ) {
+			if( not m_statement ) {
+				throw sqlite3_exception( "Attempt to use an invalid statement" );
+			}
+			m_column_count =
+				static_cast<std::size_t>( sqlite3_column_count( m_statement ) );
+		}
+
+	public:
+		explicit row_cursor( ) = default;
+
+		explicit row_cursor( prepared_statement &statement )
+		  : row_cursor( statement.get( ) ) {}
+
+		explicit row_cursor( shared_prepared_statement &statement )
+		  : row_cursor( statement.get( ) ) {}
+
+		[[nodiscard]] sqlite3_stmt *get( ) const noexcept {
+			return m_statement;
+		}
+
+		[[nodiscard]] std::size_t get_column_count( ) const noexcept {
+			return m_column_count;
+		}
+
+		[[nodiscard]] column_type get_column_type(
+		  std::size_t column ) const noexcept {
+			switch( sqlite3_column_type( m_statement, to_column( column ) ) ) {
+			case SQLITE_INTEGER:
+				return column_type::Integer;
+			case SQLITE_FLOAT:
+				return column_type::Float;
+			case SQLITE_TEXT:
+				return column_type::Text;
+			case SQLITE_BLOB:
+				return column_type::Blob;
+			default:
+				return column_type::Null;
+			}
+		}
+
+		[[nodiscard]] types::text_t get_column_name(
+		  std::size_t column ) const noexcept {
+			return types::text_t(
+			  sqlite3_column_name( m_statement, to_column( column ) ) );
+		}
+
+		[[nodiscard]] types::real_t get_column_float(
+		  std::size_t column ) const noexcept {
+			return sqlite3_column_double( m_statement, to_column( column ) );
+		}
+
+		[[nodiscard]] types::integer_t get_column_integer(
+		  std::size_t column ) const noexcept {
+			return sqlite3_column_int64( m_statement, to_column( column ) );
+		}
+
+		[[nodiscard]] types::text_t get_column_text(
+		  std::size_t column ) const noexcept {
+			auto const col = to_column( column );
+			// sqlite3_column_text must be called before sqlite3_column_bytes
+			auto const *first = reinterpret_cast<char const *>(
+			  sqlite3_column_text( m_statement, col ) );
+			return types::text_t(
+			  first,
+			  static_cast<std::size_t>( sqlite3_column_bytes( m_statement, col ) ) );
+		}
+
+		[[nodiscard]] types::blob_t get_column_blob(
+		  std::size_t column ) const noexcept {
+			auto const col = to_column( column );
+			// sqlite3_column_blob must be called before sqlite3_column_bytes
+			auto const *first = static_cast<std::byte const *>(
+			  sqlite3_column_blob( m_statement, col ) );
+			return types::blob_t(
+			  first,
+			  static_cast<std::size_t>( sqlite3_column_bytes( m_statement, col ) ) );
+		}
+
+		[[nodiscard]] bool is_column_null( std::size_t column ) const noexcept {
+			return sqlite3_column_type( m_statement, to_column( column ) ) ==
+			       SQLITE_NULL;
+		}
+	};
+} // namespace daw::sqlite
@@ -8,25 +8,44 @@
 
 #pragma once
 
+#include "daw/sqlite/backup.h"
+#include "daw/sqlite/busy_policy.h"
 #include "daw/sqlite/cell_value.h"
+#include "daw/sqlite/container_table.h"
+#include "daw/sqlite/functions.h"
+#include "daw/sqlite/open_options.h"
 #include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/profiler.h"
 #include "daw/sqlite/query_iterator.h"
+#include "daw/sqlite/result_set.h"
+#include "daw/sqlite/statement_cache.h"
+#include "daw/sqlite/transaction.h"
+#include "daw/sqlite/typed_query_iterator.h"
 
 #include <daw/daw_string_view.h>
 #include <daw/daw_take.h>
 #include <daw/vector.h>
 
+#include <cstdint>
 #include <exception>
 #include <filesystem>
 #include <memory>
+#include <ranges>
+#include <span>
 #include <sqlite3.h>
+#include <utility>
+#include <vector>
 
 namespace daw::sqlite {
 	namespace sqlite_impl {
 		struct sqlite_deleter {
 			DAW_CPP23_STATIC_CALL_OP void operator( )(
 				sqlite3 *ptr ) DAW_CPP23_STATIC_CALL_OP_CONST noexcept {
-				sqlite3_close( ptr );
+				// A profiler may already be gone when outstanding statements are
+				// finalized by the deferred close
+				sqlite3_trace_v2( ptr, 0, nullptr, nullptr );
+				// Defers the close until any outstanding statements are finalized
+				sqlite3_close_v2( ptr );
 			}
 		};
 	} // namespace sqlite_impl
@@ -34,6 +53,21 @@ namespace daw::sqlite {
 	class database {
 		std::unique_ptr<sqlite3, sqlite_impl::sqlite_deleter> m_db{};
 		daw::take_t<bool> m_is_open{};
+		// Must outlive m_statement_cache, finalizing a statement can trace it
+		std::shared_ptr<profile_impl::profiler> m_profiler{};
+		// Must be destroyed before m_db so cached statements are finalized first
+		statement_cache m_statement_cache{};
+		// Indexed by static_statement id, destroyed before m_db like the cache
+		std::vector<shared_prepared_statement> m_static_statements{};
+		std::size_t m_savepoint_depth = 0;
+		std::shared_ptr<busy_impl::busy_state> m_busy =
+		  std::make_shared<busy_impl::busy_state>( );
+
+		friend class ::daw::sqlite::savepoint;
+		friend class ::daw::sqlite::prepared_statement;
+		friend class ::daw::sqlite::shared_prepared_statement;
+
+		void apply( open_options const &options );
 
 	public:
 		explicit database( ) = default;
@@ -42,14 +76,20 @@ namespace daw::sqlite {
 		 * @brief Open an existing or creat a new sqlite database at the path
 		 * specified
 		 */
-		explicit database( std::filesystem::path filename );
+		explicit database( std::filesystem::path filename,
+		                   open_options const &options = open_options{ } );
 
 		/***
 		 * @brief Give ownership of an existing sqlite db
 		 */
 		explicit database( sqlite3 *db );
 
-		void open( std::filesystem::path filename );
+		/***
+		 * @brief Open the database with sqlite3_open_v2 using the flags of
+		 * options, then apply the pragmas and busy timeout it specifies
+		 */
+		void open( std::filesystem::path filename,
+		           open_options const &options = open_options{ } );
 		void close( );
 		[[nodiscard]] sqlite3 const *get_handle( ) const;
 		[[nodiscard]] sqlite3 *get_handle( );
@@ -57,16 +97,246 @@ namespace daw::sqlite {
 		[[nodiscard]] daw::vector<std::string> tables( );
 		[[nodiscard]] bool has_table( daw::string_view table_name );
 
+		/***
+		 * @brief Is a transaction open, i.e. is the connection not in autocommit
+		 * mode
+		 */
+		[[nodiscard]] bool in_transaction( ) const;
+
+		/***
+		 * @brief The rowid of the most recent successful INSERT on the connection
+		 */
+		[[nodiscard]] std::int64_t last_insert_rowid( ) const;
+
+		/***
+		 * @brief Rows modified by the most recent INSERT, UPDATE or DELETE
+		 */
+		[[nodiscard]] std::int64_t changes( ) const;
+
+		/***
+		 * @brief Replace how the connection waits for locks held by other
+		 * connections
+		 */
+		void set_busy_policy( busy_policy const &policy );
+		[[nodiscard]] busy_policy const &get_busy_policy( ) const;
+
+		/***
+		 * @brief Waits, retries and busy errors of this connection and the
+		 * statements prepared on it
+		 */
+		[[nodiscard]] busy_stats get_busy_stats( ) const;
+		void reset_busy_stats( );
+
+		/***
+		 * @brief Record latency, rows and sqlite3_stmt_status counters of each
+		 * statement run, grouped by normalized SQL.  Uses sqlite3_trace_v2, which
+		 * replaces any other trace callback on the connection
+		 */
+		void enable_profiling( profiler_options const &options = profiler_options{ } );
+		void disable_profiling( );
+		[[nodiscard]] bool is_profiling( ) const;
+
+		/***
+		 * @brief The statements profiled since profiling was enabled or last
+		 * reset, sorted by total time.  Can be called from any thread
+		 */
+		[[nodiscard]] std::vector<statement_profile> profile_snapshot( ) const;
+		void reset_profile( );
+
+		/***
+		 * @brief Copy this database into destination with the online backup API,
+		 * replacing its contents.  destination must not be in use elsewhere
+		 * @return false when the progress callback stopped the backup
+		 */
+		bool backup_to( database &destination,
+		                backup_options const &options = backup_options{ } );
+		bool backup_to( std::filesystem::path const &filename,
+		                backup_options const &options = backup_options{ } );
+
+		/***
+		 * @brief Replace the contents of this database with a copy of source
+		 * @return false when the progress callback stopped the restore
+		 */
+		bool restore_from( database &source,
+		                   backup_options const &options = backup_options{ } );
+		bool restore_from( std::filesystem::path const &filename,
+		                   backup_options const &options = backup_options{ } );
+
+		/***
+		 * @brief Open an in memory database holding a copy of the database file.
+		 * Persist it again with backup_to( filename ), or take its image with
+		 * serialize_view
+		 */
+		[[nodiscard]] static database
+		load_into_memory( std::filesystem::path const &filename,
+		                  backup_options const &options = backup_options{ } );
+
+		/***
+		 * @brief A copy of the database image, as it would be on disk
+		 */
+		[[nodiscard]] serialized_image serialize( daw::string_view schema = "main" );
+
+		/***
+		 * @brief The image of an in memory database without copying it.  Empty
+		 * unless the database was created by deserialize or load_into_memory, a
+		 * file or plain :memory: database is not held in one contiguous buffer.
+		 * Valid until the database is next changed or closed
+		 */
+		[[nodiscard]] std::span<std::byte const>
+		serialize_view( daw::string_view schema = "main" );
+
+		/***
+		 * @brief Replace schema with the database in image, which is taken over
+		 * without copying.  Changes are kept in memory, the image grows as needed
+		 */
+		void deserialize( serialized_image image, bool read_only = false,
+		                  daw::string_view schema = "main" );
+
+		/***
+		 * @brief Replace schema with a copy of image
+		 */
+		void deserialize( std::span<std::byte const> image, bool read_only = false,
+		                  daw::string_view schema = "main" );
+
+		/***
+		 * @brief Replace schema with a read only database backed directly by
+		 * image, which must stay valid and unchanged until the database is closed
+		 * or schema is replaced
+		 */
+		void deserialize_view( std::span<std::byte const> image,
+		                       daw::string_view schema = "main" );
+
+		/***
+		 * @brief Make fn callable from SQL as name.  The number and types of its
+		 * parameters are taken from its signature and decoded with value_traits,
+		 * the result is returned with result_traits.  An exception thrown by fn
+		 * becomes an SQL error
+		 */
+		template<typename Fn>
+		void register_function( daw::string_view name, Fn &&fn,
+		                        function_options const &options = function_options{ } ) {
+			assert( m_db );
+			function_impl::register_scalar( m_db.get( ), name, DAW_FWD( fn ), options );
+		}
+
+		/***
+		 * @brief Make an aggregate callable from SQL as name.  Each group starts
+		 * with State init( ), step( State &, args... ) is called for each row and
+		 * final( State & ) gives the result.  The state is kept in sqlite's
+		 * aggregate context without another allocation
+		 */
+		template<typename Init, typename Step, typename Final>
+		void register_aggregate( daw::string_view name, Init &&init, Step &&step,
+		                         Final &&final,
+		                         function_options const &options = function_options{ } ) {
+			assert( m_db );
+			function_impl::register_aggregate( m_db.get( ),
+			                                   name,
+			                                   DAW_FWD( init ),
+			                                   DAW_FWD( step ),
+			                                   DAW_FWD( final ),
+			                                   nullptr,
+			                                   options );
+		}
+
+		/***
+		 * @brief Register an aggregate that can also be used as a window function
+		 * with sqlite3_create_window_function.  inverse( State &, args... )
+		 * removes a row that left the window and value( State & ) gives the
+		 * current result
+		 */
+		template<typename Init, typename Step, typename Inverse, typename Value>
+		void register_window_function(
+		  daw::string_view name, Init &&init, Step &&step, Inverse &&inverse,
+		  Value &&value, function_options const &options = function_options{ } ) {
+			assert( m_db );
+			function_impl::register_aggregate( m_db.get( ),
+			                                   name,
+			                                   DAW_FWD( init ),
+			                                   DAW_FWD( step ),
+			                                   DAW_FWD( value ),
+			                                   DAW_FWD( inverse ),
+			                                   options );
+		}
+
+		/***
+		 * @brief Remove the function name taking arg_count arguments
+		 */
+		void remove_function( daw::string_view name, int arg_count );
+
+		/***
+		 * @brief Expose container as the read only table name, with one column
+		 * per vtab_column.  Rows are read from the container in place, text and
+		 * blob columns referring to it are not copied.  Key and Sorted columns
+		 * let equality and range conditions skip the scan.  container must
+		 * outlive the connection, or the registration, and not change while a
+		 * query on it runs
+		 */
+		template<std::ranges::forward_range Container, typename... Accessors>
+		void register_container( daw::string_view name, Container const &container,
+		                         vtab_column<Accessors>... columns ) {
+			assert( m_db );
+			vtab_impl::register_container(
+			  m_db.get( ), name, container, std::move( columns )... );
+		}
+
+		/***
+		 * @brief The cache of prepared statements used by exec( sql, params... )
+		 */
+		[[nodiscard]] statement_cache &get_statement_cache( );
+		[[nodiscard]] statement_cache const &get_statement_cache( ) const;
+
+		/***
+		 * @brief The statement kept for the static_statement with id.  It is
+		 * prepared on first use and returned as a lease, so it is reset when the
+		 * caller is done with it.  When it is still in use elsewhere, e.g. by a
+		 * live iterator, an uncached statement is prepared
+		 */
+		[[nodiscard]] shared_prepared_statement
+		get_static_statement( std::size_t id, daw::string_view sql );
+
 		query_iterator exec( prepared_statement statement );
 		query_iterator exec( shared_prepared_statement statement );
 
+		/***
+		 * @brief Execute sql with the parameters bound in order.  The prepared
+		 * statement is taken from, and kept in, the statement cache
+		 */
 		template<typename... Params>
 			requires( Parameters<Params...> ) //
 		query_iterator exec( daw::string_view sql,
 		                     Params &&... params ) {
 			assert( m_db );
-			return exec(
-				shared_prepared_statement( *this, sql, DAW_FWD( params )... ) );
+			auto statement = m_statement_cache.get( *this, sql );
+			statement.bind_parameters( DAW_FWD( params )... );
+			return exec( std::move( statement ) );
+		}
+
+		/***
+		 * @brief Execute sql and decode each row directly into Row, e.g.
+		 * db.query_as<std::tuple<std::int64_t, std::string_view>>( sql, params )
+		 * Row can be a std::tuple, a class with a row_contract specialization or a
+		 * single column type
+		 */
+		template<ResultRow Row, typename... Params>
+			requires( Parameters<Params...> ) //
+		[[nodiscard]] typed_query_iterator<Row> query_as( daw::string_view sql,
+		                                                  Params &&... params ) {
+			assert( m_db );
+			auto statement = m_statement_cache.get( *this, sql );
+			statement.bind_parameters( DAW_FWD( params )... );
+			return typed_query_iterator<Row>( std::move( statement ) );
+		}
+
+		/***
+		 * @brief Execute sql and copy every row into a result_set that owns its
+		 * values in one allocation
+		 */
+		template<typename... Params>
+			requires( Parameters<Params...> ) //
+		[[nodiscard]] result_set fetch_all( daw::string_view sql,
+		                                    Params &&... params ) {
+			return exec( sql, DAW_FWD( params )... ).fetch_all( );
 		}
 	}; // class database
 }    // namespace daw::sqlite
\ No newline at end of file
@@ -22,5 +22,11 @@ namespace daw::sqlite {
 
 		[[nodiscard]] char const *what( ) const noexcept override;
 		[[nodiscard]] int error( ) const;
+
+		/***
+		 * @brief Did the error come from SQLITE_BUSY or SQLITE_LOCKED, i.e. could
+		 * retrying the operation later succeed
+		 */
+		[[nodiscard]] bool is_busy( ) const;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/prepared_statement.h"
+
+#include <daw/daw_string_view.h>
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace daw::sqlite {
+	class database;
+
+	struct statement_cache_stats {
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+		std::size_t evictions = 0;
+	};
+
+	/***
+	 * @brief A bounded LRU cache of prepared statements keyed by their SQL text.
+	 * Statements are handed out as a lease, when its last copy is destroyed the
+	 * statement is reset and its bindings cleared, so an unfinished result does
+	 * not hold its read lock while cached.  If the cached statement is still in
+	 * use elsewhere, e.g. by a live query_iterator, a new uncached statement is
+	 * prepared so that the existing one is left alone.
+	 */
+	class statement_cache {
+	public:
+		static constexpr std::size_t default_capacity = 64;
+
+	private:
+		struct entry_t {
+			std::string sql;
+			shared_prepared_statement statement;
+		};
+		using entries_t = std::list<entry_t>;
+
+		// Keys are views into the sql member of the list nodes, which are stable
+		entries_t m_entries{};
+		std::unordered_map<std::string_view, entries_t::iterator> m_index{};
+		std::size_t m_capacity = default_capacity;
+		statement_cache_stats m_stats{};
+
+		void evict_to( std::size_t count );
+
+	public:
+		explicit statement_cache( ) = default;
+		explicit statement_cache( std::size_t capacity );
+
+		/***
+		 * @brief Get a ready to bind statement for sql, preparing it if needed
+		 */
+		[[nodiscard]] shared_prepared_statement get( database &db,
+		                                             daw::string_view sql );
+
+		/***
+		 * @brief Drop all cached statements.  Statements in use elsewhere are
+		 * finalized when their last user releases them
+		 */
+		void clear( );
+
+		/***
+		 * @brief Change the maximum number of statements kept.  A capacity of 0
+		 * disables caching
+		 */
+		void set_capacity( std::size_t capacity );
+
+		[[nodiscard]] std::size_t capacity( ) const;
+		[[nodiscard]] std::size_t size( ) const;
+		[[nodiscard]] statement_cache_stats const &stats( ) const;
+		void reset_stats( );
+	};
+} // namespace daw::sqlite
@@ -0,0 +1,227 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/column_traits.h"
+#include "daw/sqlite/parameter_traits.h"
+#include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/typed_query_iterator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+namespace daw::sqlite {
+	/***
+	 * @brief SQL text usable as a template argument, e.g.
+	 * static_statement<"SELECT 1">
+	 */
+	template<std::size_t N>
+	struct sql_string {
+		char value[N]{ };
+
+		consteval sql_string( char const ( &sql )[N] ) {
+			std::copy_n( sql, N, value );
+		}
+
+		[[nodiscard]] constexpr std::string_view view( ) const {
+			return std::string_view( value, N - 1 );
+		}
+	};
+
+	/***
+	 * @brief The parameter types of a static_statement, in placeholder order
+	 */
+	template<typename... Params>
+	struct params {};
+
+	namespace static_impl {
+		// Not defined, reaching a call while counting is a compile error naming
+		// the problem
+		void numbered_and_named_parameters_are_not_supported( );
+		void unterminated_quote_or_comment( );
+
+		// Letters, digits, _ and $ continue an identifier, as do non ASCII
+		// characters
+		consteval bool is_identifier_char( char c ) {
+			return ( c >= 'a' and c <= 'z' ) or ( c >= 'A' and c <= 'Z' ) or
+			       ( c >= '0' and c <= '9' ) or c == '_' or c == '$' or
+			       static_cast<unsigned char>( c ) >= 0x80;
+		}
+
+		// The position after the next end at or after pos
+		consteval std::size_t skip_to( std::string_view sql, std::size_t pos,
+		                               std::string_view end ) {
+			auto const found = sql.find( end, pos );
+			if( found == std::string_view::npos ) {
+				unterminated_quote_or_comment( );
+			}
+			return found + end.size( );
+		}
+
+		/***
+		 * @brief The number of ? placeholders outside of literals, quoted
+		 * identifiers and comments
+		 */
+		consteval std::size_t count_placeholders( std::string_view sql ) {
+			auto result = std::size_t{ 0 };
+			std::size_t pos = 0;
+			while( pos < sql.size( ) ) {
+				switch( sql[pos] ) {
+				case '\'':
+				case '"':
+				case '`':
+					// A doubled quote is an escaped one, it is skipped as an empty
+					// quoted part
+					pos = skip_to( sql, pos + 1, sql.substr( pos, 1 ) );
+					break;
+				case '[':
+					pos = skip_to( sql, pos + 1, "]" );
+					break;
+				case '-':
+					if( sql.substr( pos, 2 ) == "--" ) {
+						auto const end = sql.find( '\n', pos );
+						pos = end == std::string_view::npos ? sql.size( ) : end + 1;
+					} else {
+						++pos;
+					}
+					break;
+				case '/':
+					if( sql.substr( pos, 2 ) == "/*" ) {
+						pos = skip_to( sql, pos + 2, "*/" );
+					} else {
+						++pos;
+					}
+					break;
+				case '?':
+					if( pos + 1 < sql.size( ) and sql[pos + 1] >= '0' and
+					    sql[pos + 1] <= '9' ) {
+						numbered_and_named_parameters_are_not_supported( );
+					}
+					++result;
+					++pos;
+					break;
+				case ':':
+				case '@':
+				case '$':
+					// Inside an identifier, e.g. a$b, it is not a parameter
+					if( pos == 0 or not is_identifier_char( sql[pos - 1] ) ) {
+						numbered_and_named_parameters_are_not_supported( );
+					}
+					++pos;
+					break;
+				default:
+					++pos;
+					break;
+				}
+			}
+			return result;
+		}
+
+		/***
+		 * @brief A process wide id for each static_statement type, indexing the
+		 * statements kept by each database
+		 */
+		[[nodiscard]] std::size_t next_statement_id( );
+	} // namespace static_impl
+
+	template<sql_string Sql, typename Params = params<>, typename Row = void>
+	class static_statement;
+
+	/***
+	 * @brief A statement whose SQL, parameter types and result row type are
+	 * known at compile time.  The number of ? placeholders must match Params,
+	 * and arguments must convert to them, or it does not compile.  Parameters
+	 * are bound straight through parameter_traits without going through
+	 * cell_value.  Each database keeps the prepared statement in a slot indexed
+	 * by the statement type, so a call does no SQL lookup.  Row is a ResultRow,
+	 * or void for statements without a result
+	 */
+	template<sql_string Sql, Parameter... Params, typename Row>
+	class static_statement<Sql, params<Params...>, Row> {
+		static_assert( std::is_void_v<Row> or ResultRow<Row>,
+		               "Row must be void or a ResultRow" );
+
+	public:
+		static constexpr std::string_view sql = Sql.view( );
+		static constexpr std::size_t parameter_count = sizeof...( Params );
+
+		static_assert( static_impl::count_placeholders( sql ) == parameter_count,
+		               "The number of ? placeholders does not match the number of "
+		               "parameters" );
+
+	private:
+		[[nodiscard]] static std::size_t id( ) {
+			static std::size_t const result = static_impl::next_statement_id( );
+			return result;
+		}
+
+		[[nodiscard]] static shared_prepared_statement
+		prepare( database &db, bind_lifetime lifetime, Params const &...args ) {
+			auto statement = db.get_static_statement( id( ), sql );
+			if constexpr( not std::is_void_v<Row> ) {
+				validate_column_count<Row>( statement.get( ) );
+			}
+			auto *const stmt = statement.get( );
+			int index = 0;
+			( bind_parameter( stmt, ++index, args, lifetime ), ... );
+			return statement;
+		}
+
+	public:
+		/***
+		 * @brief Run the statement to completion, e.g. an INSERT or UPDATE.  Text
+		 * and blobs are not copied, they only need to live for the call
+		 */
+		static void exec( database &db, Params const &...args ) {
+			auto statement = prepare( db, bind_lifetime::Static, args... );
+			while( statement.step( ) ) {}
+		}
+
+		/***
+		 * @brief The first row of the result, or nullopt when there are none.
+		 * Text and blobs are not copied.  The statement is reset before
+		 * returning, so Row must own its text and blobs, e.g. std::string
+		 */
+		template<typename R = Row>
+			requires( not std::is_void_v<R> ) //
+		[[nodiscard]] static std::optional<R> query_one( database &db,
+		                                                 Params const &...args ) {
+			auto statement = prepare( db, bind_lifetime::Static, args... );
+			auto result = std::optional<R>( );
+			try {
+				if( statement.step( ) ) {
+					validate_column_types<R>( statement.get( ) );
+					result.emplace( decode_row<R>( statement.get( ) ) );
+				}
+			} catch( ... ) {
+				// Reset here as on success, not only when the lease is released
+				statement.reset( );
+				throw;
+			}
+			statement.reset( );
+			return result;
+		}
+
+		/***
+		 * @brief Iterate the rows of the result.  Text and blob parameters are
+		 * copied by sqlite, as the iterator can outlive the arguments
+		 */
+		template<typename R = Row>
+			requires( not std::is_void_v<R> ) //
+		[[nodiscard]] static typed_query_iterator<R>
+		query( database &db, Params const &...args ) {
+			return typed_query_iterator<R>(
+			  prepare( db, bind_lifetime::Transient, args... ) );
+		}
+	};
+} // namespace daw::sqlite
@@ -0,0 +1,99 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include <daw/daw_string_view.h>
+
+#include <cstddef>
+#include <string>
+
+namespace daw::sqlite {
+	class database;
+
+	enum class transaction_mode { Deferred, Immediate, Exclusive };
+
+	/***
+	 * @brief RAII guard for BEGIN/COMMIT/ROLLBACK.  Changes are kept by an
+	 * explicit commit( ), a transaction still active on destruction is rolled
+	 * back.  The statements used come from the database's statement cache
+	 */
+	class transaction {
+		database *m_db = nullptr;
+
+	public:
+		explicit transaction( database &db,
+		                      transaction_mode mode = transaction_mode::Deferred );
+
+		transaction( transaction &&other ) noexcept;
+		transaction &operator=( transaction && ) = delete;
+		transaction( transaction const & ) = delete;
+		transaction &operator=( transaction const & ) = delete;
+
+		/***
+		 * @brief Rolls back unless committed.  A failed rollback is not reported,
+		 * sqlite rolls the transaction back when the connection is closed
+		 */
+		~transaction( );
+
+		/***
+		 * @brief Commit the transaction.  On failure, e.g. SQLITE_BUSY, the
+		 * transaction stays open so that commit can be retried
+		 */
+		void commit( );
+		void rollback( );
+
+		[[nodiscard]] bool is_active( ) const;
+	};
+
+	/***
+	 * @brief RAII guard for SAVEPOINT/RELEASE/ROLLBACK TO.  Savepoints nest
+	 * inside each other and inside or outside of a transaction.  Changes are
+	 * kept by an explicit release( ), a savepoint still active on destruction
+	 * is rolled back to and released
+	 */
+	class savepoint {
+		database *m_db = nullptr;
+		std::string m_name;
+		bool m_is_generated_name = false;
+
+		void finish( );
+
+	public:
+		/***
+		 * @brief Create a savepoint named after its nesting depth, so that the
+		 * statements are reused from the statement cache
+		 */
+		explicit savepoint( database &db );
+		savepoint( database &db, daw::string_view name );
+
+		savepoint( savepoint &&other ) noexcept;
+		savepoint &operator=( savepoint && ) = delete;
+		savepoint( savepoint const & ) = delete;
+		savepoint &operator=( savepoint const & ) = delete;
+
+		~savepoint( );
+
+		/***
+		 * @brief Keep the changes made since the savepoint
+		 */
+		void release( );
+
+		/***
+		 * @brief Undo the changes made since the savepoint and release it
+		 */
+		void rollback( );
+
+		[[nodiscard]] bool is_active( ) const;
+
+		/***
+		 * @brief The name of the savepoint, unquoted
+		 */
+		[[nodiscard]] std::string const &name( ) const;
+	};
+} // namespace daw::sqlite
@@ -0,0 +1,95 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/column_traits.h"
+#include "daw/sqlite/prepared_statement.h"
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace daw::sqlite {
+	/***
+	 * @brief An input iterator over the rows of a statement, decoding each row
+	 * directly into Row.  The column count is checked when constructed and the
+	 * column types against the first row.  Text and blob views in Row are only
+	 * valid until the iterator is incremented
+	 */
+	template<ResultRow Row>
+	class typed_query_iterator {
+	public:
+		using iterator_type = typed_query_iterator;
+		using value_type = Row;
+		using difference_type = std::ptrdiff_t;
+		using reference = value_type;
+		using iterator_category = std::input_iterator_tag;
+
+	private:
+		shared_prepared_statement m_statement{};
+		std::size_t m_row = static_cast<std::size_t>( -1 );
+
+	public:
+		explicit typed_query_iterator( ) = default;
+
+		explicit typed_query_iterator( shared_prepared_statement statement )
+		  : m_statement( std::move( statement ) ) {
+			validate_column_count<Row>( m_statement.get( ) );
+			operator++( );
+			if( m_row == 0 ) {
+				validate_column_types<Row>( m_statement.get( ) );
+			}
+		}
+
+		[[nodiscard]] value_type operator*( ) {
+			return decode_row<Row>( m_statement.get( ) );
+		}
+
+		iterator_type &operator++( ) {
+			if( m_statement.step( ) ) {
+				++m_row;
+			} else {
+				m_row = static_cast<std::size_t>( -1 );
+			}
+			return *this;
+		}
+
+		void operator++( int ) & {
+			operator++( );
+		}
+
+		[[nodiscard]] bool operator==( iterator_type const &rhs ) const {
+			if( ( m_statement == rhs.m_statement ) and ( m_row == rhs.m_row ) ) {
+				return true;
+			}
+			if( m_row != rhs.m_row ) {
+				return false;
+			}
+			return not m_statement or not rhs.m_statement;
+		}
+
+		[[nodiscard]] bool operator!=( iterator_type const & ) const = default;
+
+		[[nodiscard]] iterator_type begin( ) const {
+			return *this;
+		}
+
+		[[nodiscard]] static iterator_type end( ) {
+			return iterator_type{ };
+		}
+
+		[[nodiscard]] std::size_t row( ) const {
+			return m_row;
+		}
+
+		explicit operator bool( ) const {
+			return static_cast<bool>( m_statement );
+		}
+	};
+} // namespace daw::sqlite
@@ -0,0 +1,180 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#pragma once
+
+#include "daw/sqlite/open_options.h"
+#include "daw/sqlite/sqlite3_class.h"
+
+#include <daw/daw_move.h>
+#include <daw/daw_string_view.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace daw::sqlite {
+	struct write_queue_options {
+		open_options open = open_options::read_heavy( );
+		/// Most writes committed by one transaction
+		std::size_t max_batch = 1024;
+		/// How long a batch that is not full waits for more writes before it is
+		/// committed.  0 commits whatever is queued as soon as the writer is free
+		std::chrono::microseconds max_delay{ 0 };
+	};
+
+	struct write_queue_stats {
+		std::size_t batches = 0;
+		std::size_t writes = 0;
+		std::size_t failed_writes = 0;
+		std::size_t failed_commits = 0;
+	};
+
+	namespace write_impl {
+		/***
+		 * @brief A queued write.  run is called inside the batch transaction,
+		 * then complete once the transaction has committed or fail when it has not
+		 */
+		struct write {
+			write( ) = default;
+			write( write const & ) = delete;
+			write &operator=( write const & ) = delete;
+			virtual ~write( ) = default;
+
+			/***
+			 * @return false when the write threw, it has already been failed
+			 */
+			virtual bool run( database &db ) = 0;
+			virtual void complete( ) = 0;
+			virtual void fail( std::exception_ptr error ) = 0;
+		};
+
+		template<typename Operation>
+		struct write_impl final : write {
+			using result_t = std::invoke_result_t<Operation &, database &>;
+
+			Operation operation;
+			std::promise<result_t> promise{ };
+			std::conditional_t<std::is_void_v<result_t>, bool, std::optional<result_t>>
+			  result{ };
+
+			explicit write_impl( Operation op )
+			  : operation( std::move( op ) ) {}
+
+			bool run( database &db ) override {
+				try {
+					if constexpr( std::is_void_v<result_t> ) {
+						operation( db );
+					} else {
+						result.emplace( operation( db ) );
+					}
+					return true;
+				} catch( ... ) {
+					fail( std::current_exception( ) );
+					return false;
+				}
+			}
+
+			void complete( ) override {
+				if constexpr( std::is_void_v<result_t> ) {
+					promise.set_value( );
+				} else {
+					promise.set_value( std::move( *result ) );
+				}
+			}
+
+			void fail( std::exception_ptr error ) override {
+				promise.set_exception( std::move( error ) );
+			}
+		};
+	} // namespace write_impl
+
+	/***
+	 * @brief Serializes writes from many threads onto one connection and commits
+	 * them in groups.  A writer thread takes up to max_batch queued writes, runs
+	 * each inside its own savepoint within one IMMEDIATE transaction, and
+	 * commits once.  A write that throws is rolled back to its savepoint without
+	 * affecting the rest of the batch, unless sqlite rolled back the whole
+	 * transaction, then every write not yet committed fails and those not yet
+	 * run are not run.  Futures are completed after the commit,
+	 * so a ready future means the write is durable to the degree the
+	 * synchronous setting gives
+	 */
+	class write_queue {
+		database m_db;
+		write_queue_options m_options;
+		std::mutex m_mutex{ };
+		std::condition_variable m_has_work{ };
+		std::deque<std::unique_ptr<write_impl::write>> m_queue{ };
+		write_queue_stats m_stats{ };
+		bool m_stopping = false;
+		std::thread m_writer{ };
+
+		void enqueue( std::unique_ptr<write_impl::write> w );
+		void run( );
+		void commit_batch(
+		  std::deque<std::unique_ptr<write_impl::write>> &batch );
+
+	public:
+		explicit write_queue(
+		  std::filesystem::path const &filename,
+		  write_queue_options const &options = write_queue_options{ } );
+
+		write_queue( write_queue const & ) = delete;
+		write_queue &operator=( write_queue const & ) = delete;
+
+		/***
+		 * @brief Commits the writes already queued, then stops the writer
+		 */
+		~write_queue( );
+
+		/***
+		 * @brief Queue operation( database & ) to run on the writer inside the
+		 * next batch.  The future is ready after the batch commits
+		 */
+		template<typename Operation>
+		[[nodiscard]] auto submit( Operation operation )
+		  -> std::future<std::invoke_result_t<Operation &, database &>> {
+			auto w = std::make_unique<write_impl::write_impl<Operation>>(
+			  std::move( operation ) );
+			auto result = w->promise.get_future( );
+			enqueue( std::move( w ) );
+			return result;
+		}
+
+		/***
+		 * @brief Queue sql with the parameters bound in order.  The parameters
+		 * are copied, but views must stay valid until the future is ready
+		 */
+		template<typename... Params>
+			requires( Parameters<Params...> ) //
+		[[nodiscard]] std::future<void> submit_exec( daw::string_view sql,
+		                                             Params &&...params ) {
+			return submit( [sql = static_cast<std::string>( sql ),
+			                ... ps = std::decay_t<Params>( DAW_FWD( params ) )](
+			                 database &db ) mutable {
+				for( auto const &row : db.exec( sql, ps... ) ) {
+					(void)row;
+				}
+			} );
+		}
+
+		[[nodiscard]] write_queue_stats stats( );
+	};
+} // namespace daw::sqlite
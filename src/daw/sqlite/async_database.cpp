@@ -0,0 +1,74 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/async_database.h"
+#include "daw/sqlite/sqlite3_class.h"
+
+#include <coroutine>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace daw::sqlite {
+	async_database::async_database( std::filesystem::path const &filename,
+	                                async_database_options options )
+	  : m_db( filename, options.open )
+	  , m_options( std::move( options ) ) {
+		m_worker = std::thread( [this] { run( ); } );
+	}
+
+	async_database::~async_database( ) {
+		{
+			auto const lck = std::lock_guard( m_mutex );
+			m_stopping = true;
+		}
+		m_has_work.notify_one( );
+		m_worker.join( );
+	}
+
+	void async_database::enqueue( std::unique_ptr<async_impl::task> t ) {
+		{
+			auto const lck = std::lock_guard( m_mutex );
+			m_queue.push_back( std::move( t ) );
+		}
+		m_has_work.notify_one( );
+	}
+
+	void async_database::resume( std::coroutine_handle<> handle ) {
+		if( m_options.resume_executor ) {
+			m_options.resume_executor( handle );
+		} else {
+			handle.resume( );
+		}
+	}
+
+	void async_database::run( ) {
+		auto lck = std::unique_lock( m_mutex );
+		while( true ) {
+			m_has_work.wait( lck, [&] { return m_stopping or not m_queue.empty( ); } );
+			if( m_queue.empty( ) ) {
+				// Stopping and everything queued has run
+				return;
+			}
+			auto t = std::move( m_queue.front( ) );
+			m_queue.pop_front( );
+			lck.unlock( );
+			// Tasks report their own errors through a promise or awaitable
+			t->run( m_db );
+			t.reset( );
+			lck.lock( );
+		}
+	}
+
+	std::size_t async_database::queued( ) {
+		auto const lck = std::lock_guard( m_mutex );
+		return m_queue.size( );
+	}
+} // namespace daw::sqlite
@@ -0,0 +1,216 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/backup.h"
+#include "daw/sqlite/busy_policy.h"
+#include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <daw/daw_string_view.h>
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <sqlite3.h>
+#include <string>
+#include <thread>
+
+namespace daw::sqlite {
+	namespace backup_impl {
+		void sqlite_free_deleter::operator( )( std::byte *ptr ) const noexcept {
+			sqlite3_free( ptr );
+		}
+	} // namespace backup_impl
+
+	serialized_image::serialized_image( std::byte *data, std::size_t size ) noexcept
+	  : m_data( data )
+	  , m_size( size ) {}
+
+	std::byte const *serialized_image::data( ) const {
+		return m_data.get( );
+	}
+
+	std::size_t serialized_image::size( ) const {
+		return m_size;
+	}
+
+	std::span<std::byte const> serialized_image::bytes( ) const {
+		return { m_data.get( ), m_size };
+	}
+
+	std::byte *serialized_image::release( ) noexcept {
+		m_size = 0;
+		return m_data.release( );
+	}
+
+	namespace {
+		struct backup_deleter {
+			void operator( )( sqlite3_backup *ptr ) const noexcept {
+				(void)sqlite3_backup_finish( ptr );
+			}
+		};
+
+		/***
+		 * @return false when the progress callback stopped the backup
+		 */
+		bool run_backup( sqlite3 *destination, sqlite3 *source,
+		                 backup_options const &options ) {
+			auto backup = std::unique_ptr<sqlite3_backup, backup_deleter>(
+			  sqlite3_backup_init( destination, options.destination_schema.c_str( ),
+			                       source, options.source_schema.c_str( ) ) );
+			if( not backup ) {
+				// The error is left on the destination connection
+				throw sqlite3_exception( sqlite3_errcode( destination ) );
+			}
+			auto busy_retries = std::size_t{ 0 };
+			while( true ) {
+				auto const rc = sqlite3_backup_step( backup.get( ), options.pages_per_step );
+				if( rc == SQLITE_DONE ) {
+					break;
+				}
+				if( busy_impl::is_busy_code( rc ) ) {
+					if( ++busy_retries > options.max_busy_retries ) {
+						throw sqlite3_exception( rc );
+					}
+					std::this_thread::sleep_for( options.busy_delay );
+					continue;
+				}
+				if( rc != SQLITE_OK ) {
+					throw sqlite3_exception( rc );
+				}
+				busy_retries = 0;
+				if( options.progress and
+				    not options.progress( backup_progress{
+				      static_cast<std::size_t>( sqlite3_backup_remaining( backup.get( ) ) ),
+				      static_cast<std::size_t>( sqlite3_backup_pagecount( backup.get( ) ) ) } ) ) {
+					return false;
+				}
+				if( options.step_delay.count( ) > 0 ) {
+					std::this_thread::sleep_for( options.step_delay );
+				}
+			}
+			if( options.progress ) {
+				auto const total =
+				  static_cast<std::size_t>( sqlite3_backup_pagecount( backup.get( ) ) );
+				(void)options.progress( backup_progress{ 0, total } );
+			}
+			auto const rc = sqlite3_backup_finish( backup.release( ) );
+			if( rc != SQLITE_OK ) {
+				throw sqlite3_exception( rc );
+			}
+			return true;
+		}
+
+		void deserialize_into( sqlite3 *db, daw::string_view schema,
+		                       std::byte *image, std::size_t size,
+		                       std::size_t capacity, unsigned flags ) {
+			auto const schema_name = static_cast<std::string>( schema );
+			auto const rc = sqlite3_deserialize(
+			  db, schema_name.c_str( ), reinterpret_cast<unsigned char *>( image ),
+			  static_cast<sqlite3_int64>( size ), static_cast<sqlite3_int64>( capacity ),
+			  flags );
+			if( rc != SQLITE_OK ) {
+				throw sqlite3_exception( rc );
+			}
+		}
+	} // namespace
+
+	bool database::backup_to( database &destination,
+	                          backup_options const &options ) {
+		return run_backup( destination.get_handle( ), get_handle( ), options );
+	}
+
+	bool database::backup_to( std::filesystem::path const &filename,
+	                          backup_options const &options ) {
+		auto destination = database( filename );
+		return backup_to( destination, options );
+	}
+
+	bool database::restore_from( database &source, backup_options const &options ) {
+		return run_backup( get_handle( ), source.get_handle( ), options );
+	}
+
+	bool database::restore_from( std::filesystem::path const &filename,
+	                             backup_options const &options ) {
+		auto source_options = open_options{ };
+		source_options.read_only = true;
+		auto source = database( filename, source_options );
+		return restore_from( source, options );
+	}
+
+	database database::load_into_memory( std::filesystem::path const &filename,
+	                                     backup_options const &options ) {
+		auto result = database( ":memory:" );
+		// Backed by an empty image, so that serialize_view works on the result
+		result.deserialize( serialized_image( ) );
+		if( not result.restore_from( filename, options ) ) {
+			throw sqlite3_exception( "Loading the database into memory was stopped" );
+		}
+		return result;
+	}
+
+	serialized_image database::serialize( daw::string_view schema ) {
+		auto const schema_name = static_cast<std::string>( schema );
+		auto size = sqlite3_int64{ 0 };
+		auto *data = sqlite3_serialize( get_handle( ), schema_name.c_str( ), &size, 0 );
+		if( data == nullptr ) {
+			// An empty database has an empty image
+			if( size == 0 and sqlite3_errcode( get_handle( ) ) == SQLITE_OK ) {
+				return serialized_image( );
+			}
+			throw sqlite3_exception( SQLITE_NOMEM );
+		}
+		return serialized_image( reinterpret_cast<std::byte *>( data ),
+		                         static_cast<std::size_t>( size ) );
+	}
+
+	std::span<std::byte const> database::serialize_view( daw::string_view schema ) {
+		auto const schema_name = static_cast<std::string>( schema );
+		auto size = sqlite3_int64{ 0 };
+		auto const *data = sqlite3_serialize( get_handle( ), schema_name.c_str( ),
+		                                      &size, SQLITE_SERIALIZE_NOCOPY );
+		if( data == nullptr ) {
+			return { };
+		}
+		return { reinterpret_cast<std::byte const *>( data ),
+		         static_cast<std::size_t>( size ) };
+	}
+
+	void database::deserialize( serialized_image image, bool read_only,
+	                            daw::string_view schema ) {
+		auto const size = image.size( );
+		auto flags = static_cast<unsigned>( SQLITE_DESERIALIZE_FREEONCLOSE );
+		flags |= read_only ? static_cast<unsigned>( SQLITE_DESERIALIZE_READONLY )
+		                   : static_cast<unsigned>( SQLITE_DESERIALIZE_RESIZEABLE );
+		// sqlite frees the image, even when deserializing fails
+		deserialize_into( get_handle( ), schema, image.release( ), size, size, flags );
+	}
+
+	void database::deserialize( std::span<std::byte const> image, bool read_only,
+	                            daw::string_view schema ) {
+		auto *copy = static_cast<std::byte *>(
+		  sqlite3_malloc64( static_cast<sqlite3_uint64>( image.size( ) ) ) );
+		if( copy == nullptr and not image.empty( ) ) {
+			throw sqlite3_exception( SQLITE_NOMEM );
+		}
+		if( not image.empty( ) ) {
+			std::memcpy( copy, image.data( ), image.size( ) );
+		}
+		deserialize( serialized_image( copy, image.size( ) ), read_only, schema );
+	}
+
+	void database::deserialize_view( std::span<std::byte const> image,
+	                                 daw::string_view schema ) {
+		// Read only without FREEONCLOSE, sqlite never writes to or frees it
+		deserialize_into( get_handle( ), schema, const_cast<std::byte *>( image.data( ) ),
+		                  image.size( ), image.size( ),
+		                  static_cast<unsigned>( SQLITE_DESERIALIZE_READONLY ) );
+	}
+} // namespace daw::sqlite
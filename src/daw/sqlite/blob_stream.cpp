@@ -0,0 +1,139 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/blob_stream.h"
+#include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <daw/daw_string_view.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <sqlite3.h>
+#include <string>
+
+namespace daw::sqlite {
+	namespace blob_impl {
+		void sqlite3_blob_closer::operator( )( sqlite3_blob *ptr ) const noexcept {
+			(void)sqlite3_blob_close( ptr );
+		}
+	} // namespace blob_impl
+
+	namespace {
+		void check_blob( int rc ) {
+			if( rc != SQLITE_OK ) {
+				throw sqlite3_exception( rc );
+			}
+		}
+
+		// sqlite3_blob_read/write take int sizes and offsets
+		[[nodiscard]] int to_int( std::size_t value ) {
+			if( value > static_cast<std::size_t>( std::numeric_limits<int>::max( ) ) ) {
+				throw sqlite3_exception( SQLITE_TOOBIG );
+			}
+			return static_cast<int>( value );
+		}
+	} // namespace
+
+	blob_stream::blob_stream( database &db, daw::string_view table,
+	                          daw::string_view column, std::int64_t rowid,
+	                          blob_mode mode, daw::string_view schema ) {
+		auto const schema_name = static_cast<std::string>( schema );
+		auto const table_name = static_cast<std::string>( table );
+		auto const column_name = static_cast<std::string>( column );
+		sqlite3_blob *blob = nullptr;
+		auto const rc = sqlite3_blob_open(
+		  db.get_handle( ), schema_name.c_str( ), table_name.c_str( ),
+		  column_name.c_str( ), rowid, mode == blob_mode::ReadWrite ? 1 : 0, &blob );
+		// On failure blob may still be set and must be closed
+		m_blob.reset( blob );
+		if( rc != SQLITE_OK ) {
+			m_blob.reset( );
+			throw sqlite3_exception( rc );
+		}
+		m_size = static_cast<std::size_t>( sqlite3_blob_bytes( blob ) );
+	}
+
+	void blob_stream::reopen( std::int64_t rowid ) {
+		assert( m_blob );
+		auto const rc = sqlite3_blob_reopen( m_blob.get( ), rowid );
+		if( rc != SQLITE_OK ) {
+			// The handle is aborted and can only be closed
+			close( );
+			throw sqlite3_exception( rc );
+		}
+		m_size = static_cast<std::size_t>( sqlite3_blob_bytes( m_blob.get( ) ) );
+		m_position = 0;
+	}
+
+	void blob_stream::close( ) {
+		m_blob.reset( );
+		m_size = 0;
+		m_position = 0;
+	}
+
+	std::size_t blob_stream::size( ) const {
+		return m_size;
+	}
+
+	std::size_t blob_stream::position( ) const {
+		return m_position;
+	}
+
+	std::size_t blob_stream::remaining( ) const {
+		return m_size - m_position;
+	}
+
+	void blob_stream::seek( std::size_t position ) {
+		if( position > m_size ) {
+			throw sqlite3_exception( "Blob position is past the end of the blob" );
+		}
+		m_position = position;
+	}
+
+	std::size_t blob_stream::read( std::span<std::byte> buffer ) {
+		auto const count = std::min( buffer.size( ), remaining( ) );
+		read_at( m_position, buffer.first( count ) );
+		m_position += count;
+		return count;
+	}
+
+	void blob_stream::read_at( std::size_t offset, std::span<std::byte> buffer ) {
+		assert( m_blob );
+		if( offset > m_size or buffer.size( ) > m_size - offset ) {
+			throw sqlite3_exception( "Blob read is past the end of the blob" );
+		}
+		if( buffer.empty( ) ) {
+			return;
+		}
+		check_blob( sqlite3_blob_read( m_blob.get( ), buffer.data( ),
+		                               to_int( buffer.size( ) ), to_int( offset ) ) );
+	}
+
+	void blob_stream::write( std::span<std::byte const> data ) {
+		write_at( m_position, data );
+		m_position += data.size( );
+	}
+
+	void blob_stream::write_at( std::size_t offset,
+	                            std::span<std::byte const> data ) {
+		assert( m_blob );
+		if( offset > m_size or data.size( ) > m_size - offset ) {
+			throw sqlite3_exception( "Blob write is past the end of the blob" );
+		}
+		if( data.empty( ) ) {
+			return;
+		}
+		check_blob( sqlite3_blob_write( m_blob.get( ), data.data( ),
+		                                to_int( data.size( ) ), to_int( offset ) ) );
+	}
+} // namespace daw::sqlite
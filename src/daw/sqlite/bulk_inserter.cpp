@@ -0,0 +1,161 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/bulk_inserter.h"
+#include "daw/sqlite/identifier.h"
+#include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <daw/daw_string_view.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+namespace daw::sqlite::bulk_impl {
+	bulk_insert_state::bulk_insert_state( database &db, daw::string_view table,
+	                                      std::vector<std::string> columns,
+	                                      std::size_t column_count,
+	                                      bulk_insert_options const &options )
+	  : m_db( &db )
+	  , m_table( static_cast<std::string>( table ) )
+	  , m_columns( std::move( columns ) )
+	  , m_column_count( column_count )
+	  , m_options( options )
+	  , m_owns_transaction( not db.in_transaction( ) ) {
+		if( m_column_count == 0 ) {
+			throw sqlite3_exception( "Rows to insert must have at least one column" );
+		}
+		if( not m_columns.empty( ) and m_columns.size( ) != m_column_count ) {
+			throw sqlite3_exception(
+				"Number of columns does not match the number of row members" );
+		}
+		auto const max_variables = static_cast<std::size_t>( sqlite3_limit(
+			db.get_handle( ), SQLITE_LIMIT_VARIABLE_NUMBER, -1 ) );
+		auto const max_rows = std::max<std::size_t>( max_variables / m_column_count,
+		                                             1U );
+		m_rows_per_statement = m_options.rows_per_statement == 0
+		                         ? max_rows
+		                         : std::min( m_options.rows_per_statement, max_rows );
+		m_single = shared_prepared_statement( *m_db, insert_sql( 1 ) );
+	}
+
+	std::string bulk_insert_state::insert_sql( std::size_t row_count ) const {
+		auto result = std::string( "INSERT INTO " );
+		result += sql_impl::quote_identifier( m_table );
+		if( not m_columns.empty( ) ) {
+			result += '(';
+			for( std::size_t n = 0; n < m_columns.size( ); ++n ) {
+				if( n > 0 ) {
+					result += ',';
+				}
+				result += sql_impl::quote_identifier( m_columns[n] );
+			}
+			result += ')';
+		}
+		result += " VALUES ";
+		auto row_values = std::string( "(?" );
+		for( std::size_t n = 1; n < m_column_count; ++n ) {
+			row_values += ",?";
+		}
+		row_values += ')';
+		result.reserve( result.size( ) + row_count * ( row_values.size( ) + 1 ) );
+		for( std::size_t n = 0; n < row_count; ++n ) {
+			if( n > 0 ) {
+				result += ',';
+			}
+			result += row_values;
+		}
+		return result;
+	}
+
+	std::size_t bulk_insert_state::column_count( ) const {
+		return m_column_count;
+	}
+
+	std::size_t bulk_insert_state::rows_per_statement( ) const {
+		return m_rows_per_statement;
+	}
+
+	void bulk_insert_state::begin( ) {
+		if( m_owns_transaction and not m_transaction ) {
+			m_transaction.emplace( *m_db, transaction_mode::Immediate );
+		}
+	}
+
+	sqlite3_stmt *bulk_insert_state::single_statement( ) {
+		begin( );
+		return m_single.get( );
+	}
+
+	sqlite3_stmt *bulk_insert_state::multi_statement( ) {
+		begin( );
+		if( not m_multi ) {
+			m_multi =
+				shared_prepared_statement( *m_db, insert_sql( m_rows_per_statement ) );
+		}
+		return m_multi.get( );
+	}
+
+	void bulk_insert_state::execute( sqlite3_stmt *statement,
+	                                 std::size_t row_count,
+	                                 std::size_t byte_count ) {
+		// Stepped through the owning statement so the connection's busy policy
+		// and counters apply
+		auto &owner = statement == m_single.get( ) ? m_single : m_multi;
+		try {
+			while( owner.step( ) ) {
+				// INSERT ... RETURNING
+			}
+		} catch( ... ) {
+			(void)sqlite3_reset( statement );
+			(void)sqlite3_clear_bindings( statement );
+			throw;
+		}
+		(void)sqlite3_reset( statement );
+		// The values are bound without copying, they only live for the call
+		(void)sqlite3_clear_bindings( statement );
+		m_total_rows += row_count;
+		m_pending_rows += row_count;
+		m_pending_bytes += byte_count;
+		if( m_pending_rows >= m_options.rows_per_transaction or
+		    m_pending_bytes >= m_options.bytes_per_transaction ) {
+			commit( );
+		}
+	}
+
+	void bulk_insert_state::commit( ) {
+		if( m_transaction ) {
+			m_transaction->commit( );
+			m_transaction.reset( );
+		}
+		m_pending_rows = 0;
+		m_pending_bytes = 0;
+	}
+
+	void bulk_insert_state::rollback( ) noexcept {
+		if( m_transaction ) {
+			m_total_rows -= m_pending_rows;
+			try {
+				m_transaction->rollback( );
+			} catch( ... ) {
+				// Nothing more can be done, the transaction is abandoned
+			}
+			m_transaction.reset( );
+		}
+		m_pending_rows = 0;
+		m_pending_bytes = 0;
+	}
+
+	std::size_t bulk_insert_state::rows_inserted( ) const {
+		return m_total_rows;
+	}
+} // namespace daw::sqlite::bulk_impl
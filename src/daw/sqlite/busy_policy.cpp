@@ -0,0 +1,111 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/busy_policy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <sqlite3.h>
+#include <thread>
+
+namespace daw::sqlite::busy_impl {
+	namespace {
+		[[nodiscard]] std::chrono::microseconds
+		backoff_delay( busy_backoff const &backoff, std::size_t attempt ) {
+			auto delay = static_cast<double>( backoff.initial_delay.count( ) ) *
+			             std::pow( backoff.multiplier, static_cast<double>( attempt ) );
+			delay = std::min( delay, static_cast<double>( backoff.max_delay.count( ) ) );
+			thread_local auto rng = std::minstd_rand( std::random_device{ }( ) );
+			auto const jitter = std::clamp( backoff.jitter, 0.0, 1.0 );
+			delay *= 1.0 - jitter * std::uniform_real_distribution<double>( )( rng );
+			return std::chrono::microseconds( static_cast<std::int64_t>( delay ) );
+		}
+
+		void wait( busy_state &state, std::chrono::microseconds delay ) {
+			std::this_thread::sleep_for( delay );
+			state.waited_us += delay.count( );
+		}
+	} // namespace
+
+	busy_stats busy_state::stats( ) const {
+		auto result = busy_stats{ };
+		result.handler_calls = handler_calls;
+		result.waited = std::chrono::microseconds( waited_us );
+		result.step_retries = step_retries;
+		result.busy_errors = busy_errors;
+		return result;
+	}
+
+	void busy_state::reset_stats( ) {
+		handler_calls = 0;
+		waited_us = 0;
+		step_retries = 0;
+		busy_errors = 0;
+	}
+
+	bool is_busy_code( int rc ) noexcept {
+		auto const primary = rc & 0xFF;
+		return primary == SQLITE_BUSY or primary == SQLITE_LOCKED;
+	}
+
+	int backoff_handler( void *arg, int count ) noexcept {
+		auto &state = *static_cast<busy_state *>( arg );
+		auto const now = std::chrono::steady_clock::now( );
+		if( count == 0 ) {
+			state.wait_start = now;
+		}
+		++state.handler_calls;
+		auto const remaining = state.policy.timeout - ( now - state.wait_start );
+		if( remaining <= std::chrono::steady_clock::duration::zero( ) or
+		    not state.policy.backoff ) {
+			return 0;
+		}
+		wait( state,
+		      std::min( backoff_delay( *state.policy.backoff,
+		                               static_cast<std::size_t>( count ) ),
+		                std::chrono::ceil<std::chrono::microseconds>( remaining ) ) );
+		return 1;
+	}
+
+	int retry_initial_step( sqlite3_stmt *statement, int rc, busy_state &state ) {
+		auto const backoff = state.policy.backoff.value_or( busy_backoff{ } );
+		for( std::size_t attempt = 0;
+		     is_busy_code( rc ) and attempt < state.policy.step_retries;
+		     ++attempt ) {
+			if( sqlite3_get_autocommit( sqlite3_db_handle( statement ) ) == 0 ) {
+				// Inside a transaction the lock will not be released by waiting,
+				// the transaction has to be retried as a whole
+				break;
+			}
+			(void)sqlite3_reset( statement );
+			wait( state, backoff_delay( backoff, attempt ) );
+			++state.step_retries;
+			rc = sqlite3_step( statement );
+		}
+		return rc;
+	}
+
+	int step( sqlite3_stmt *statement, busy_state *state ) {
+		auto const is_initial = sqlite3_stmt_busy( statement ) == 0;
+		auto rc = sqlite3_step( statement );
+		if( state == nullptr or rc == SQLITE_ROW or rc == SQLITE_DONE ) {
+			return rc;
+		}
+		if( is_initial ) {
+			rc = retry_initial_step( statement, rc, *state );
+		}
+		if( is_busy_code( rc ) ) {
+			++state->busy_errors;
+		}
+		return rc;
+	}
+} // namespace daw::sqlite::busy_impl
@@ -0,0 +1,273 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/cached_kv_store.h"
+#include "daw/sqlite/kv_store.h"
+#include "daw/sqlite/sqlite3_exception.h"
+#include "daw/sqlite/transaction.h"
+
+#include <daw/daw_string_view.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace daw::db {
+	namespace {
+		kv_store_options uncached( kv_store_options options ) {
+			options.read_cache_bytes = 0;
+			return options;
+		}
+
+		std::string_view to_key( daw::string_view key ) {
+			return std::string_view( key.data( ), key.size( ) );
+		}
+	} // namespace
+
+	cached_kv_store::cached_kv_store( std::filesystem::path const &filename,
+	                                  cached_kv_store_options const &options )
+	  : m_options( options )
+	  , m_store( filename, uncached( options.store ) )
+	  , m_shards(
+	      std::make_unique<shard[]>( std::max<std::size_t>( options.shard_count, 1U ) ) ) {
+		m_options.shard_count = std::max<std::size_t>( m_options.shard_count, 1U );
+		for( std::size_t n = 0; n < m_options.shard_count; ++n ) {
+			m_shards[n].cache.set_capacity_bytes( m_options.cache_bytes /
+			                                      m_options.shard_count );
+		}
+		if( m_options.flush_interval.count( ) > 0 ) {
+			m_flusher = std::thread( [this] { flush_loop( ); } );
+		}
+	}
+
+	cached_kv_store::~cached_kv_store( ) {
+		if( m_flusher.joinable( ) ) {
+			{
+				auto const lck = std::lock_guard( m_pending_mutex );
+				m_stopping = true;
+			}
+			m_flush_wake.notify_one( );
+			m_flusher.join( );
+		}
+		try {
+			flush_pending( );
+		} catch( ... ) {
+			// Nowhere to report it from a destructor
+		}
+	}
+
+	cached_kv_store::shard &
+	cached_kv_store::shard_for( std::string_view key ) const {
+		return m_shards[std::hash<std::string_view>{ }( key ) %
+		                m_options.shard_count];
+	}
+
+	std::optional<std::string>
+	cached_kv_store::get_encoded( daw::string_view key ) {
+		auto const k = to_key( key );
+		auto &s = shard_for( k );
+		auto generation = std::uint64_t{ };
+		{
+			auto const lck = std::lock_guard( s.mutex );
+			if( auto const *value = s.cache.find( k ) ) {
+				return *value;
+			}
+			generation = s.generation;
+		}
+		auto result = std::optional<std::string>( );
+		{
+			// Flushes hold the store lock from taking the buffer until the commit,
+			// so a key is always either buffered or in the store
+			auto const store_lck = std::lock_guard( m_store_mutex );
+			auto pending_lck = std::unique_lock( m_pending_mutex );
+			if( auto pos = m_pending.find( k );
+			    pos != m_pending.end( ) ) {
+				return pos->second;
+			}
+			pending_lck.unlock( );
+			result = m_store.get_encoded( key );
+		}
+		if( result ) {
+			auto const lck = std::lock_guard( s.mutex );
+			if( s.generation == generation ) {
+				s.cache.insert_or_assign( k, *result );
+			}
+		}
+		return result;
+	}
+
+	void cached_kv_store::write( std::string const &key,
+	                             std::optional<std::string> const &value ) {
+		// Buffered before the cache is updated, a read that misses the cache
+		// after this always finds the write in the buffer or the store
+		auto should_flush = false;
+		auto &s = shard_for( key );
+		{
+			auto const lck = std::lock_guard( m_pending_mutex );
+			if( m_flush_error ) {
+				std::rethrow_exception( std::exchange( m_flush_error, nullptr ) );
+			}
+			auto const size = key.size( ) + ( value ? value->size( ) : 0U );
+			auto [pos, inserted] = m_pending.try_emplace( key );
+			if( not inserted ) {
+				m_pending_bytes -=
+				  pos->first.size( ) + ( pos->second ? pos->second->size( ) : 0U );
+			}
+			pos->second = value;
+			m_pending_bytes += size;
+			should_flush = m_pending.size( ) >= m_options.max_pending_writes or
+			               m_pending_bytes >= m_options.max_pending_bytes;
+		}
+		{
+			auto const lck = std::lock_guard( s.mutex );
+			++s.generation;
+			if( value ) {
+				s.cache.insert_or_assign( key, *value );
+			} else {
+				s.cache.erase( key );
+			}
+		}
+		if( should_flush ) {
+			// The write is already buffered and cached, so a failure is kept like
+			// one of the background flush.  A throw from put or erase then always
+			// means that the write was not made
+			try {
+				flush_pending( );
+			} catch( ... ) {
+				auto const lck = std::lock_guard( m_pending_mutex );
+				m_flush_error = std::current_exception( );
+			}
+		}
+	}
+
+	void cached_kv_store::put_encoded( daw::string_view key,
+	                                   daw::string_view value ) {
+		write( std::string( key.data( ), key.size( ) ),
+		       std::string( value.data( ), value.size( ) ) );
+	}
+
+	void cached_kv_store::erase_encoded( daw::string_view key ) {
+		write( std::string( key.data( ), key.size( ) ), std::nullopt );
+	}
+
+	void cached_kv_store::flush( ) {
+		{
+			auto const lck = std::lock_guard( m_pending_mutex );
+			if( m_flush_error ) {
+				std::rethrow_exception( std::exchange( m_flush_error, nullptr ) );
+			}
+		}
+		flush_pending( );
+	}
+
+	void cached_kv_store::flush_pending( ) {
+		auto const store_lck = std::lock_guard( m_store_mutex );
+		auto batch = pending_map_t( );
+		auto batch_bytes = std::size_t{ 0 };
+		{
+			auto const lck = std::lock_guard( m_pending_mutex );
+			batch.swap( m_pending );
+			std::swap( batch_bytes, m_pending_bytes );
+		}
+		if( batch.empty( ) ) {
+			return;
+		}
+		try {
+			auto tx = sqlite::transaction( m_store.get_database( ),
+			                               sqlite::transaction_mode::Immediate );
+			for( auto const &[key, value] : batch ) {
+				if( value ) {
+					m_store.put_encoded( key, *value );
+				} else {
+					(void)m_store.erase_encoded( key );
+				}
+			}
+			tx.commit( );
+		} catch( ... ) {
+			// Put the batch back, writes made since the swap are newer and win
+			auto const lck = std::lock_guard( m_pending_mutex );
+			for( auto &[key, value] : batch ) {
+				if( not m_pending.contains( key ) ) {
+					m_pending_bytes += key.size( ) + ( value ? value->size( ) : 0U );
+					m_pending.emplace( key, std::move( value ) );
+				}
+			}
+			++m_failed_flushes;
+			throw;
+		}
+		auto const lck = std::lock_guard( m_pending_mutex );
+		++m_flushes;
+		m_flushed_writes += batch.size( );
+	}
+
+	void cached_kv_store::flush_loop( ) {
+		auto lck = std::unique_lock( m_pending_mutex );
+		while( not m_stopping ) {
+			m_flush_wake.wait_for( lck, m_options.flush_interval, [&] {
+				return m_stopping;
+			} );
+			if( m_stopping or m_pending.empty( ) ) {
+				continue;
+			}
+			lck.unlock( );
+			auto error = std::exception_ptr( );
+			try {
+				flush_pending( );
+			} catch( ... ) {
+				// The writes stay buffered and are retried on the next interval
+				error = std::current_exception( );
+			}
+			lck.lock( );
+			if( error ) {
+				m_flush_error = std::move( error );
+			}
+		}
+	}
+
+	std::size_t cached_kv_store::pending_writes( ) {
+		auto const lck = std::lock_guard( m_pending_mutex );
+		return m_pending.size( );
+	}
+
+	cached_kv_store_stats cached_kv_store::stats( ) {
+		auto result = cached_kv_store_stats{ };
+		for( std::size_t n = 0; n < m_options.shard_count; ++n ) {
+			auto const lck = std::lock_guard( m_shards[n].mutex );
+			auto const &shard_stats = m_shards[n].cache.stats( );
+			result.hits += shard_stats.hits;
+			result.misses += shard_stats.misses;
+			result.evictions += shard_stats.evictions;
+		}
+		auto const lck = std::lock_guard( m_pending_mutex );
+		result.flushes = m_flushes;
+		result.flushed_writes = m_flushed_writes;
+		result.failed_flushes = m_failed_flushes;
+		return result;
+	}
+
+	void cached_kv_store::reset_stats( ) {
+		for( std::size_t n = 0; n < m_options.shard_count; ++n ) {
+			auto const lck = std::lock_guard( m_shards[n].mutex );
+			m_shards[n].cache.reset_stats( );
+		}
+		auto const lck = std::lock_guard( m_pending_mutex );
+		m_flushes = 0;
+		m_flushed_writes = 0;
+		m_failed_flushes = 0;
+	}
+} // namespace daw::db
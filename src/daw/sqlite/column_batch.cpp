@@ -0,0 +1,236 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/column_batch.h"
+#include "daw/sqlite/row_cursor.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <daw/daw_string_view.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace daw::sqlite {
+	namespace {
+		[[noreturn]] void throw_type_mismatch( ) {
+			throw sqlite3_exception(
+			  "Column value type does not match the batch column type" );
+		}
+	} // namespace
+
+	void batch_column::set_type( column_type type ) {
+		// Rows before the first non null value were all null
+		m_type = type;
+		switch( type ) {
+		case column_type::Integer:
+			m_integers.assign( m_size, 0 );
+			break;
+		case column_type::Float:
+			m_floats.assign( m_size, 0.0 );
+			break;
+		case column_type::Text:
+		case column_type::Blob:
+			m_offsets.assign( m_size + 1, 0 );
+			break;
+		case column_type::Null:
+			break;
+		}
+	}
+
+	void batch_column::start_row( ) {
+		if( m_size % 64U == 0 ) {
+			m_nulls.push_back( 0 );
+		}
+	}
+
+	void batch_column::append_null( ) {
+		start_row( );
+		m_nulls[m_size / 64U] |= std::uint64_t{ 1 } << ( m_size % 64U );
+		switch( m_type ) {
+		case column_type::Integer:
+			m_integers.push_back( 0 );
+			break;
+		case column_type::Float:
+			m_floats.push_back( 0.0 );
+			break;
+		case column_type::Text:
+		case column_type::Blob:
+			m_offsets.push_back( m_arena.size( ) );
+			break;
+		case column_type::Null:
+			break;
+		}
+		++m_null_count;
+		++m_size;
+	}
+
+	void batch_column::append_integer( std::int64_t value ) {
+		switch( m_type ) {
+		case column_type::Null:
+			set_type( column_type::Integer );
+			[[fallthrough]];
+		case column_type::Integer:
+			m_integers.push_back( value );
+			break;
+		case column_type::Float:
+			m_floats.push_back( static_cast<double>( value ) );
+			break;
+		default:
+			throw_type_mismatch( );
+		}
+		start_row( );
+		++m_size;
+	}
+
+	void batch_column::append_float( double value ) {
+		switch( m_type ) {
+		case column_type::Null:
+			set_type( column_type::Float );
+			break;
+		case column_type::Integer:
+			// Widen the column, doubles represent the values sums are taken over
+			m_floats.assign( m_integers.begin( ), m_integers.end( ) );
+			m_integers.clear( );
+			m_type = column_type::Float;
+			break;
+		case column_type::Float:
+			break;
+		default:
+			throw_type_mismatch( );
+		}
+		m_floats.push_back( value );
+		start_row( );
+		++m_size;
+	}
+
+	void batch_column::append_bytes( char const *data, std::size_t size,
+	                                 column_type type ) {
+		switch( m_type ) {
+		case column_type::Null:
+			set_type( type );
+			break;
+		case column_type::Text:
+		case column_type::Blob:
+			break;
+		default:
+			throw_type_mismatch( );
+		}
+		m_arena.insert( m_arena.end( ), data, data + size );
+		m_offsets.push_back( m_arena.size( ) );
+		start_row( );
+		++m_size;
+	}
+
+	void batch_column::clear( ) {
+		m_type = column_type::Null;
+		m_size = 0;
+		m_null_count = 0;
+		m_integers.clear( );
+		m_floats.clear( );
+		m_nulls.clear( );
+		m_arena.clear( );
+		m_offsets.clear( );
+	}
+
+	void column_batch::reset_columns( std::size_t column_count ) {
+		m_columns.resize( column_count );
+		clear( );
+	}
+
+	void column_batch::set_column_name( std::size_t column,
+	                                    daw::string_view name ) {
+		m_columns[column].m_name.assign( name.data( ), name.size( ) );
+	}
+
+	void column_batch::append_row( row_cursor const &cursor ) {
+		for( std::size_t column = 0; column != m_columns.size( ); ++column ) {
+			auto &col = m_columns[column];
+			switch( cursor.get_column_type( column ) ) {
+			case column_type::Integer:
+				col.append_integer( cursor.get_column_integer( column ) );
+				break;
+			case column_type::Float:
+				col.append_float( cursor.get_column_float( column ) );
+				break;
+			case column_type::Text: {
+				auto const text = cursor.get_column_text( column );
+				col.append_bytes( text.data( ), text.size( ), column_type::Text );
+				break;
+			}
+			case column_type::Blob: {
+				auto const blob = cursor.get_column_blob( column );
+				col.append_bytes( reinterpret_cast<char const *>( blob.data( ) ),
+				                  blob.size( ),
+				                  column_type::Blob );
+				break;
+			}
+			case column_type::Null:
+				col.append_null( );
+				break;
+			}
+		}
+		++m_size;
+	}
+
+	void column_batch::append_row( cell_value const *cells ) {
+		for( std::size_t column = 0; column != m_columns.size( ); ++column ) {
+			auto &col = m_columns[column];
+			auto const &cell = cells[column];
+			switch( cell.get_type( ) ) {
+			case column_type::Integer:
+				col.append_integer( cell.get_integer( ) );
+				break;
+			case column_type::Float:
+				col.append_float( cell.get_float( ) );
+				break;
+			case column_type::Text: {
+				auto const text = cell.get_text( );
+				col.append_bytes( text.data( ), text.size( ), column_type::Text );
+				break;
+			}
+			case column_type::Blob: {
+				auto const blob = cell.get_blob( );
+				col.append_bytes( reinterpret_cast<char const *>( blob.data( ) ),
+				                  blob.size( ),
+				                  column_type::Blob );
+				break;
+			}
+			case column_type::Null:
+				col.append_null( );
+				break;
+			}
+		}
+		++m_size;
+	}
+
+	std::optional<std::size_t>
+	column_batch::get_index_of( daw::string_view name ) const {
+		auto const pos = std::ranges::find( m_columns, name, &batch_column::name );
+		if( pos == m_columns.end( ) ) {
+			return std::nullopt;
+		}
+		return static_cast<std::size_t>( pos - m_columns.begin( ) );
+	}
+
+	batch_column const &column_batch::column( daw::string_view name ) const {
+		auto const idx = get_index_of( name );
+		if( not idx ) {
+			throw sqlite3_exception( "No column with the requested name" );
+		}
+		return m_columns[*idx];
+	}
+
+	void column_batch::clear( ) {
+		m_size = 0;
+		for( auto &col : m_columns ) {
+			col.clear( );
+		}
+	}
+} // namespace daw::sqlite
@@ -0,0 +1,59 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/column_metadata.h"
+#include "daw/sqlite/row_cursor.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace daw::sqlite {
+	column_metadata::column_metadata( std::vector<std::string> names )
+	  : m_names( std::move( names ) ) {
+		build_index( );
+	}
+
+	column_metadata::column_metadata( row_cursor const &cursor ) {
+		auto const column_count = cursor.get_column_count( );
+		m_names.reserve( column_count );
+		for( std::size_t column = 0; column != column_count; ++column ) {
+			auto const name = cursor.get_column_name( column );
+			m_names.emplace_back( name.data( ), name.size( ) );
+		}
+		build_index( );
+	}
+
+	void column_metadata::build_index( ) {
+		m_hashes.clear( );
+		m_slots.clear( );
+		if( m_names.empty( ) ) {
+			return;
+		}
+		m_hashes.reserve( m_names.size( ) );
+		// At most half full keeps probe sequences short
+		m_slots.resize( std::bit_ceil( m_names.size( ) * 2U ), 0 );
+		auto const mask = m_slots.size( ) - 1U;
+		for( std::size_t column = 0; column != m_names.size( ); ++column ) {
+			auto const h = hash( m_names[column] );
+			m_hashes.push_back( h );
+			if( get_index_of( m_names[column] ) ) {
+				// A repeated name, the first column keeps it
+				continue;
+			}
+			auto pos = h & mask;
+			while( m_slots[pos] != 0 ) {
+				pos = ( pos + 1U ) & mask;
+			}
+			m_slots[pos] = static_cast<std::uint32_t>( column + 1U );
+		}
+	}
+} // namespace daw::sqlite
@@ -0,0 +1,191 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/connection_pool.h"
+#include "daw/sqlite/open_options.h"
+#include "daw/sqlite/sqlite3_class.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <sqlite3.h>
+#include <thread>
+#include <utility>
+
+namespace daw::sqlite {
+	namespace {
+		/***
+		 * @brief Return a connection to the state the next lease expects.  Any
+		 * statement left running is reset and an open transaction rolled back,
+		 * otherwise a lock or a stale read snapshot would be handed on
+		 */
+		void clean_up( database &db ) noexcept {
+			auto *handle = db.get_handle( );
+			for( auto *statement = sqlite3_next_stmt( handle, nullptr );
+			     statement != nullptr;
+			     statement = sqlite3_next_stmt( handle, statement ) ) {
+				(void)sqlite3_reset( statement );
+			}
+			if( db.in_transaction( ) ) {
+				(void)sqlite3_exec( handle, "ROLLBACK;", nullptr, nullptr, nullptr );
+			}
+		}
+	} // namespace
+
+	connection_lease::connection_lease( connection_pool &pool, database &db,
+	                                    bool is_writer )
+	  : m_pool( &pool )
+	  , m_db( &db )
+	  , m_is_writer( is_writer ) {}
+
+	connection_lease::connection_lease( connection_lease &&other ) noexcept
+	  : m_pool( std::exchange( other.m_pool, nullptr ) )
+	  , m_db( std::exchange( other.m_db, nullptr ) )
+	  , m_is_writer( other.m_is_writer ) {}
+
+	connection_lease &
+	connection_lease::operator=( connection_lease &&rhs ) noexcept {
+		if( this != &rhs ) {
+			release( );
+			m_pool = std::exchange( rhs.m_pool, nullptr );
+			m_db = std::exchange( rhs.m_db, nullptr );
+			m_is_writer = rhs.m_is_writer;
+		}
+		return *this;
+	}
+
+	connection_lease::~connection_lease( ) {
+		release( );
+	}
+
+	void connection_lease::release( ) {
+		if( m_db ) {
+			auto *db = std::exchange( m_db, nullptr );
+			std::exchange( m_pool, nullptr )->release( *db, m_is_writer );
+		}
+	}
+
+	database &connection_lease::get( ) const {
+		assert( m_db );
+		return *m_db;
+	}
+
+	database &connection_lease::operator*( ) const {
+		return get( );
+	}
+
+	database *connection_lease::operator->( ) const {
+		return &get( );
+	}
+
+	bool connection_lease::is_writer( ) const {
+		return m_is_writer;
+	}
+
+	connection_pool::connection_pool( std::filesystem::path const &filename,
+	                                  connection_pool_options const &options ) {
+		// The writer creates the file and switches it to WAL before the readers
+		// open it.  A lease gives one thread exclusive use of a connection, so
+		// sqlite's per connection mutex is not needed
+		auto writer_options = options.writer_options;
+		writer_options.read_only = false;
+		writer_options.no_mutex = true;
+		writer_options.journal = journal_mode::WAL;
+		m_writer.open( filename, writer_options );
+		{
+			// An in memory database cannot be shared or use WAL
+			auto statement =
+			  shared_prepared_statement( m_writer, "PRAGMA journal_mode;" );
+			if( not statement.step( ) or
+			    statement.get_column_text( 0 ) != daw::string_view( "wal" ) ) {
+				throw sqlite3_exception(
+				  "connection_pool requires a database file in WAL mode" );
+			}
+		}
+
+		auto reader_options = options.reader_options;
+		reader_options.read_only = true;
+		reader_options.no_mutex = true;
+		auto const reader_count =
+		  options.reader_count == 0
+		    ? std::max( std::thread::hardware_concurrency( ), 1U )
+		    : options.reader_count;
+		m_readers.reserve( reader_count );
+		for( std::size_t n = 0; n < reader_count; ++n ) {
+			m_readers.emplace_back( filename, reader_options );
+		}
+		m_idle_readers.reserve( reader_count );
+		for( auto &reader : m_readers ) {
+			m_idle_readers.push_back( &reader );
+		}
+	}
+
+	void connection_pool::release( database &db, bool is_writer ) {
+		clean_up( db );
+		{
+			auto const lck = std::lock_guard( m_mutex );
+			if( is_writer ) {
+				m_writer_in_use = false;
+			} else {
+				m_idle_readers.push_back( &db );
+			}
+		}
+		if( is_writer ) {
+			m_writer_released.notify_one( );
+		} else {
+			m_reader_released.notify_one( );
+		}
+	}
+
+	connection_lease connection_pool::acquire_reader( ) {
+		auto lck = std::unique_lock( m_mutex );
+		m_reader_released.wait( lck, [&] { return not m_idle_readers.empty( ); } );
+		auto *db = m_idle_readers.back( );
+		m_idle_readers.pop_back( );
+		return connection_lease( *this, *db, false );
+	}
+
+	std::optional<connection_lease>
+	connection_pool::try_acquire_reader( std::chrono::milliseconds timeout ) {
+		auto lck = std::unique_lock( m_mutex );
+		if( not m_reader_released.wait_for( lck, timeout, [&] {
+			    return not m_idle_readers.empty( );
+		    } ) ) {
+			return std::nullopt;
+		}
+		auto *db = m_idle_readers.back( );
+		m_idle_readers.pop_back( );
+		return connection_lease( *this, *db, false );
+	}
+
+	connection_lease connection_pool::acquire_writer( ) {
+		auto lck = std::unique_lock( m_mutex );
+		m_writer_released.wait( lck, [&] { return not m_writer_in_use; } );
+		m_writer_in_use = true;
+		return connection_lease( *this, m_writer, true );
+	}
+
+	std::optional<connection_lease>
+	connection_pool::try_acquire_writer( std::chrono::milliseconds timeout ) {
+		auto lck = std::unique_lock( m_mutex );
+		if( not m_writer_released.wait_for( lck, timeout, [&] {
+			    return not m_writer_in_use;
+		    } ) ) {
+			return std::nullopt;
+		}
+		m_writer_in_use = true;
+		return connection_lease( *this, m_writer, true );
+	}
+
+	std::size_t connection_pool::reader_count( ) const {
+		return m_readers.size( );
+	}
+} // namespace daw::sqlite
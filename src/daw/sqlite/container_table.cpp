@@ -0,0 +1,48 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/container_table.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <daw/daw_string_view.h>
+
+#include <cstddef>
+#include <sqlite3.h>
+#include <string>
+
+namespace daw::sqlite::vtab_impl {
+	void set_error( sqlite3_vtab *vtab, char const *message ) noexcept {
+		sqlite3_free( vtab->zErrMsg );
+		vtab->zErrMsg = sqlite3_mprintf( "%s", message );
+	}
+
+	bool has_binary_collation( sqlite3_index_info *info,
+	                           std::size_t constraint ) noexcept {
+		char const *collation =
+		  sqlite3_vtab_collation( info, static_cast<int>( constraint ) );
+		return collation == nullptr or sqlite3_stricmp( collation, "BINARY" ) == 0;
+	}
+
+	void create_module( sqlite3 *db, daw::string_view name,
+	                    sqlite3_module const *module, void *aux,
+	                    void ( *destroy )( void * ) ) {
+		auto module_name = std::string( );
+		try {
+			module_name = static_cast<std::string>( name );
+		} catch( ... ) {
+			destroy( aux );
+			throw;
+		}
+		// Calls destroy( aux ) itself when it fails
+		auto const rc =
+		  sqlite3_create_module_v2( db, module_name.c_str( ), module, aux, destroy );
+		if( rc != SQLITE_OK ) {
+			throw sqlite3_exception( rc );
+		}
+	}
+} // namespace daw::sqlite::vtab_impl
@@ -0,0 +1,116 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/functions.h"
+#include "daw/sqlite/cell_value.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <daw/daw_string_view.h>
+
+#include <exception>
+#include <new>
+#include <sqlite3.h>
+#include <string>
+
+namespace daw::sqlite {
+	int function_options::flags( ) const {
+		auto result = SQLITE_UTF8;
+		if( deterministic ) {
+			result |= SQLITE_DETERMINISTIC;
+		}
+		if( innocuous ) {
+			result |= SQLITE_INNOCUOUS;
+		}
+		if( direct_only ) {
+			result |= SQLITE_DIRECTONLY;
+		}
+		return result;
+	}
+
+	void result_traits<cell_value>::set( sqlite3_context *ctx,
+	                                     cell_value const &value ) {
+		switch( value.get_type( ) ) {
+		case column_type::Float:
+			sqlite3_result_double( ctx, value.get_float( ) );
+			break;
+		case column_type::Integer:
+			sqlite3_result_int64( ctx, value.get_integer( ) );
+			break;
+		case column_type::Text:
+			result_traits<types::text_t>::set( ctx, value.get_text( ) );
+			break;
+		case column_type::Blob:
+			result_traits<types::blob_t>::set( ctx, value.get_blob( ) );
+			break;
+		case column_type::Null:
+			sqlite3_result_null( ctx );
+			break;
+		}
+	}
+
+	namespace function_impl {
+		void report_exception( sqlite3_context *ctx ) noexcept {
+			try {
+				throw;
+			} catch( std::bad_alloc const & ) {
+				sqlite3_result_error_nomem( ctx );
+			} catch( std::exception const &ex ) {
+				sqlite3_result_error( ctx, ex.what( ), -1 );
+			} catch( ... ) {
+				sqlite3_result_error( ctx, "Unknown exception in function", -1 );
+			}
+		}
+
+		void report_argument_mismatch( sqlite3_context *ctx ) {
+			sqlite3_result_error(
+			  ctx, "Function arguments do not match the parameter types", -1 );
+		}
+
+		void create_function(
+		  sqlite3 *db, daw::string_view name, int arg_count,
+		  function_options const &options, void *app,
+		  void ( *x_func )( sqlite3_context *, int, sqlite3_value ** ),
+		  void ( *x_step )( sqlite3_context *, int, sqlite3_value ** ),
+		  void ( *x_final )( sqlite3_context * ),
+		  void ( *x_value )( sqlite3_context * ),
+		  void ( *x_inverse )( sqlite3_context *, int, sqlite3_value ** ),
+		  void ( *destroy )( void * ) ) {
+			auto function_name = std::string( );
+			try {
+				function_name = static_cast<std::string>( name );
+			} catch( ... ) {
+				destroy( app );
+				throw;
+			}
+			// Both call destroy( app ) themselves when they fail
+			auto const rc =
+			  x_inverse ? sqlite3_create_window_function( db,
+			                                              function_name.c_str( ),
+			                                              arg_count,
+			                                              options.flags( ),
+			                                              app,
+			                                              x_step,
+			                                              x_final,
+			                                              x_value,
+			                                              x_inverse,
+			                                              destroy )
+			            : sqlite3_create_function_v2( db,
+			                                          function_name.c_str( ),
+			                                          arg_count,
+			                                          options.flags( ),
+			                                          app,
+			                                          x_func,
+			                                          x_step,
+			                                          x_final,
+			                                          destroy );
+			if( rc != SQLITE_OK ) {
+				throw sqlite3_exception( rc );
+			}
+		}
+	} // namespace function_impl
+} // namespace daw::sqlite
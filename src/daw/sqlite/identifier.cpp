@@ -0,0 +1,29 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/identifier.h"
+
+#include <daw/daw_string_view.h>
+
+#include <string>
+
+namespace daw::sqlite::sql_impl {
+	std::string quote_identifier( daw::string_view name ) {
+		auto result = std::string( );
+		result.reserve( name.size( ) + 2 );
+		result += '"';
+		for( char c : name ) {
+			if( c == '"' ) {
+				result += '"';
+			}
+			result += c;
+		}
+		result += '"';
+		return result;
+	}
+} // namespace daw::sqlite::sql_impl
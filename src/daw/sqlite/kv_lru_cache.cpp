@@ -0,0 +1,108 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/kv_lru_cache.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace daw::db {
+	lru_cache::lru_cache( std::size_t capacity_bytes )
+	  : m_capacity_bytes( capacity_bytes ) {}
+
+	std::size_t lru_cache::entry_bytes( std::size_t key_size,
+	                                    std::size_t value_size ) {
+		// A list node, an index node and its bucket, roughly
+		return key_size + value_size + sizeof( entry_t ) + 64U;
+	}
+
+	std::string const *lru_cache::find( std::string_view key ) {
+		auto pos = m_index.find( key );
+		if( pos == m_index.end( ) ) {
+			++m_stats.misses;
+			return nullptr;
+		}
+		++m_stats.hits;
+		m_entries.splice( m_entries.begin( ), m_entries, pos->second );
+		return &pos->second->value;
+	}
+
+	void lru_cache::insert_or_assign( std::string_view key,
+	                                  std::string_view value ) {
+		auto const size = entry_bytes( key.size( ), value.size( ) );
+		if( size > m_capacity_bytes ) {
+			erase( key );
+			return;
+		}
+		if( auto pos = m_index.find( key ); pos != m_index.end( ) ) {
+			auto entry = pos->second;
+			m_bytes -= entry_bytes( entry->key.size( ), entry->value.size( ) );
+			entry->value.assign( value );
+			m_entries.splice( m_entries.begin( ), m_entries, entry );
+		} else {
+			m_entries.push_front( entry_t{ std::string( key ), std::string( value ) } );
+			m_index.emplace( m_entries.front( ).key, m_entries.begin( ) );
+		}
+		m_bytes += size;
+		evict_to( m_capacity_bytes );
+	}
+
+	void lru_cache::evict_to( std::size_t bytes ) {
+		while( m_bytes > bytes and not m_entries.empty( ) ) {
+			auto const &entry = m_entries.back( );
+			m_bytes -= entry_bytes( entry.key.size( ), entry.value.size( ) );
+			m_index.erase( entry.key );
+			m_entries.pop_back( );
+			++m_stats.evictions;
+		}
+	}
+
+	bool lru_cache::erase( std::string_view key ) {
+		auto pos = m_index.find( key );
+		if( pos == m_index.end( ) ) {
+			return false;
+		}
+		auto entry = pos->second;
+		m_bytes -= entry_bytes( entry->key.size( ), entry->value.size( ) );
+		m_index.erase( pos );
+		m_entries.erase( entry );
+		return true;
+	}
+
+	void lru_cache::clear( ) {
+		m_index.clear( );
+		m_entries.clear( );
+		m_bytes = 0;
+	}
+
+	void lru_cache::set_capacity_bytes( std::size_t capacity_bytes ) {
+		m_capacity_bytes = capacity_bytes;
+		evict_to( m_capacity_bytes );
+	}
+
+	std::size_t lru_cache::capacity_bytes( ) const {
+		return m_capacity_bytes;
+	}
+
+	std::size_t lru_cache::bytes( ) const {
+		return m_bytes;
+	}
+
+	std::size_t lru_cache::size( ) const {
+		return m_entries.size( );
+	}
+
+	lru_cache_stats const &lru_cache::stats( ) const {
+		return m_stats;
+	}
+
+	void lru_cache::reset_stats( ) {
+		m_stats = lru_cache_stats{ };
+	}
+} // namespace daw::db
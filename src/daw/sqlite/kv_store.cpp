@@ -7,16 +7,195 @@
 //
 
 #include "daw/sqlite/kv_store.h"
+#include "daw/sqlite/identifier.h"
+#include "daw/sqlite/prepared_statement.h"
 #include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/sqlite3_exception.h"
+#include "daw/sqlite/transaction.h"
 
 #include <daw/daw_string_view.h>
 
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <sqlite3.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 namespace daw::db {
-	kv_store::kv_store( daw::string_view filename ) {}
+	namespace {
+		void bind_bytes( sqlite3_stmt *statement, int index,
+		                 daw::string_view bytes ) {
+			// The bytes outlive the step, there is no need for sqlite to copy them
+			auto const rc = sqlite3_bind_blob64( statement,
+			                                     index,
+			                                     bytes.data( ),
+			                                     bytes.size( ),
+			                                     SQLITE_STATIC );
+			if( rc != SQLITE_OK ) {
+				throw sqlite::sqlite3_exception( rc );
+			}
+		}
+
+		std::string_view to_key( daw::string_view key ) {
+			return std::string_view( key.data( ), key.size( ) );
+		}
+
+		/***
+		 * @brief Resets a statement when leaving the scope, also when step threw
+		 */
+		struct reset_on_exit {
+			sqlite3_stmt *statement;
+
+			explicit reset_on_exit( sqlite3_stmt *stmt )
+			  : statement( stmt ) {}
+
+			reset_on_exit( reset_on_exit const & ) = delete;
+			reset_on_exit &operator=( reset_on_exit const & ) = delete;
+
+			~reset_on_exit( ) {
+				(void)sqlite3_reset( statement );
+			}
+		};
+	} // namespace
+
+	kv_store::kv_store( std::filesystem::path const &filename,
+	                    kv_store_options const &options )
+	  : m_db( filename, options.open ) {
+		auto const table = sqlite::sql_impl::quote_identifier( options.table );
+		m_db.exec( "CREATE TABLE IF NOT EXISTS " + table +
+		           " ( key BLOB PRIMARY KEY NOT NULL, value BLOB NOT NULL ) "
+		           "WITHOUT ROWID;" );
+		m_get = sqlite::shared_prepared_statement(
+		  m_db, "SELECT value FROM " + table + " WHERE key=?;" );
+		m_put = sqlite::shared_prepared_statement(
+		  m_db,
+		  "INSERT INTO " + table +
+		    " ( key, value ) VALUES( ?, ? ) ON CONFLICT( key ) DO UPDATE SET "
+		    "value=excluded.value;" );
+		m_erase = sqlite::shared_prepared_statement(
+		  m_db, "DELETE FROM " + table + " WHERE key=?;" );
+		if( options.read_cache_bytes > 0 ) {
+			m_cache.emplace( options.read_cache_bytes );
+		}
+	}
 
 	kv_store::~kv_store( ) = default;
 
-	std::string kv_store::operator( )( size_t hash ) {
-		return "";
+	std::optional<std::string> kv_store::fetch( daw::string_view key ) {
+		auto *statement = m_get.get( );
+		bind_bytes( statement, 1, key );
+		auto const reset = reset_on_exit( statement );
+		// Stepped through the statement so the connection's busy policy applies
+		if( not m_get.step( ) ) {
+			return std::nullopt;
+		}
+		// sqlite3_column_blob must be called before sqlite3_column_bytes
+		auto const *first =
+		  static_cast<char const *>( sqlite3_column_blob( statement, 0 ) );
+		return std::string(
+		  first, static_cast<std::size_t>( sqlite3_column_bytes( statement, 0 ) ) );
+	}
+
+	void kv_store::store( daw::string_view key, daw::string_view value ) {
+		auto *statement = m_put.get( );
+		bind_bytes( statement, 1, key );
+		bind_bytes( statement, 2, value );
+		auto const reset = reset_on_exit( statement );
+		(void)m_put.step( );
+	}
+
+	std::optional<std::string> kv_store::get_encoded( daw::string_view key ) {
+		if( m_cache ) {
+			if( auto const *value = m_cache->find( to_key( key ) ) ) {
+				return *value;
+			}
+		}
+		auto result = fetch( key );
+		if( m_cache and result ) {
+			m_cache->insert_or_assign( to_key( key ), *result );
+		}
+		return result;
+	}
+
+	void kv_store::put_encoded( daw::string_view key, daw::string_view value ) {
+		store( key, value );
+		if( m_cache ) {
+			if( m_db.in_transaction( ) ) {
+				m_cache->erase( to_key( key ) );
+			} else {
+				m_cache->insert_or_assign( to_key( key ),
+				                           std::string_view( value.data( ), value.size( ) ) );
+			}
+		}
+	}
+
+	bool kv_store::erase_encoded( daw::string_view key ) {
+		{
+			auto *statement = m_erase.get( );
+			bind_bytes( statement, 1, key );
+			auto const reset = reset_on_exit( statement );
+			(void)m_erase.step( );
+		}
+		if( m_cache ) {
+			m_cache->erase( to_key( key ) );
+		}
+		return sqlite3_changes( m_db.get_handle( ) ) > 0;
+	}
+
+	std::vector<std::optional<std::string>>
+	kv_store::get_many_encoded( std::span<std::string const> keys ) {
+		auto result = std::vector<std::optional<std::string>>( );
+		result.reserve( keys.size( ) );
+		// One read transaction gives a consistent view and takes the shared lock
+		// once instead of per key
+		auto tx = std::optional<sqlite::transaction>( );
+		if( not m_db.in_transaction( ) ) {
+			tx.emplace( m_db );
+		}
+		for( auto const &key : keys ) {
+			result.push_back( get_encoded( key ) );
+		}
+		return result;
+	}
+
+	void kv_store::put_many_encoded(
+	  std::span<std::pair<std::string, std::string> const> pairs ) {
+		auto const owns_transaction = not m_db.in_transaction( );
+		{
+			auto tx = std::optional<sqlite::transaction>( );
+			if( owns_transaction ) {
+				tx.emplace( m_db, sqlite::transaction_mode::Immediate );
+			}
+			for( auto const &[key, value] : pairs ) {
+				store( key, value );
+			}
+			if( tx ) {
+				tx->commit( );
+			}
+		}
+		if( m_cache ) {
+			for( auto const &[key, value] : pairs ) {
+				if( owns_transaction ) {
+					m_cache->insert_or_assign( key, value );
+				} else {
+					m_cache->erase( key );
+				}
+			}
+		}
+	}
+
+	sqlite::database &kv_store::get_database( ) {
+		return m_db;
+	}
+
+	lru_cache_stats kv_store::cache_stats( ) const {
+		if( m_cache ) {
+			return m_cache->stats( );
+		}
+		return lru_cache_stats{ };
 	}
-}
\ No newline at end of file
+} // namespace daw::db
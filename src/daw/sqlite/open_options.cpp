@@ -0,0 +1,56 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/open_options.h"
+
+#include <chrono>
+#include <sqlite3.h>
+
+namespace daw::sqlite {
+	int open_options::flags( ) const {
+		int result = 0;
+		if( read_only ) {
+			result |= SQLITE_OPEN_READONLY;
+		} else {
+			result |= SQLITE_OPEN_READWRITE;
+			if( create ) {
+				result |= SQLITE_OPEN_CREATE;
+			}
+		}
+		if( no_mutex ) {
+			result |= SQLITE_OPEN_NOMUTEX;
+		}
+		if( shared_cache ) {
+			result |= SQLITE_OPEN_SHAREDCACHE;
+		}
+		if( uri ) {
+			result |= SQLITE_OPEN_URI;
+		}
+		return result;
+	}
+
+	open_options open_options::read_heavy( ) {
+		auto result = open_options{ };
+		result.journal = journal_mode::WAL;
+		result.synchronous = synchronous_mode::Normal;
+		result.mmap_size = 256LL * 1024LL * 1024LL;
+		result.cache_size = -64LL * 1024LL;
+		result.temp_store = temp_store_mode::Memory;
+		result.busy_timeout = std::chrono::seconds( 5 );
+		return result;
+	}
+
+	open_options open_options::bulk_load( ) {
+		auto result = open_options{ };
+		result.journal = journal_mode::WAL;
+		result.synchronous = synchronous_mode::Off;
+		result.cache_size = -256LL * 1024LL;
+		result.temp_store = temp_store_mode::Memory;
+		return result;
+	}
+} // namespace daw::sqlite
@@ -0,0 +1,239 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/parallel_scan.h"
+#include "daw/sqlite/connection_pool.h"
+#include "daw/sqlite/identifier.h"
+#include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/sqlite3_exception.h"
+#include "daw/sqlite/transaction.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sqlite3.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined( DAW_SQLITE_USE_SNAPSHOT ) or defined( SQLITE_ENABLE_SNAPSHOT )
+#define DAW_SQLITE_HAS_SNAPSHOT
+#endif
+
+namespace daw::sqlite {
+	namespace {
+		[[nodiscard]] std::string scan_sql( parallel_scan_options const &options ) {
+			auto result = "SELECT " + options.columns + " FROM " +
+			              sql_impl::quote_identifier( options.table ) + " WHERE " +
+			              sql_impl::quote_identifier( options.key_column ) +
+			              " BETWEEN ?1 AND ?2";
+			if( not options.where.empty( ) ) {
+				result += " AND (" + options.where + ")";
+			}
+			return result;
+		}
+
+		/***
+		 * @brief The range of keys to scan.  Also opens the read transaction of
+		 * the coordinating connection, so it must read the database even when the
+		 * range is given
+		 */
+		[[nodiscard]] std::optional<std::pair<std::int64_t, std::int64_t>>
+		key_range( database &db, parallel_scan_options const &options ) {
+			if( options.first_key and options.last_key ) {
+				auto statement = shared_prepared_statement(
+				  db, "SELECT 1 FROM sqlite_schema LIMIT 1" );
+				(void)statement.step( );
+				return std::pair( *options.first_key, *options.last_key );
+			}
+			auto const key = sql_impl::quote_identifier( options.key_column );
+			auto sql = "SELECT min(" + key + "), max(" + key + ") FROM " +
+			           sql_impl::quote_identifier( options.table );
+			if( not options.where.empty( ) ) {
+				sql += " WHERE " + options.where;
+			}
+			auto statement = shared_prepared_statement( db, sql );
+			if( not statement.step( ) or statement.is_column_null( 0 ) ) {
+				return std::nullopt;
+			}
+			return std::pair(
+			  options.first_key.value_or( statement.get_column_integer( 0 ) ),
+			  options.last_key.value_or( statement.get_column_integer( 1 ) ) );
+		}
+
+#if defined( DAW_SQLITE_HAS_SNAPSHOT )
+		struct snapshot_deleter {
+			void operator( )( sqlite3_snapshot *ptr ) const noexcept {
+				sqlite3_snapshot_free( ptr );
+			}
+		};
+		using snapshot_ptr = std::unique_ptr<sqlite3_snapshot, snapshot_deleter>;
+
+		[[nodiscard]] snapshot_ptr get_snapshot( database &db ) {
+			sqlite3_snapshot *result = nullptr;
+			auto const rc = sqlite3_snapshot_get( db.get_handle( ), "main", &result );
+			if( rc != SQLITE_OK ) {
+				throw sqlite3_exception( rc );
+			}
+			return snapshot_ptr( result );
+		}
+
+		void open_snapshot( database &db, snapshot_ptr const &snapshot ) {
+			auto const rc =
+			  sqlite3_snapshot_open( db.get_handle( ), "main", snapshot.get( ) );
+			if( rc != SQLITE_OK ) {
+				throw sqlite3_exception( rc );
+			}
+		}
+#else
+		struct snapshot_ptr {};
+
+		[[nodiscard]] snapshot_ptr get_snapshot( database & ) {
+			return { };
+		}
+
+		void open_snapshot( database &, snapshot_ptr const & ) {}
+#endif
+	} // namespace
+
+	bool parallel_scan_has_snapshots( ) {
+#if defined( DAW_SQLITE_HAS_SNAPSHOT )
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	std::vector<scan_partition>
+	make_partitions( std::int64_t first, std::int64_t last, std::size_t count ) {
+		auto result = std::vector<scan_partition>( );
+		if( last < first or count == 0 ) {
+			return result;
+		}
+		// Offsets from first are unsigned so that the whole int64 range fits
+		auto const width =
+		  static_cast<std::uint64_t>( last ) - static_cast<std::uint64_t>( first );
+		auto const step = width / count + 1U;
+		if( step == 0 ) {
+			// One partition covering every int64
+			result.push_back( scan_partition{ 0, first, last } );
+			return result;
+		}
+		result.reserve( count );
+		for( std::uint64_t offset = 0;; offset += step ) {
+			auto const end = offset + std::min( step - 1U, width - offset );
+			result.push_back( scan_partition{
+			  result.size( ),
+			  static_cast<std::int64_t>( static_cast<std::uint64_t>( first ) + offset ),
+			  static_cast<std::int64_t>( static_cast<std::uint64_t>( first ) + end ) } );
+			if( end == width ) {
+				break;
+			}
+		}
+		return result;
+	}
+
+	namespace scan_impl {
+		void run( connection_pool &pool, parallel_scan_options const &options,
+		          plan_fn const &on_plan, partition_fn const &on_partition ) {
+			if( options.table.empty( ) ) {
+				throw sqlite3_exception( "parallel_scan requires a table" );
+			}
+			if( options.require_snapshot and not parallel_scan_has_snapshots( ) ) {
+				throw sqlite3_exception(
+				  "parallel_scan requires sqlite built with SQLITE_ENABLE_SNAPSHOT" );
+			}
+			// The coordinating connection's read transaction pins the snapshot, a
+			// checkpoint cannot overwrite it until every thread has finished
+			auto coordinator = pool.acquire_reader( );
+			auto tx = transaction( *coordinator );
+			auto const range = key_range( *coordinator, options );
+			auto const snapshot = get_snapshot( *coordinator );
+
+			auto thread_count = std::min(
+			  options.thread_count == 0 ? pool.reader_count( ) : options.thread_count,
+			  pool.reader_count( ) );
+			auto const partitions =
+			  range ? make_partitions(
+			            range->first,
+			            range->second,
+			            options.partition_count == 0 ? thread_count * 4U
+			                                         : options.partition_count )
+			        : std::vector<scan_partition>( );
+			on_plan( partitions );
+			if( partitions.empty( ) ) {
+				return;
+			}
+			thread_count = std::min( thread_count, partitions.size( ) );
+
+			auto const sql = scan_sql( options );
+			auto next = std::atomic<std::size_t>( 0 );
+			auto stop = std::atomic<bool>( false );
+			auto error_mutex = std::mutex( );
+			auto error = std::exception_ptr( );
+			auto const record_error = [&] {
+				stop = true;
+				auto const lck = std::lock_guard( error_mutex );
+				if( not error ) {
+					error = std::current_exception( );
+				}
+			};
+			auto const scan = [&]( database &db ) {
+				auto statement = shared_prepared_statement( db, sql );
+				for( auto n = next++; n < partitions.size( ) and not stop;
+				     n = next++ ) {
+					auto const &partition = partitions[n];
+					statement.reset( );
+					statement.bind_parameters( partition.first, partition.last );
+					on_partition( partition, statement );
+				}
+				statement.reset( );
+			};
+
+			auto workers = std::vector<std::thread>( );
+			workers.reserve( thread_count - 1U );
+			for( std::size_t n = 1; n < thread_count; ++n ) {
+				workers.emplace_back( [&] {
+					try {
+						// Waiting for a reader held elsewhere could wait for this scan,
+						// without one the partitions are left to the other threads
+						auto lease = pool.try_acquire_reader( std::chrono::milliseconds( 0 ) );
+						if( not lease ) {
+							return;
+						}
+						auto worker_tx = transaction( **lease );
+						open_snapshot( **lease, snapshot );
+						scan( **lease );
+					} catch( ... ) {
+						record_error( );
+					}
+				} );
+			}
+			// The calling thread scans on the coordinating connection
+			try {
+				scan( *coordinator );
+			} catch( ... ) {
+				record_error( );
+			}
+			for( auto &worker : workers ) {
+				worker.join( );
+			}
+			if( error ) {
+				std::rethrow_exception( error );
+			}
+		}
+	} // namespace scan_impl
+} // namespace daw::sqlite
@@ -6,6 +6,8 @@
 // Official repository: https://github.com/beached/sqlite_helper
 //
 
+#include "daw/sqlite/bind_helpers.h"
+#include "daw/sqlite/busy_policy.h"
 #include "daw/sqlite/query_iterator.h"
 #include "daw/sqlite/sqlite3_class.h"
 
@@ -14,9 +16,13 @@
 
 #include <cstddef>
 #include <iostream>
+#include <limits>
 #include <sqlite3.h>
+#include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace daw::sqlite {
 	prepared_statement::prepared_statement( database &db, daw::string_view sql ) {
@@ -31,6 +37,7 @@ namespace daw::sqlite {
 			throw sqlite3_exception( rc );
 		}
 		m_statement.reset( st );
+		m_busy = db.m_busy;
 	}
 
 	sqlite3_stmt *prepared_statement::get( ) {
@@ -107,74 +114,125 @@ namespace daw::sqlite {
 
 	void prepared_statement::reset_to_default_init( ) {
 		m_statement.reset( );
+		m_owned_buffers.clear( );
+		m_busy.reset( );
 	}
 
 	namespace {
-		void delete_text_or_blob( void *val ) {
-			auto ptr = static_cast<char const *>(val);
-			delete[] ptr;
+		void check_bind( int rc ) {
+			if( rc != SQLITE_OK ) {
+				throw sqlite3_exception( rc );
+			}
 		}
-	} // namespace
 
-	void prepared_statement::bind( std::size_t index, cell_value const &value ) {
-		assert( index <= std::numeric_limits<int>::max( ) );
-		auto rc = SQLITE_ERROR;
-		switch(value.get_type( )) {
-		case column_type::Float:
-			rc = sqlite3_bind_double(
-				m_statement.get( ),
-				static_cast<int>(index),
-				value.get_float( ) );
-			break;
-		case column_type::Integer:
-			rc = sqlite3_bind_int64(
-				m_statement.get( ),
-				static_cast<int>(index),
-				value.get_integer( ) );
-			break;
-		case column_type::Text: {
-			auto const &val = value.get_text( );
-			auto *arry = new char[val.size( )]; // deleted by sqlite3_bind_text
-			// 5th parameter function
-			std::copy( std::data( val ), daw::data_end( val ), arry );
-			rc = sqlite3_bind_text( m_statement.get( ),
-			                        static_cast<int>(index),
-			                        arry,
-			                        val.size( ),
-			                        delete_text_or_blob );
+		[[nodiscard]] int to_index( std::size_t index ) {
+			assert( index <= static_cast<std::size_t>(
+				std::numeric_limits<int>::max( ) ) );
+			return static_cast<int>(index);
 		}
-		break;
-		case column_type::Blob: {
-			auto const &val = value.get_blob( );
-			auto *arry = new std::byte[val.size( )]; // deleted by sqlite3_bind_blob
-			// 5th parameter function
-			std::copy( val.begin( ), val.end( ), arry );
-			rc = sqlite3_bind_blob( m_statement.get( ),
-			                        static_cast<int>(index),
-			                        arry,
-			                        val.size( ),
-			                        delete_text_or_blob );
+
+		void bind_text( sqlite3_stmt *stmt, std::size_t index,
+		                types::text_t value, bind_lifetime lifetime ) {
+			check_bind( bind_impl::bind_text(
+			  stmt,
+			  to_index( index ),
+			  std::string_view( value.data( ), value.size( ) ),
+			  lifetime ) );
 		}
-		break;
-		case column_type::Null:
-			rc = sqlite3_bind_null( m_statement.get( ), static_cast<int>(index) );
-			break;
-		default:
-			std::cerr << "Unknown sqlite3 column type returned" << std::endl;
-			std::terminate( );
+
+		void bind_blob( sqlite3_stmt *stmt, std::size_t index,
+		                types::blob_t value, bind_lifetime lifetime ) {
+			check_bind( bind_impl::bind_blob(
+			  stmt,
+			  to_index( index ),
+			  std::span<std::byte const>( value.data( ), value.size( ) ),
+			  lifetime ) );
 		}
-		if(rc != SQLITE_OK) {
-			throw sqlite3_exception( rc );
+
+		void bind_cell( sqlite3_stmt *stmt, std::size_t index,
+		                cell_value const &value ) {
+			switch( value.get_type( ) ) {
+			case column_type::Float:
+				check_bind( sqlite3_bind_double( stmt,
+				                                 to_index( index ),
+				                                 value.get_float( ) ) );
+				break;
+			case column_type::Integer:
+				check_bind( sqlite3_bind_int64( stmt,
+				                                to_index( index ),
+				                                value.get_integer( ) ) );
+				break;
+			case column_type::Text:
+				bind_text( stmt, index, value.get_text( ), bind_lifetime::Transient );
+				break;
+			case column_type::Blob:
+				bind_blob( stmt, index, value.get_blob( ), bind_lifetime::Transient );
+				break;
+			case column_type::Null:
+				check_bind( sqlite3_bind_null( stmt, to_index( index ) ) );
+				break;
+			default:
+				std::cerr << "Unknown sqlite3 column type returned" << std::endl;
+				std::terminate( );
+			}
+		}
+
+		// The buffer is stored before binding so that the pointer handed to
+		// sqlite is the one that lives in the map node
+		void bind_owned( sqlite3_stmt *stmt, ps_impl::owned_buffers_t &owned,
+		                 std::size_t index, std::string &&value ) {
+			auto &buff = owned[index].emplace<std::string>( std::move( value ) );
+			bind_text( stmt, index, types::text_t( buff ), bind_lifetime::Static );
+		}
+
+		void bind_owned( sqlite3_stmt *stmt, ps_impl::owned_buffers_t &owned,
+		                 std::size_t index, std::vector<std::byte> &&value ) {
+			auto &buff =
+				owned[index].emplace<std::vector<std::byte>>( std::move( value ) );
+			bind_blob( stmt,
+			           index,
+			           types::blob_t( buff.data( ), buff.size( ) ),
+			           bind_lifetime::Static );
 		}
+	} // namespace
+
+	void prepared_statement::bind( std::size_t index, cell_value const &value ) {
+		bind_cell( m_statement.get( ), index, value );
+	}
+
+	void prepared_statement::bind( std::size_t index ) {
+		check_bind( sqlite3_bind_null( m_statement.get( ), to_index( index ) ) );
+	}
+
+	void prepared_statement::bind( std::size_t index, types::text_t value,
+	                               bind_lifetime lifetime ) {
+		bind_text( m_statement.get( ), index, value, lifetime );
+	}
+
+	void prepared_statement::bind( std::size_t index, types::blob_t value,
+	                               bind_lifetime lifetime ) {
+		bind_blob( m_statement.get( ), index, value, lifetime );
 	}
 
-	void prepared_statement::bind( std::size_t index ) {}
+	void prepared_statement::bind( std::size_t index, std::string &&value ) {
+		bind_owned( m_statement.get( ), m_owned_buffers, index, std::move( value ) );
+	}
+
+	void prepared_statement::bind( std::size_t index,
+	                               std::vector<std::byte> &&value ) {
+		bind_owned( m_statement.get( ), m_owned_buffers, index, std::move( value ) );
+	}
+
+	void prepared_statement::bind( std::size_t index, zeroblob value ) {
+		check_bind( sqlite3_bind_zeroblob64( m_statement.get( ), to_index( index ),
+		                                     value.size ) );
+	}
 
 	column_type prepared_statement::get_column_type( std::size_t column ) {
 		validate( *this, column );
 
 		switch(
-			sqlite3_column_type( m_statement.get( ), static_cast<int>(column) )) {
+			sqlite3_column_type( get( ), static_cast<int>(column) )) {
 		case SQLITE_INTEGER:
 			return column_type::Integer;
 		case SQLITE_FLOAT:
@@ -203,16 +261,24 @@ namespace daw::sqlite {
 		if(rc != SQLITE_OK) {
 			throw sqlite3_exception( rc );
 		}
-		m_statement.reset( st, ps_impl::sqlite3_stmt_deleter{} );
+		m_state = std::make_shared<ps_impl::shared_statement_state>( );
+		m_state->statement.reset( st );
+		m_state->busy = db.m_busy;
 	}
 
 	shared_prepared_statement::shared_prepared_statement(
 		prepared_statement statement )
-		: m_statement( statement.m_statement.release( ),
-		               ps_impl::sqlite3_stmt_deleter{} ) {}
+		: m_state( std::make_shared<ps_impl::shared_statement_state>( ) ) {
+		m_state->owned_buffers = std::move( statement.m_owned_buffers );
+		m_state->statement = std::move( statement.m_statement );
+		m_state->busy = std::move( statement.m_busy );
+	}
 
 	sqlite3_stmt *shared_prepared_statement::get( ) {
-		return m_statement.get( );
+		if( not m_state ) {
+			return nullptr;
+		}
+		return m_state->statement.get( );
 	}
 
 	std::size_t shared_prepared_statement::get_column_count( ) {
@@ -277,80 +343,97 @@ namespace daw::sqlite {
 	}
 
 	bool shared_prepared_statement::is_good( ) const {
-		return nullptr != m_statement;
+		return static_cast<bool>( *this );
 	}
 
 	void shared_prepared_statement::reset( ) {
-		auto rc = sqlite3_reset( m_statement.get( ) );
+		auto rc = sqlite3_reset( get( ) );
 		if(rc != SQLITE_OK) {
 			throw sqlite3_exception( rc );
 		}
 	}
 
 	void shared_prepared_statement::reset_to_default_init( ) {
-		m_statement.reset( );
+		m_state.reset( );
 	}
 
 	void shared_prepared_statement::bind( std::size_t index,
 	                                      cell_value const &value ) {
-		assert( index <= std::numeric_limits<int>::max( ) );
-		auto rc = SQLITE_ERROR;
-		switch(value.get_type( )) {
-		case column_type::Float:
-			rc = sqlite3_bind_double(
-				m_statement.get( ),
-				static_cast<int>(index),
-				value.get_float( ) );
-			break;
-		case column_type::Integer:
-			rc = sqlite3_bind_int64(
-				m_statement.get( ),
-				static_cast<int>(index),
-				value.get_integer( ) );
-			break;
-		case column_type::Text: {
-			auto const &val = value.get_text( );
-			auto *arry = new char[val.size( )]; // deleted by sqlite3_bind_text
-			// 5th parameter function
-			std::copy( std::data( val ), daw::data_end( val ), arry );
-			rc = sqlite3_bind_text( m_statement.get( ),
-			                        static_cast<int>(index),
-			                        arry,
-			                        val.size( ),
-			                        delete_text_or_blob );
-		}
-		break;
-		case column_type::Blob: {
-			auto const &val = value.get_blob( );
-			auto *arry = new std::byte[val.size( )]; // deleted by sqlite3_bind_blob
-			// 5th parameter function
-			std::copy( val.begin( ), val.end( ), arry );
-			rc = sqlite3_bind_blob( m_statement.get( ),
-			                        static_cast<int>(index),
-			                        arry,
-			                        val.size( ),
-			                        delete_text_or_blob );
-		}
-		break;
-		case column_type::Null:
-			rc = sqlite3_bind_null( m_statement.get( ), static_cast<int>(index) );
-			break;
-		default:
-			std::cerr << "Unknown sqlite3 column type returned" << std::endl;
-			std::terminate( );
+		bind_cell( get( ), index, value );
+	}
+
+	void shared_prepared_statement::bind( std::size_t index ) {
+		check_bind( sqlite3_bind_null( get( ), to_index( index ) ) );
+	}
+
+	void shared_prepared_statement::bind( std::size_t index,
+	                                      types::text_t value,
+	                                      bind_lifetime lifetime ) {
+		bind_text( get( ), index, value, lifetime );
+	}
+
+	void shared_prepared_statement::bind( std::size_t index,
+	                                      types::blob_t value,
+	                                      bind_lifetime lifetime ) {
+		bind_blob( get( ), index, value, lifetime );
+	}
+
+	void shared_prepared_statement::bind( std::size_t index,
+	                                      std::string &&value ) {
+		bind_owned( get( ), m_state->owned_buffers, index, std::move( value ) );
+	}
+
+	void shared_prepared_statement::bind( std::size_t index,
+	                                      std::vector<std::byte> &&value ) {
+		bind_owned( get( ), m_state->owned_buffers, index, std::move( value ) );
+	}
+
+	void shared_prepared_statement::bind( std::size_t index, zeroblob value ) {
+		check_bind( sqlite3_bind_zeroblob64( get( ), to_index( index ), value.size ) );
+	}
+
+	void shared_prepared_statement::clear_bindings( ) {
+		(void)sqlite3_clear_bindings( get( ) );
+		m_state->owned_buffers.clear( );
+	}
+
+	bool shared_prepared_statement::step( ) {
+		auto const rc = busy_impl::step( get( ), m_state->busy.get( ) );
+		if( rc == SQLITE_ROW ) {
+			return true;
 		}
-		if(rc != SQLITE_OK) {
+		if( rc != SQLITE_DONE ) {
 			throw sqlite3_exception( rc );
 		}
+		return false;
 	}
 
-	void shared_prepared_statement::bind( std::size_t index ) {}
+	long shared_prepared_statement::use_count( ) const {
+		return m_state.use_count( );
+	}
+
+	shared_prepared_statement shared_prepared_statement::lease( ) const {
+		auto result = shared_prepared_statement( );
+		if( not m_state ) {
+			return result;
+		}
+		// The deleter keeps the statement alive, releasing the handle only
+		// returns it to its owner in a reset state
+		result.m_state = std::shared_ptr<ps_impl::shared_statement_state>(
+		  m_state.get( ),
+		  [owner = m_state]( ps_impl::shared_statement_state *state ) noexcept {
+			  (void)sqlite3_reset( state->statement.get( ) );
+			  (void)sqlite3_clear_bindings( state->statement.get( ) );
+			  state->owned_buffers.clear( );
+		  } );
+		return result;
+	}
 
 	column_type shared_prepared_statement::get_column_type( std::size_t column ) {
 		validate( *this, column );
 
 		switch(
-			sqlite3_column_type( m_statement.get( ), static_cast<int>(column) )) {
+			sqlite3_column_type( get( ), static_cast<int>(column) )) {
 		case SQLITE_INTEGER:
 			return column_type::Integer;
 		case SQLITE_FLOAT:
@@ -0,0 +1,370 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sqlite3.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace daw::sqlite {
+	namespace {
+		constexpr std::size_t linear_buckets = latency_histogram::sub_buckets * 2;
+		constexpr int sub_bucket_bits = 3;
+		static_assert( ( 1U << sub_bucket_bits ) == latency_histogram::sub_buckets );
+
+		// Values below 16ns get a bucket each, above that each power of two is
+		// split into sub_buckets
+		[[nodiscard]] std::size_t bucket_of( std::uint64_t value ) {
+			if( value < linear_buckets ) {
+				return static_cast<std::size_t>( value );
+			}
+			auto const exponent = std::bit_width( value ) - 1;
+			auto const sub =
+			  ( value >> ( exponent - sub_bucket_bits ) ) & ( latency_histogram::sub_buckets - 1 );
+			return linear_buckets +
+			       static_cast<std::size_t>( exponent - 4 ) * latency_histogram::sub_buckets +
+			       static_cast<std::size_t>( sub );
+		}
+
+		[[nodiscard]] std::uint64_t bucket_upper_bound( std::size_t bucket ) {
+			if( bucket < linear_buckets ) {
+				return bucket;
+			}
+			auto const exponent = static_cast<int>(
+			  ( bucket - linear_buckets ) / latency_histogram::sub_buckets + 4 );
+			auto const sub = ( bucket - linear_buckets ) % latency_histogram::sub_buckets;
+			auto const width = std::uint64_t{ 1 } << ( exponent - sub_bucket_bits );
+			return ( std::uint64_t{ 1 } << exponent ) + ( sub + 1 ) * width - 1;
+		}
+
+		[[nodiscard]] bool is_identifier_char( char c ) {
+			return ( c >= 'a' and c <= 'z' ) or ( c >= 'A' and c <= 'Z' ) or
+			       ( c >= '0' and c <= '9' ) or c == '_' or c == '$' or
+			       static_cast<unsigned char>( c ) >= 0x80;
+		}
+
+		[[nodiscard]] bool is_space( char c ) {
+			return c == ' ' or c == '\t' or c == '\n' or c == '\r' or c == '\f' or
+			       c == '\v';
+		}
+
+		[[nodiscard]] bool is_digit( char c ) {
+			return c >= '0' and c <= '9';
+		}
+
+		// Skip a quoted string, literal or identifier, starting at the opening
+		// quote.  A doubled quote is an escaped one
+		[[nodiscard]] std::size_t skip_quoted( std::string_view sql, std::size_t pos,
+		                                       char quote ) {
+			++pos;
+			while( pos < sql.size( ) ) {
+				if( sql[pos] == quote ) {
+					if( pos + 1 < sql.size( ) and sql[pos + 1] == quote ) {
+						pos += 2;
+						continue;
+					}
+					return pos + 1;
+				}
+				++pos;
+			}
+			return pos;
+		}
+
+		constexpr std::string_view other_statements = "<other>";
+		// Statements remembered before they are all forgotten, the entries of
+		// finalized statements are never removed otherwise
+		constexpr std::size_t max_tracked_statements = 4096;
+	} // namespace
+
+	void latency_histogram::record( std::chrono::nanoseconds latency ) {
+		auto const value =
+		  static_cast<std::uint64_t>( std::max<std::int64_t>( latency.count( ), 0 ) );
+		++m_buckets[std::min( bucket_of( value ), bucket_count - 1 )];
+		++m_count;
+		m_total += latency;
+		m_max = std::max( m_max, latency );
+	}
+
+	std::uint64_t latency_histogram::count( ) const {
+		return m_count;
+	}
+
+	std::chrono::nanoseconds latency_histogram::total( ) const {
+		return m_total;
+	}
+
+	std::chrono::nanoseconds latency_histogram::max( ) const {
+		return m_max;
+	}
+
+	std::chrono::nanoseconds latency_histogram::percentile( double q ) const {
+		if( m_count == 0 ) {
+			return std::chrono::nanoseconds( 0 );
+		}
+		auto const rank = std::max<std::uint64_t>(
+		  1, static_cast<std::uint64_t>(
+		       std::ceil( std::clamp( q, 0.0, 1.0 ) * static_cast<double>( m_count ) ) ) );
+		auto seen = std::uint64_t{ 0 };
+		for( std::size_t bucket = 0; bucket < bucket_count; ++bucket ) {
+			seen += m_buckets[bucket];
+			if( seen >= rank ) {
+				return std::min(
+				  m_max, std::chrono::nanoseconds(
+				           static_cast<std::int64_t>( bucket_upper_bound( bucket ) ) ) );
+			}
+		}
+		return m_max;
+	}
+
+	void latency_histogram::merge( latency_histogram const &other ) {
+		for( std::size_t bucket = 0; bucket < bucket_count; ++bucket ) {
+			m_buckets[bucket] += other.m_buckets[bucket];
+		}
+		m_count += other.m_count;
+		m_total += other.m_total;
+		m_max = std::max( m_max, other.m_max );
+	}
+
+	std::chrono::nanoseconds statement_profile::p50( ) const {
+		return latency.percentile( 0.5 );
+	}
+
+	std::chrono::nanoseconds statement_profile::p99( ) const {
+		return latency.percentile( 0.99 );
+	}
+
+	std::chrono::nanoseconds statement_profile::max( ) const {
+		return latency.max( );
+	}
+
+	std::string normalize_sql( std::string_view sql ) {
+		auto result = std::string( );
+		result.reserve( sql.size( ) );
+		auto pending_space = false;
+		auto const append = [&]( std::string_view part ) {
+			if( pending_space and not result.empty( ) ) {
+				result.push_back( ' ' );
+			}
+			pending_space = false;
+			result.append( part );
+		};
+		std::size_t pos = 0;
+		while( pos < sql.size( ) ) {
+			auto const c = sql[pos];
+			if( is_space( c ) ) {
+				pending_space = true;
+				++pos;
+			} else if( c == '-' and pos + 1 < sql.size( ) and sql[pos + 1] == '-' ) {
+				pos = std::min( sql.find( '\n', pos ), sql.size( ) );
+				pending_space = true;
+			} else if( c == '/' and pos + 1 < sql.size( ) and sql[pos + 1] == '*' ) {
+				auto const end = sql.find( "*/", pos + 2 );
+				pos = end == std::string_view::npos ? sql.size( ) : end + 2;
+				pending_space = true;
+			} else if( c == '\'' ) {
+				pos = skip_quoted( sql, pos, '\'' );
+				append( "?" );
+			} else if( ( c == 'x' or c == 'X' ) and pos + 1 < sql.size( ) and
+			           sql[pos + 1] == '\'' and
+			           ( pos == 0 or not is_identifier_char( sql[pos - 1] ) ) ) {
+				// Blob literal
+				pos = skip_quoted( sql, pos + 1, '\'' );
+				append( "?" );
+			} else if( c == '"' or c == '`' or c == '[' ) {
+				auto const end = c == '[' ? std::min( sql.find( ']', pos ), sql.size( ) - 1 ) + 1
+				                          : skip_quoted( sql, pos, c );
+				append( sql.substr( pos, end - pos ) );
+				pos = end;
+			} else if( is_digit( c ) or
+			           ( c == '.' and pos + 1 < sql.size( ) and is_digit( sql[pos + 1] ) ) ) {
+				// Numeric literal, including hex, exponents and a fraction
+				while( pos < sql.size( ) and
+				       ( is_identifier_char( sql[pos] ) or sql[pos] == '.' or
+				         ( ( sql[pos] == '+' or sql[pos] == '-' ) and
+				           ( sql[pos - 1] == 'e' or sql[pos - 1] == 'E' ) ) ) ) {
+					++pos;
+				}
+				append( "?" );
+			} else if( is_identifier_char( c ) ) {
+				auto const first = pos;
+				while( pos < sql.size( ) and is_identifier_char( sql[pos] ) ) {
+					++pos;
+				}
+				append( sql.substr( first, pos - first ) );
+			} else if( c == '?' ) {
+				// ?NNN is the same placeholder as ?
+				++pos;
+				while( pos < sql.size( ) and is_digit( sql[pos] ) ) {
+					++pos;
+				}
+				append( "?" );
+			} else {
+				append( sql.substr( pos, 1 ) );
+				++pos;
+			}
+		}
+		return result;
+	}
+
+	namespace profile_impl {
+		profiler::profiler( profiler_options const &options )
+		  : m_options( options ) {}
+
+		profiler_options const &profiler::options( ) const {
+			return m_options;
+		}
+
+		unsigned profiler::trace_mask( ) const {
+			// The profile event's own time only has millisecond resolution on most
+			// platforms, so the start of each statement is traced too
+			auto mask = static_cast<unsigned>( SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE );
+			if( m_options.count_rows ) {
+				mask |= static_cast<unsigned>( SQLITE_TRACE_ROW );
+			}
+			return mask;
+		}
+
+		int profiler::trace( unsigned type, void *context, void *p, void *x ) {
+			auto &self = *static_cast<profiler *>( context );
+			auto *statement = static_cast<sqlite3_stmt *>( p );
+			try {
+				if( type == SQLITE_TRACE_STMT ) {
+					self.on_start( statement );
+				} else if( type == SQLITE_TRACE_ROW ) {
+					self.on_row( statement );
+				} else if( type == SQLITE_TRACE_PROFILE ) {
+					self.on_profile( statement, *static_cast<sqlite3_int64 *>( x ) );
+				}
+			} catch( ... ) {
+				// Profiling is best effort, it must not fail the statement
+			}
+			return 0;
+		}
+
+		profiler::statement_t &profiler::entry( sqlite3_stmt *statement ) {
+			if( auto pos = m_statements.find( statement ); pos != m_statements.end( ) ) {
+				return pos->second;
+			}
+			if( m_statements.size( ) >= max_tracked_statements ) {
+				// A statement still running falls back to sqlite's own timing
+				m_statements.clear( );
+				m_row_statement = nullptr;
+				m_row_entry = nullptr;
+			}
+			return m_statements[statement];
+		}
+
+		void profiler::on_start( sqlite3_stmt *statement ) {
+			auto &s = entry( statement );
+			// Also traced for each trigger the statement fires, keep the first
+			if( not s.is_running ) {
+				s.is_running = true;
+				s.start = std::chrono::steady_clock::now( );
+				s.rows = 0;
+			}
+		}
+
+		void profiler::on_row( sqlite3_stmt *statement ) {
+			if( statement != m_row_statement ) {
+				m_row_entry = &entry( statement );
+				m_row_statement = statement;
+			}
+			++m_row_entry->rows;
+		}
+
+		void profiler::on_profile( sqlite3_stmt *statement,
+		                           std::int64_t nanoseconds ) {
+			auto &s = entry( statement );
+			auto latency = std::chrono::nanoseconds( nanoseconds );
+			if( s.is_running ) {
+				latency = std::chrono::steady_clock::now( ) - s.start;
+			}
+			auto const rows = std::exchange( s.rows, 0 );
+			s.is_running = false;
+			auto counters = std::array<std::uint64_t, 4>{ };
+			if( m_options.statement_status ) {
+				// Reset so the next call of this statement only sees its own work
+				auto const status = [&]( int op ) {
+					return static_cast<std::uint64_t>( sqlite3_stmt_status( statement, op, 1 ) );
+				};
+				counters = { status( SQLITE_STMTSTATUS_FULLSCAN_STEP ),
+				             status( SQLITE_STMTSTATUS_SORT ),
+				             status( SQLITE_STMTSTATUS_AUTOINDEX ),
+				             status( SQLITE_STMTSTATUS_VM_STEP ) };
+			}
+			auto const *sql_text = sqlite3_sql( statement );
+			auto const sql =
+			  sql_text == nullptr ? std::string_view( ) : std::string_view( sql_text );
+			if( not s.has_key or s.sql != sql ) {
+				s.sql = sql;
+				s.key = normalize_sql( sql );
+				s.has_key = true;
+				s.profile = nullptr;
+			}
+
+			auto const lck = std::lock_guard( m_mutex );
+			if( s.profile == nullptr or s.generation != m_generation ) {
+				auto key = std::string_view( s.key );
+				auto pos = m_profiles.find( s.key );
+				if( pos == m_profiles.end( ) and
+				    m_profiles.size( ) >= m_options.max_statements ) {
+					key = other_statements;
+					pos = m_profiles.find( std::string( key ) );
+				}
+				if( pos == m_profiles.end( ) ) {
+					pos = m_profiles.emplace( key, statement_profile{ } ).first;
+					pos->second.sql = key;
+				}
+				// Nodes are stable, the pointer stays valid until reset
+				s.profile = &pos->second;
+				s.generation = m_generation;
+			}
+			auto &profile = *s.profile;
+			++profile.calls;
+			profile.rows += rows;
+			profile.latency.record( latency );
+			profile.fullscan_steps += counters[0];
+			profile.sorts += counters[1];
+			profile.autoindexes += counters[2];
+			profile.vm_steps += counters[3];
+		}
+
+		std::vector<statement_profile> profiler::snapshot( ) const {
+			auto result = std::vector<statement_profile>( );
+			{
+				auto const lck = std::lock_guard( m_mutex );
+				result.reserve( m_profiles.size( ) );
+				for( auto const &[sql, profile] : m_profiles ) {
+					result.push_back( profile );
+				}
+			}
+			std::sort( result.begin( ), result.end( ),
+			           []( statement_profile const &lhs, statement_profile const &rhs ) {
+				           return lhs.latency.total( ) > rhs.latency.total( );
+			           } );
+			return result;
+		}
+
+		void profiler::reset( ) {
+			auto const lck = std::lock_guard( m_mutex );
+			m_profiles.clear( );
+			++m_generation;
+		}
+	} // namespace profile_impl
+} // namespace daw::sqlite
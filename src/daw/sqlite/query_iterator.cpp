@@ -7,24 +7,62 @@
 //
 
 #include "daw/sqlite/query_iterator.h"
+#include "daw/sqlite/column_batch.h"
 #include "daw/sqlite/result_row.h"
 #include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/result_set.h"
 #include "daw/sqlite/sqlite3_exception.h"
 
+#include <daw/daw_ensure.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
 #include <sqlite3.h>
+#include <string>
+#include <vector>
 
 namespace daw::sqlite {
+	namespace ps_impl {
+		struct row_buffer {
+			std::size_t first_row = 0;
+			std::size_t row_count = 0;
+			std::size_t column_count = 0;
+			// Row major.  Text and blob cells view into bytes
+			std::vector<cell_value> cells{ };
+			std::vector<std::byte> bytes{ };
+		};
+	} // namespace ps_impl
+
+	std::shared_ptr<column_metadata const> const &query_iterator::metadata( ) {
+		if( not m_metadata ) {
+			m_metadata = std::make_shared<column_metadata const>( m_cursor );
+		}
+		return m_metadata;
+	}
+
 	query_iterator::const_reference query_iterator::front( ) {
+		if( not m_last_value and m_buffer ) {
+			daw_ensure( m_row != static_cast<std::size_t>( -1 ) );
+			auto const *row =
+			  m_buffer->cells.data( ) +
+			  ( m_row - m_buffer->first_row ) * m_buffer->column_count;
+			m_last_value = result_row_t(
+			  metadata( ),
+			  daw::do_resize_and_overwrite,
+			  [&]( cell_value *ptr, std::size_t sz ) {
+				  std::uninitialized_copy_n( row, sz, ptr );
+				  return sz;
+			  } );
+		}
 		if(not m_last_value) {
-			auto const column_count = m_statement.get_column_count( );
 			m_last_value = result_row_t(
+				metadata( ),
 				daw::do_resize_and_overwrite,
-				column_count,
-				[&]( auto *ptr, std::size_t sz ) {
-					for(size_t column = 0; column != column_count; ++column) {
-						std::construct_at( ptr + column,
-						                   m_statement.get_column_name( column ),
-						                   cell_value( m_statement, column ) );
+				[&]( cell_value *ptr, std::size_t sz ) {
+					for(size_t column = 0; column != sz; ++column) {
+						std::construct_at( ptr + column, m_cursor, column );
 					}
 					return sz;
 				} );
@@ -34,14 +72,213 @@ namespace daw::sqlite {
 
 	query_iterator::iterator_type &query_iterator::operator++( ) {
 		m_last_value.reset( );
-		int rc = sqlite3_step( m_statement.get( ) );
-		if(rc == SQLITE_DONE) {
-			m_row = static_cast<std::size_t>(-1);
-		} else if(rc != SQLITE_DONE and rc != SQLITE_ROW) {
-			throw sqlite3_exception( rc );
-		} else {
+		if( m_buffer ) {
+			if( m_row != static_cast<std::size_t>( -1 ) and
+			    ++m_row - m_buffer->first_row == m_buffer->row_count ) {
+				m_row = static_cast<std::size_t>( -1 );
+			}
+			return *this;
+		}
+		if( m_statement.step( ) ) {
 			++m_row;
+		} else {
+			m_row = static_cast<std::size_t>(-1);
 		}
 		return *this;
 	}
-} // namespace daw::sqlite
\ No newline at end of file
+
+	namespace {
+		struct pending_cell {
+			std::size_t cell;
+			std::size_t offset;
+			std::size_t size;
+			column_type type;
+		};
+
+		/***
+		 * @brief Copy the current row and every row after it into cells.  The
+		 * bytes of text and blob values are appended to bytes, which can
+		 * reallocate while rows are added, so their cells are left null and
+		 * recorded in pending for point_cells
+		 * @return The number of rows copied
+		 */
+		std::size_t copy_remaining_rows( shared_prepared_statement &statement,
+		                                 row_cursor const &cursor,
+		                                 std::vector<cell_value> &cells,
+		                                 std::vector<std::byte> &bytes,
+		                                 std::vector<pending_cell> &pending ) {
+			auto const column_count = cursor.get_column_count( );
+			auto const copy_bytes = [&]( void const *data, std::size_t size,
+			                             column_type type ) {
+				auto const *first = static_cast<std::byte const *>( data );
+				pending.push_back(
+				  pending_cell{ cells.size( ), bytes.size( ), size, type } );
+				bytes.insert( bytes.end( ), first, first + size );
+				cells.emplace_back( );
+			};
+			auto row_count = std::size_t{ 0 };
+			do {
+				for( std::size_t column = 0; column != column_count; ++column ) {
+					switch( auto const type = cursor.get_column_type( column ) ) {
+					case column_type::Text: {
+						auto const text = cursor.get_column_text( column );
+						copy_bytes( text.data( ), text.size( ), type );
+						break;
+					}
+					case column_type::Blob: {
+						auto const blob = cursor.get_column_blob( column );
+						copy_bytes( blob.data( ), blob.size( ), type );
+						break;
+					}
+					default:
+						cells.emplace_back( cursor, column );
+						break;
+					}
+				}
+				++row_count;
+			} while( statement.step( ) );
+			// Every row has been read, release the statement's read lock
+			statement.reset( );
+			return row_count;
+		}
+
+		void point_cells( std::vector<cell_value> &cells,
+		                  std::vector<std::byte> const &bytes,
+		                  std::vector<pending_cell> const &pending ) {
+			for( auto const &cell : pending ) {
+				auto const *data = bytes.data( ) + cell.offset;
+				if( cell.type == column_type::Text ) {
+					cells[cell.cell] = cell_value(
+					  types::text_t( reinterpret_cast<char const *>( data ), cell.size ) );
+				} else {
+					cells[cell.cell] = cell_value( types::blob_t( data, cell.size ) );
+				}
+			}
+		}
+	} // namespace
+
+	void query_iterator::buffer_remaining_rows( ) {
+		auto buffer = std::make_shared<ps_impl::row_buffer>( );
+		buffer->first_row = m_row;
+		buffer->column_count = m_cursor.get_column_count( );
+		(void)metadata( );
+		auto pending = std::vector<pending_cell>( );
+		try {
+			buffer->row_count = copy_remaining_rows(
+			  m_statement, m_cursor, buffer->cells, buffer->bytes, pending );
+		} catch( ... ) {
+			m_last_value.reset( );
+			m_row = static_cast<std::size_t>( -1 );
+			throw;
+		}
+		point_cells( buffer->cells, buffer->bytes, pending );
+		// The cached row views memory owned by the statement
+		m_last_value.reset( );
+		m_buffer = std::move( buffer );
+	}
+
+	std::size_t query_iterator::count( ) {
+		if( m_row == static_cast<std::size_t>( -1 ) ) {
+			return 0;
+		}
+		if( not m_buffer ) {
+			buffer_remaining_rows( );
+		}
+		return m_buffer->row_count - ( m_row - m_buffer->first_row );
+	}
+
+	void query_iterator::reset( ) {
+		m_last_value.reset( );
+		if( m_buffer and m_buffer->first_row == 0 ) {
+			m_row = 0;
+			return;
+		}
+		m_buffer.reset( );
+		if( m_statement ) {
+			m_statement.reset( );
+			m_row = static_cast<std::size_t>( -1 );
+			operator++( );
+		}
+	}
+
+	std::size_t query_iterator::fetch_batch( column_batch &batch,
+	                                         std::size_t max_rows ) {
+		auto const &names = *metadata( );
+		batch.reset_columns( names.size( ) );
+		for( std::size_t column = 0; column != names.size( ); ++column ) {
+			batch.set_column_name( column, names.name( column ) );
+		}
+		try {
+			while( batch.size( ) < max_rows and
+			       m_row != static_cast<std::size_t>( -1 ) ) {
+				if( m_buffer ) {
+					batch.append_row(
+					  m_buffer->cells.data( ) +
+					  ( m_row - m_buffer->first_row ) * m_buffer->column_count );
+				} else {
+					batch.append_row( m_cursor );
+				}
+				operator++( );
+			}
+		} catch( ... ) {
+			batch.clear( );
+			throw;
+		}
+		return batch.size( );
+	}
+
+	column_batch query_iterator::fetch_batch( std::size_t max_rows ) {
+		auto result = column_batch( );
+		(void)fetch_batch( result, max_rows );
+		return result;
+	}
+
+	result_set query_iterator::fetch_all( ) {
+		auto const &names = metadata( );
+		if( m_row == static_cast<std::size_t>( -1 ) ) {
+			return result_set( names, 0, { }, { } );
+		}
+		m_last_value.reset( );
+		if( m_buffer ) {
+			auto const column_count = m_buffer->column_count;
+			auto const first_row = m_row - m_buffer->first_row;
+			auto const row_count = m_buffer->row_count - first_row;
+			auto const cells = std::span<cell_value const>( m_buffer->cells )
+			                     .subspan( first_row * column_count );
+			// Bytes are appended in row order, earlier rows' bytes are not needed
+			auto bytes = std::span<std::byte const>( m_buffer->bytes );
+			auto const first_bytes = std::find_if(
+			  cells.begin( ), cells.end( ), []( cell_value const &cell ) {
+				  auto const type = cell.get_type( );
+				  return type == column_type::Text or type == column_type::Blob;
+			  } );
+			if( first_bytes != cells.end( ) ) {
+				auto const *data =
+				  first_bytes->get_type( ) == column_type::Text
+				    ? reinterpret_cast<std::byte const *>( first_bytes->get_text( ).data( ) )
+				    : first_bytes->get_blob( ).data( );
+				bytes = bytes.subspan(
+				  static_cast<std::size_t>( data - m_buffer->bytes.data( ) ) );
+			} else {
+				bytes = { };
+			}
+			auto result = result_set( names, row_count, cells, bytes );
+			m_row = static_cast<std::size_t>( -1 );
+			return result;
+		}
+		auto cells = std::vector<cell_value>( );
+		auto bytes = std::vector<std::byte>( );
+		auto pending = std::vector<pending_cell>( );
+		auto row_count = std::size_t{ 0 };
+		try {
+			row_count =
+			  copy_remaining_rows( m_statement, m_cursor, cells, bytes, pending );
+		} catch( ... ) {
+			m_row = static_cast<std::size_t>( -1 );
+			throw;
+		}
+		m_row = static_cast<std::size_t>( -1 );
+		point_cells( cells, bytes, pending );
+		return result_set( names, row_count, cells, bytes );
+	}
+} // namespace daw::sqlite
@@ -0,0 +1,205 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/result_set.h"
+#include "daw/sqlite/cell_value.h"
+
+#include <daw/daw_ensure.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace daw::sqlite {
+	namespace result_set_impl {
+		void block_deleter::operator( )( std::byte *ptr ) const noexcept {
+			delete[] ptr;
+		}
+	} // namespace result_set_impl
+
+	namespace {
+		[[nodiscard]] int compare_bytes( void const *lhs, std::size_t lhs_size,
+		                                 void const *rhs, std::size_t rhs_size ) {
+			auto const common = std::min( lhs_size, rhs_size );
+			if( common > 0 ) {
+				if( auto const rc = std::memcmp( lhs, rhs, common ); rc != 0 ) {
+					return rc;
+				}
+			}
+			return lhs_size < rhs_size ? -1 : ( lhs_size > rhs_size ? 1 : 0 );
+		}
+
+		// The storage class order sqlite uses when comparing values
+		[[nodiscard]] int type_rank( column_type type ) {
+			switch( type ) {
+			case column_type::Null:
+				return 0;
+			case column_type::Integer:
+			case column_type::Float:
+				return 1;
+			case column_type::Text:
+				return 2;
+			case column_type::Blob:
+				return 3;
+			}
+			return 0;
+		}
+
+		template<typename T>
+		[[nodiscard]] int compare_numbers( T lhs, T rhs ) {
+			return lhs < rhs ? -1 : ( rhs < lhs ? 1 : 0 );
+		}
+
+		// Exact, converting either side would round integers above 2^53 or
+		// overflow for doubles outside of the int64 range.  Like sqlite, NaN is
+		// treated as a null
+		[[nodiscard]] int compare_integer_float( std::int64_t lhs, double rhs ) {
+			if( std::isnan( rhs ) ) {
+				return 1;
+			}
+			if( rhs < -9223372036854775808.0 ) {
+				return 1;
+			}
+			if( rhs >= 9223372036854775808.0 ) {
+				return -1;
+			}
+			// In range, so the integer part is exact
+			auto const whole = static_cast<std::int64_t>( rhs );
+			if( auto const rc = compare_numbers( lhs, whole ); rc != 0 ) {
+				return rc;
+			}
+			// Equal integer parts, lhs is exact as a double when rhs has a fraction
+			return compare_numbers( static_cast<double>( lhs ), rhs );
+		}
+	} // namespace
+
+	int compare_cells( cell_value const &lhs, cell_value const &rhs ) {
+		auto const lhs_type = lhs.get_type( );
+		auto const rhs_type = rhs.get_type( );
+		if( auto const rank = type_rank( lhs_type ) - type_rank( rhs_type );
+		    rank != 0 ) {
+			return rank;
+		}
+		switch( lhs_type ) {
+		case column_type::Null:
+			return 0;
+		case column_type::Integer:
+			if( rhs_type == column_type::Integer ) {
+				return compare_numbers( lhs.get_integer( ), rhs.get_integer( ) );
+			}
+			return compare_integer_float( lhs.get_integer( ), rhs.get_float( ) );
+		case column_type::Float:
+			if( rhs_type == column_type::Integer ) {
+				return -compare_integer_float( rhs.get_integer( ), lhs.get_float( ) );
+			}
+			return compare_numbers( lhs.get_float( ), rhs.get_float( ) );
+		case column_type::Text: {
+			auto const l = lhs.get_text( );
+			auto const r = rhs.get_text( );
+			return compare_bytes( l.data( ), l.size( ), r.data( ), r.size( ) );
+		}
+		case column_type::Blob: {
+			auto const l = lhs.get_blob( );
+			auto const r = rhs.get_blob( );
+			return compare_bytes( l.data( ), l.size( ), r.data( ), r.size( ) );
+		}
+		}
+		return 0;
+	}
+
+	result_set::result_set( std::shared_ptr<column_metadata const> metadata,
+	                        std::size_t row_count,
+	                        std::span<cell_value const> cells,
+	                        std::span<std::byte const> bytes )
+	  : m_metadata( std::move( metadata ) )
+	  , m_row_count( row_count )
+	  , m_column_count( m_metadata->size( ) )
+	  , m_byte_count( bytes.size( ) ) {
+		assert( cells.size( ) == m_row_count * m_column_count );
+		auto const cell_bytes = cells.size( ) * sizeof( cell_value );
+		if( cell_bytes + m_byte_count == 0 ) {
+			return;
+		}
+		m_block.reset( new std::byte[cell_bytes + m_byte_count] );
+		auto *const block_bytes = m_block.get( ) + cell_bytes;
+		if( not bytes.empty( ) ) {
+			std::memcpy( block_bytes, bytes.data( ), bytes.size( ) );
+		}
+		// Text and blob values are pointed at the same offset in the block
+		auto const rebase = [&]( void const *ptr ) {
+			return block_bytes +
+			       ( static_cast<std::byte const *>( ptr ) - bytes.data( ) );
+		};
+		auto *out = this->cells( );
+		for( auto const &cell : cells ) {
+			switch( cell.get_type( ) ) {
+			case column_type::Text: {
+				auto const text = cell.get_text( );
+				std::construct_at(
+				  out,
+				  types::text_t( reinterpret_cast<char const *>( rebase( text.data( ) ) ),
+				                 text.size( ) ) );
+				break;
+			}
+			case column_type::Blob: {
+				auto const blob = cell.get_blob( );
+				std::construct_at(
+				  out, types::blob_t( rebase( blob.data( ) ), blob.size( ) ) );
+				break;
+			}
+			default:
+				std::construct_at( out, cell );
+				break;
+			}
+			++out;
+		}
+	}
+
+	void result_set::apply_order( std::span<std::size_t const> order ) {
+		assert( order.size( ) == m_row_count );
+		if( m_column_count == 0 ) {
+			return;
+		}
+		auto *const first = cells( );
+		auto done = std::vector<bool>( m_row_count );
+		auto held = std::vector<cell_value>( m_column_count );
+		// Follow each cycle of the permutation, holding one row aside
+		for( std::size_t start = 0; start != m_row_count; ++start ) {
+			if( done[start] or order[start] == start ) {
+				continue;
+			}
+			std::copy_n( first + start * m_column_count, m_column_count,
+			             held.data( ) );
+			auto row = start;
+			while( order[row] != start ) {
+				std::copy_n( first + order[row] * m_column_count,
+				             m_column_count,
+				             first + row * m_column_count );
+				done[row] = true;
+				row = order[row];
+			}
+			std::copy_n( held.data( ), m_column_count, first + row * m_column_count );
+			done[row] = true;
+		}
+	}
+
+	void result_set::sort_by( std::size_t column, bool ascending ) {
+		daw_ensure( m_row_count == 0 or column < m_column_count );
+		sort( [&]( result_set_row const &lhs, result_set_row const &rhs ) {
+			auto const rc = compare_cells( lhs[column], rhs[column] );
+			return ascending ? rc < 0 : rc > 0;
+		} );
+	}
+} // namespace daw::sqlite
@@ -7,19 +7,24 @@
 //
 
 #include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/busy_policy.h"
 #include "daw/sqlite/prepared_statement.h"
 #include "daw/sqlite/query_iterator.h"
+#include "daw/sqlite/row_cursor.h"
 
 #include <daw/daw_contiguous_view.h>
 #include <daw/daw_move.h>
 #include <daw/daw_string_view.h>
 
+#include <cctype>
 #include <cstddef>
 #include <iostream>
+#include <memory>
 #include <sqlite3.h>
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace daw::sqlite {
 	namespace types {
@@ -33,7 +38,8 @@ namespace daw::sqlite {
 	} // namespace types
 
 	sqlite3_exception::sqlite3_exception( int err_no )
-	  : m_message( sqlite3_errstr( err_no ) ) {}
+	  : m_error( err_no )
+	  , m_message( sqlite3_errstr( err_no ) ) {}
 
 	char const *sqlite3_exception::what( ) const noexcept {
 		return m_message.c_str( );
@@ -43,23 +49,212 @@ namespace daw::sqlite {
 		return m_error;
 	}
 
+	bool sqlite3_exception::is_busy( ) const {
+		return m_error >= 0 and busy_impl::is_busy_code( m_error );
+	}
+
 	sqlite3_exception::sqlite3_exception( std::string message )
 	  : m_message( std::move( message ) ) {}
 
-	void database::open( std::filesystem::path filename ) {
+	void database::open( std::filesystem::path filename,
+	                     open_options const &options ) {
 		sqlite3 *ptr = nullptr;
-		auto result = sqlite3_open( filename.c_str( ), &ptr );
+		auto result =
+		  sqlite3_open_v2( filename.c_str( ), &ptr, options.flags( ), nullptr );
 		if( result ) {
-			throw sqlite3_exception( "Could not open database " +
-			                         static_cast<std::string>( filename ) + ": " +
-			                         sqlite3_errmsg( ptr ) );
+			auto message = "Could not open database " +
+			               static_cast<std::string>( filename ) + ": " +
+			               sqlite3_errmsg( ptr );
+			sqlite3_close( ptr );
+			throw sqlite3_exception( std::move( message ) );
+		}
+		// Configured on its own so that when an option fails the new connection
+		// is closed and this database is left as it was
+		auto opened = database( ptr );
+		opened.m_statement_cache.set_capacity( options.statement_cache_capacity );
+		opened.apply( options );
+		close( );
+		*this = std::move( opened );
+	}
+
+	namespace {
+		[[nodiscard]] char const *to_pragma_value( journal_mode mode ) {
+			switch( mode ) {
+			case journal_mode::Delete:
+				return "DELETE";
+			case journal_mode::Truncate:
+				return "TRUNCATE";
+			case journal_mode::Persist:
+				return "PERSIST";
+			case journal_mode::Memory:
+				return "MEMORY";
+			case journal_mode::WAL:
+				return "WAL";
+			case journal_mode::Off:
+				return "OFF";
+			}
+			throw sqlite3_exception( "Unknown journal mode" );
+		}
+
+		[[nodiscard]] char const *to_pragma_value( synchronous_mode mode ) {
+			switch( mode ) {
+			case synchronous_mode::Off:
+				return "OFF";
+			case synchronous_mode::Normal:
+				return "NORMAL";
+			case synchronous_mode::Full:
+				return "FULL";
+			case synchronous_mode::Extra:
+				return "EXTRA";
+			}
+			throw sqlite3_exception( "Unknown synchronous mode" );
+		}
+
+		[[nodiscard]] char const *to_pragma_value( temp_store_mode mode ) {
+			switch( mode ) {
+			case temp_store_mode::Default:
+				return "DEFAULT";
+			case temp_store_mode::File:
+				return "FILE";
+			case temp_store_mode::Memory:
+				return "MEMORY";
+			}
+			throw sqlite3_exception( "Unknown temp store mode" );
+		}
+
+		void pragma( database &db, char const *name, std::string const &value ) {
+			auto const sql = std::string( "PRAGMA " ) + name + '=' + value + ';';
+			// One off statements, so they bypass the statement cache
+			(void)db.exec( shared_prepared_statement( db, sql ) );
+		}
+
+		/***
+		 * @brief Set the journal mode and check that sqlite switched to it.  An
+		 * in memory database can only use MEMORY or OFF and keeps its own
+		 */
+		void set_journal_mode( database &db, journal_mode mode ) {
+			auto const requested = std::string( to_pragma_value( mode ) );
+			auto statement = shared_prepared_statement(
+			  db, "PRAGMA journal_mode=" + requested + ';' );
+			if( not statement.step( ) ) {
+				throw sqlite3_exception( "PRAGMA journal_mode returned no mode" );
+			}
+			auto result = static_cast<std::string>( statement.get_column_text( 0 ) );
+			for( char &c : result ) {
+				c = static_cast<char>( std::toupper( static_cast<unsigned char>( c ) ) );
+			}
+			statement.reset( );
+			if( result == requested ) {
+				return;
+			}
+			auto const *filename = sqlite3_db_filename( db.get_handle( ), "main" );
+			if( filename == nullptr or *filename == '\0' ) {
+				return;
+			}
+			throw sqlite3_exception( "Could not set journal_mode to " + requested +
+			                         ", it is " + result );
+		}
+	} // namespace
+
+	void database::apply( open_options const &options ) {
+		// Installed first so that the pragmas below wait for other connections,
+		// switching to WAL needs an exclusive lock
+		if( options.busy ) {
+			set_busy_policy( *options.busy );
+		} else if( options.busy_timeout ) {
+			auto policy = busy_policy{ };
+			policy.timeout = *options.busy_timeout;
+			set_busy_policy( policy );
+		}
+		// page_size must be set before journal_mode=WAL to have an effect
+		if( options.page_size and not options.read_only ) {
+			pragma( *this, "page_size", std::to_string( *options.page_size ) );
+		}
+		if( options.journal and not options.read_only ) {
+			set_journal_mode( *this, *options.journal );
+		}
+		if( options.synchronous ) {
+			pragma( *this, "synchronous", to_pragma_value( *options.synchronous ) );
+		}
+		if( options.cache_size ) {
+			pragma( *this, "cache_size", std::to_string( *options.cache_size ) );
+		}
+		if( options.mmap_size ) {
+			pragma( *this, "mmap_size", std::to_string( *options.mmap_size ) );
+		}
+		if( options.temp_store ) {
+			pragma( *this, "temp_store", to_pragma_value( *options.temp_store ) );
+		}
+	}
+
+	void database::set_busy_policy( busy_policy const &policy ) {
+		assert( m_db );
+		m_busy->policy = policy;
+		auto const rc =
+		  policy.backoff and policy.timeout.count( ) > 0
+		    ? sqlite3_busy_handler( get_handle( ), busy_impl::backoff_handler,
+		                            m_busy.get( ) )
+		    // Also removes a previously installed backoff handler
+		    : sqlite3_busy_timeout( get_handle( ),
+		                            static_cast<int>( policy.timeout.count( ) ) );
+		if( rc != SQLITE_OK ) {
+			throw sqlite3_exception( rc );
+		}
+	}
+
+	busy_policy const &database::get_busy_policy( ) const {
+		return m_busy->policy;
+	}
+
+	busy_stats database::get_busy_stats( ) const {
+		return m_busy->stats( );
+	}
+
+	void database::reset_busy_stats( ) {
+		m_busy->reset_stats( );
+	}
+
+	void database::enable_profiling( profiler_options const &options ) {
+		assert( m_db );
+		auto profiler = std::make_shared<profile_impl::profiler>( options );
+		auto const rc = sqlite3_trace_v2( get_handle( ), profiler->trace_mask( ),
+		                                  profile_impl::profiler::trace,
+		                                  profiler.get( ) );
+		if( rc != SQLITE_OK ) {
+			throw sqlite3_exception( rc );
+		}
+		m_profiler = std::move( profiler );
+	}
+
+	void database::disable_profiling( ) {
+		if( m_db ) {
+			(void)sqlite3_trace_v2( get_handle( ), 0, nullptr, nullptr );
+		}
+		m_profiler.reset( );
+	}
+
+	bool database::is_profiling( ) const {
+		return static_cast<bool>( m_profiler );
+	}
+
+	std::vector<statement_profile> database::profile_snapshot( ) const {
+		if( not m_profiler ) {
+			return { };
+		}
+		return m_profiler->snapshot( );
+	}
+
+	void database::reset_profile( ) {
+		if( m_profiler ) {
+			m_profiler->reset( );
 		}
-		m_db.reset( ptr );
-		m_is_open = true;
 	}
 
 	void database::close( ) {
+		m_statement_cache.clear( );
+		m_static_statements.clear( );
 		m_db.reset( );
+		m_profiler.reset( );
 		m_is_open.reset( );
 	}
 
@@ -76,30 +271,89 @@ namespace daw::sqlite {
 	daw::vector<std::string> database::tables( ) {
 		static constexpr daw::string_view sql =
 		  "SELECT name FROM sqlite_schema WHERE type='table' ORDER BY name;";
-		auto first = exec( sql );
-		auto last = first.end( );
-		auto const row_count = first.count( );
+		// Collect in one pass, counting first would step the query twice
+		auto names = std::vector<std::string>( );
+		for( auto const &row : exec( sql ) ) {
+			names.push_back( static_cast<std::string>( row.front( ).value.get_text( ) ) );
+		}
 		return daw::vector<std::string>(
 		  do_resize_and_overwrite,
-		  row_count,
+		  names.size( ),
 		  [&]( std::string *ptr, std::size_t sz ) {
-			  while( first != last ) {
-				  std::construct_at(
-				    ptr,
-				    static_cast<std::string>( first->front( ).value.get_text( ) ) );
-				  ++first;
+			  for( auto &name : names ) {
+				  std::construct_at( ptr, std::move( name ) );
 				  ++ptr;
 			  }
 			  return sz;
 		  } );
 	}
 
+	bool database::in_transaction( ) const {
+		assert( m_db );
+		return sqlite3_get_autocommit( m_db.get( ) ) == 0;
+	}
+
+	std::int64_t database::last_insert_rowid( ) const {
+		assert( m_db );
+		return sqlite3_last_insert_rowid( m_db.get( ) );
+	}
+
+	std::int64_t database::changes( ) const {
+		assert( m_db );
+		return sqlite3_changes64( m_db.get( ) );
+	}
+
 	bool database::has_table( daw::string_view table_name ) {
 		static constexpr daw::string_view sql =
-		  "SELECT name FROM sqlite_schema WHERE type='table' and name=?;";
-		auto const row_count = exec( sql, table_name ).count( );
-		assert( row_count <= 1 );
-		return row_count == 1;
+		  "SELECT 1 FROM sqlite_schema WHERE type='table' and name=? LIMIT 1;";
+		auto statement = m_statement_cache.get( *this, sql );
+		statement.bind_parameters( table_name );
+		auto const found = statement.step( );
+		// Done with the result even when the table was found, so no read lock
+		// is left behind
+		statement.reset( );
+		return found;
+	}
+
+	statement_cache &database::get_statement_cache( ) {
+		return m_statement_cache;
+	}
+
+	statement_cache const &database::get_statement_cache( ) const {
+		return m_statement_cache;
+	}
+
+	void database::remove_function( daw::string_view name, int arg_count ) {
+		assert( m_db );
+		auto const function_name = static_cast<std::string>( name );
+		auto const rc = sqlite3_create_function_v2( m_db.get( ),
+		                                            function_name.c_str( ),
+		                                            arg_count,
+		                                            SQLITE_UTF8,
+		                                            nullptr,
+		                                            nullptr,
+		                                            nullptr,
+		                                            nullptr,
+		                                            nullptr );
+		if( rc != SQLITE_OK ) {
+			throw sqlite3_exception( rc );
+		}
+	}
+
+	shared_prepared_statement
+	database::get_static_statement( std::size_t id, daw::string_view sql ) {
+		assert( m_db );
+		if( id >= m_static_statements.size( ) ) {
+			m_static_statements.resize( id + 1U );
+		}
+		auto &statement = m_static_statements[id];
+		if( not statement ) {
+			statement = shared_prepared_statement( *this, sql );
+		} else if( statement.use_count( ) != 1 ) {
+			return shared_prepared_statement( *this, sql );
+		}
+		// Reset with its bindings cleared when the caller is done with it
+		return statement.lease( );
 	}
 
 	query_iterator database::exec( prepared_statement statement ) {
@@ -112,11 +366,15 @@ namespace daw::sqlite {
 		return query_iterator( std::move( statement ) );
 	}
 
-	database::database( std::filesystem::path filename ) {
-		open( filename );
+	database::database( std::filesystem::path filename,
+	                    open_options const &options ) {
+		open( filename, options );
 	}
 
 	sqlite3 *database::release( ) {
+		m_statement_cache.clear( );
+		m_static_statements.clear( );
+		disable_profiling( );
 		m_is_open.reset( );
 		return m_db.release( );
 	}
@@ -128,28 +386,21 @@ namespace daw::sqlite {
 	}
 
 	namespace {
-		void delete_text_or_blob( void *val ) {
-			auto ptr = static_cast<char const *>( val );
-			delete[] ptr;
-		}
-	} // namespace
-
-	namespace {
-		template<PreparedStatement T>
-		cell_value::value_t get_column( T &statement, size_t column ) {
-			switch( statement.get_column_type( column ) ) {
+		cell_value::value_t get_column( row_cursor const &cursor,
+		                                size_t column ) noexcept {
+			switch( cursor.get_column_type( column ) ) {
 			case column_type::Float:
 				return cell_value::value_t( std::in_place_type<types::real_t>,
-				                            statement.get_column_float( column ) );
+				                            cursor.get_column_float( column ) );
 			case column_type::Integer:
 				return cell_value::value_t( std::in_place_type<types::integer_t>,
-				                            statement.get_column_integer( column ) );
+				                            cursor.get_column_integer( column ) );
 			case column_type::Text:
 				return cell_value::value_t( std::in_place_type<types::text_t>,
-				                            statement.get_column_text( column ) );
+				                            cursor.get_column_text( column ) );
 			case column_type::Blob:
 				return cell_value::value_t( std::in_place_type<types::blob_t>,
-				                            statement.get_column_blob( column ) );
+				                            cursor.get_column_blob( column ) );
 			case column_type::Null:
 				return cell_value::value_t( std::in_place_type<cell_value::null_cell_t>,
 				                            cell_value::null_cell_t{ } );
@@ -158,13 +409,25 @@ namespace daw::sqlite {
 				std::terminate( );
 			}
 		}
+
+		template<PreparedStatement T>
+		row_cursor checked_cursor( T &statement, size_t column ) {
+			auto result = row_cursor( statement );
+			if( result.get_column_count( ) <= column ) {
+				throw sqlite3_exception( "Column specified is out of range" );
+			}
+			return result;
+		}
 	} // namespace
 
 	cell_value::cell_value( prepared_statement &statement, size_t column )
-	  : m_value{ get_column( statement, column ) } {}
+	  : m_value{ get_column( checked_cursor( statement, column ), column ) } {}
 
 	cell_value::cell_value( shared_prepared_statement &statement, size_t column )
-	  : m_value{ get_column( statement, column ) } {}
+	  : m_value{ get_column( checked_cursor( statement, column ), column ) } {}
+
+	cell_value::cell_value( row_cursor const &cursor, size_t column ) noexcept
+	  : m_value{ get_column( cursor, column ) } {}
 
 	std::string to_string( cell_value const &value ) {
 		switch( value.get_type( ) ) {
@@ -0,0 +1,82 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/statement_cache.h"
+#include "daw/sqlite/prepared_statement.h"
+#include "daw/sqlite/sqlite3_class.h"
+
+#include <daw/daw_string_view.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace daw::sqlite {
+	statement_cache::statement_cache( std::size_t capacity )
+	  : m_capacity( capacity ) {}
+
+	shared_prepared_statement statement_cache::get( database &db,
+	                                                daw::string_view sql ) {
+		auto const key = std::string_view( sql.data( ), sql.size( ) );
+		if( auto pos = m_index.find( key ); pos != m_index.end( ) ) {
+			auto entry = pos->second;
+			if( entry->statement.use_count( ) == 1 ) {
+				// The previous user's lease reset it and cleared its bindings
+				m_entries.splice( m_entries.begin( ), m_entries, entry );
+				++m_stats.hits;
+				return entry->statement.lease( );
+			}
+			// Still being stepped by someone else
+			++m_stats.misses;
+			return shared_prepared_statement( db, sql );
+		}
+		++m_stats.misses;
+		auto statement = shared_prepared_statement( db, sql );
+		if( m_capacity == 0 ) {
+			return statement;
+		}
+		evict_to( m_capacity - 1 );
+		m_entries.push_front( entry_t{ std::string( key ), statement } );
+		m_index.emplace( m_entries.front( ).sql, m_entries.begin( ) );
+		return statement.lease( );
+	}
+
+	void statement_cache::evict_to( std::size_t count ) {
+		while( m_entries.size( ) > count ) {
+			m_index.erase( m_entries.back( ).sql );
+			m_entries.pop_back( );
+			++m_stats.evictions;
+		}
+	}
+
+	void statement_cache::clear( ) {
+		m_index.clear( );
+		m_entries.clear( );
+	}
+
+	void statement_cache::set_capacity( std::size_t capacity ) {
+		m_capacity = capacity;
+		evict_to( m_capacity );
+	}
+
+	std::size_t statement_cache::capacity( ) const {
+		return m_capacity;
+	}
+
+	std::size_t statement_cache::size( ) const {
+		return m_entries.size( );
+	}
+
+	statement_cache_stats const &statement_cache::stats( ) const {
+		return m_stats;
+	}
+
+	void statement_cache::reset_stats( ) {
+		m_stats = statement_cache_stats{ };
+	}
+} // namespace daw::sqlite
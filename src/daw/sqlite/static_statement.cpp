@@ -0,0 +1,19 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/static_statement.h"
+
+#include <atomic>
+#include <cstddef>
+
+namespace daw::sqlite::static_impl {
+	std::size_t next_statement_id( ) {
+		static auto next_id = std::atomic<std::size_t>( 0 );
+		return next_id++;
+	}
+} // namespace daw::sqlite::static_impl
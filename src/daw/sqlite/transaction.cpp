@@ -0,0 +1,157 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/transaction.h"
+#include "daw/sqlite/identifier.h"
+#include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/sqlite3_exception.h"
+
+#include <daw/daw_string_view.h>
+
+#include <string>
+#include <utility>
+
+namespace daw::sqlite {
+	namespace {
+		[[nodiscard]] daw::string_view begin_sql( transaction_mode mode ) {
+			switch( mode ) {
+			case transaction_mode::Deferred:
+				return "BEGIN DEFERRED;";
+			case transaction_mode::Immediate:
+				return "BEGIN IMMEDIATE;";
+			case transaction_mode::Exclusive:
+				return "BEGIN EXCLUSIVE;";
+			}
+			throw sqlite3_exception( "Unknown transaction mode" );
+		}
+
+		// Errors are ignored when sqlite has already rolled the transaction back,
+		// e.g. after SQLITE_FULL or SQLITE_IOERR
+		void rollback_sql( database &db, daw::string_view sql ) {
+			try {
+				db.exec( sql );
+			} catch( sqlite3_exception const & ) {
+				if( db.in_transaction( ) ) {
+					throw;
+				}
+			}
+		}
+
+		// The name is only quoted here, name( ) gives it as it was created
+		[[nodiscard]] std::string savepoint_sql( daw::string_view verb,
+		                                         std::string const &name ) {
+			auto result = static_cast<std::string>( verb );
+			result += ' ';
+			result += sql_impl::quote_identifier( name );
+			result += ';';
+			return result;
+		}
+	} // namespace
+
+	transaction::transaction( database &db, transaction_mode mode )
+	  : m_db( &db ) {
+		m_db->exec( begin_sql( mode ) );
+	}
+
+	transaction::transaction( transaction &&other ) noexcept
+	  : m_db( std::exchange( other.m_db, nullptr ) ) {}
+
+	transaction::~transaction( ) {
+		if( not m_db ) {
+			return;
+		}
+		try {
+			rollback( );
+		} catch( ... ) {
+			// Cannot be reported from a destructor
+		}
+	}
+
+	void transaction::commit( ) {
+		if( not m_db ) {
+			throw sqlite3_exception( "Transaction is not active" );
+		}
+		m_db->exec( "COMMIT;" );
+		m_db = nullptr;
+	}
+
+	void transaction::rollback( ) {
+		if( not m_db ) {
+			throw sqlite3_exception( "Transaction is not active" );
+		}
+		auto *db = std::exchange( m_db, nullptr );
+		rollback_sql( *db, "ROLLBACK;" );
+	}
+
+	bool transaction::is_active( ) const {
+		return m_db != nullptr;
+	}
+
+	savepoint::savepoint( database &db )
+	  : m_db( &db )
+	  , m_name( "daw_sp_" + std::to_string( db.m_savepoint_depth ) )
+	  , m_is_generated_name( true ) {
+		m_db->exec( savepoint_sql( "SAVEPOINT", m_name ) );
+		++m_db->m_savepoint_depth;
+	}
+
+	savepoint::savepoint( database &db, daw::string_view name )
+	  : m_db( &db )
+	  , m_name( static_cast<std::string>( name ) ) {
+		m_db->exec( savepoint_sql( "SAVEPOINT", m_name ) );
+	}
+
+	savepoint::savepoint( savepoint &&other ) noexcept
+	  : m_db( std::exchange( other.m_db, nullptr ) )
+	  , m_name( std::move( other.m_name ) )
+	  , m_is_generated_name( other.m_is_generated_name ) {}
+
+	savepoint::~savepoint( ) {
+		if( not m_db ) {
+			return;
+		}
+		try {
+			rollback( );
+		} catch( ... ) {
+			// Cannot be reported from a destructor
+		}
+	}
+
+	void savepoint::finish( ) {
+		if( m_is_generated_name ) {
+			--m_db->m_savepoint_depth;
+		}
+		m_db = nullptr;
+	}
+
+	void savepoint::release( ) {
+		if( not m_db ) {
+			throw sqlite3_exception( "Savepoint is not active" );
+		}
+		m_db->exec( savepoint_sql( "RELEASE", m_name ) );
+		finish( );
+	}
+
+	void savepoint::rollback( ) {
+		if( not m_db ) {
+			throw sqlite3_exception( "Savepoint is not active" );
+		}
+		auto &db = *m_db;
+		finish( );
+		rollback_sql( db, savepoint_sql( "ROLLBACK TO", m_name ) );
+		rollback_sql( db, savepoint_sql( "RELEASE", m_name ) );
+	}
+
+	bool savepoint::is_active( ) const {
+		return m_db != nullptr;
+	}
+
+	std::string const &savepoint::name( ) const {
+		return m_name;
+	}
+} // namespace daw::sqlite
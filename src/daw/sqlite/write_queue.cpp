@@ -0,0 +1,136 @@
+// Copyright (c) Darrell Wright
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/beached/sqlite_helper
+//
+
+#include "daw/sqlite/write_queue.h"
+#include "daw/sqlite/sqlite3_class.h"
+#include "daw/sqlite/sqlite3_exception.h"
+#include "daw/sqlite/transaction.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace daw::sqlite {
+	write_queue::write_queue( std::filesystem::path const &filename,
+	                          write_queue_options const &options )
+	  : m_db( filename, options.open )
+	  , m_options( options ) {
+		m_options.max_batch = std::max<std::size_t>( m_options.max_batch, 1U );
+		m_writer = std::thread( [this] { run( ); } );
+	}
+
+	write_queue::~write_queue( ) {
+		{
+			auto const lck = std::lock_guard( m_mutex );
+			m_stopping = true;
+		}
+		m_has_work.notify_one( );
+		m_writer.join( );
+	}
+
+	void write_queue::enqueue( std::unique_ptr<write_impl::write> w ) {
+		{
+			auto const lck = std::lock_guard( m_mutex );
+			m_queue.push_back( std::move( w ) );
+		}
+		m_has_work.notify_one( );
+	}
+
+	void write_queue::run( ) {
+		auto batch = std::deque<std::unique_ptr<write_impl::write>>( );
+		auto lck = std::unique_lock( m_mutex );
+		while( true ) {
+			m_has_work.wait( lck, [&] { return m_stopping or not m_queue.empty( ); } );
+			if( m_queue.empty( ) ) {
+				// Stopping and everything queued has been committed
+				return;
+			}
+			if( m_options.max_delay.count( ) > 0 and not m_stopping and
+			    m_queue.size( ) < m_options.max_batch ) {
+				// Give concurrent writers a chance to join this batch
+				(void)m_has_work.wait_for( lck, m_options.max_delay, [&] {
+					return m_stopping or m_queue.size( ) >= m_options.max_batch;
+				} );
+			}
+			auto const count = std::min( m_queue.size( ), m_options.max_batch );
+			std::move( m_queue.begin( ),
+			           m_queue.begin( ) + static_cast<std::ptrdiff_t>( count ),
+			           std::back_inserter( batch ) );
+			m_queue.erase( m_queue.begin( ),
+			               m_queue.begin( ) + static_cast<std::ptrdiff_t>( count ) );
+			lck.unlock( );
+			commit_batch( batch );
+			batch.clear( );
+			lck.lock( );
+		}
+	}
+
+	void write_queue::commit_batch(
+	  std::deque<std::unique_ptr<write_impl::write>> &batch ) {
+		enum class write_state { Queued, Ran, Failed };
+		auto states = std::vector<write_state>( batch.size( ), write_state::Queued );
+		auto failed_writes = std::size_t{ 0 };
+		auto commit_failed = false;
+		try {
+			auto tx = transaction( m_db, transaction_mode::Immediate );
+			for( std::size_t n = 0; n < batch.size( ); ++n ) {
+				auto sp = savepoint( m_db );
+				if( batch[n]->run( m_db ) ) {
+					sp.release( );
+					states[n] = write_state::Ran;
+				} else {
+					sp.rollback( );
+					states[n] = write_state::Failed;
+					++failed_writes;
+					if( not m_db.in_transaction( ) ) {
+						// sqlite rolled back the whole transaction, e.g. after
+						// SQLITE_FULL.  The writes that ran are lost and the rest must not
+						// run outside of it
+						throw sqlite3_exception( "The batch transaction was rolled back" );
+					}
+				}
+			}
+			tx.commit( );
+		} catch( ... ) {
+			// Nothing in the batch was kept
+			commit_failed = true;
+			auto const error = std::current_exception( );
+			for( std::size_t n = 0; n < batch.size( ); ++n ) {
+				if( states[n] != write_state::Failed ) {
+					batch[n]->fail( error );
+				}
+			}
+		}
+		if( not commit_failed ) {
+			for( std::size_t n = 0; n < batch.size( ); ++n ) {
+				if( states[n] == write_state::Ran ) {
+					batch[n]->complete( );
+				}
+			}
+		}
+		auto const lck = std::lock_guard( m_mutex );
+		++m_stats.batches;
+		m_stats.writes += batch.size( );
+		m_stats.failed_writes += failed_writes;
+		if( commit_failed ) {
+			++m_stats.failed_commits;
+		}
+	}
+
+	write_queue_stats write_queue::stats( ) {
+		auto const lck = std::lock_guard( m_mutex );
+		return m_stats;
+	}
+} // namespace daw::sqlite
@@ -6,10 +6,1368 @@
 // Official repository: https://github.com/beached/sqlite_helper
 //
 
+#include <daw/sqlite/async_database.h>
+#include <daw/sqlite/blob_stream.h>
+#include <daw/sqlite/bulk_inserter.h>
+#include <daw/sqlite/cached_kv_store.h>
+#include <daw/sqlite/connection_pool.h>
+#include <daw/sqlite/identifier.h>
+#include <daw/sqlite/kv_store.h>
+#include <daw/sqlite/parallel_scan.h>
 #include <daw/sqlite/sqlite3_class.h>
+#include <daw/sqlite/static_statement.h>
+#include <daw/sqlite/write_queue.h>
 #include <daw/daw_print.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <limits>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+	/***
+	 * @brief The integer in the first column of the first row of sql
+	 */
+	std::int64_t query_integer( daw::sqlite::database &db, daw::string_view sql ) {
+		auto st = daw::sqlite::shared_prepared_statement( db, sql );
+		auto const has_row = st.step( );
+		assert( has_row );
+		(void)has_row;
+		return st.get_column_integer( 0 );
+	}
+
+	/***
+	 * @brief A path in the temporary directory, removed along with its journal
+	 * and WAL files on construction and destruction
+	 */
+	struct temp_db_path {
+		std::filesystem::path path;
+
+		explicit temp_db_path( std::string const &name )
+		  : path( std::filesystem::temp_directory_path( ) /
+		          ( "sqlite_helper_test_" + name + ".sqlite" ) ) {
+			remove( );
+		}
+
+		temp_db_path( temp_db_path const & ) = delete;
+		temp_db_path &operator=( temp_db_path const & ) = delete;
+
+		~temp_db_path( ) {
+			remove( );
+		}
+
+		void remove( ) const {
+			auto ec = std::error_code( );
+			for( char const *suffix : { "", "-journal", "-wal", "-shm" } ) {
+				std::filesystem::remove( path.string( ) + suffix, ec );
+			}
+		}
+	};
+
+	void test_statement_cache_release( ) {
+		auto const file = temp_db_path( "cache_release" );
+		auto db = daw::sqlite::database( file.path );
+		db.exec( "CREATE TABLE t( v INTEGER );" );
+		for( std::int64_t n = 0; n < 3; ++n ) {
+			db.exec( "INSERT INTO t( v ) VALUES( ? );", n );
+		}
+		auto other = daw::sqlite::database( file.path );
+		{
+			// Dropped before the result is done
+			auto it = db.exec( "SELECT v FROM t WHERE v>=?;", std::int64_t{ 0 } );
+			assert( not it.empty( ) );
+		}
+		assert( not db.in_transaction( ) );
+		// Both need the read lock of the dropped query to be released
+		other.exec( "INSERT INTO t( v ) VALUES( ? );", std::int64_t{ 3 } );
+		db.exec( "CREATE TABLE t2( v INTEGER );" );
+		db.exec( "DROP TABLE t2;" );
+		// The cached statement is reused, reset and with its bindings cleared
+		auto &cache = db.get_statement_cache( );
+		cache.reset_stats( );
+		auto it = db.exec( "SELECT v FROM t WHERE v>=?;", std::int64_t{ 2 } );
+		assert( cache.stats( ).hits == 1 );
+		assert( it.count( ) == 2 );
+	}
+
+	void test_zero_copy_binds( ) {
+		using daw::sqlite::bind_lifetime;
+		namespace types = daw::sqlite::types;
+		auto db = daw::sqlite::database( ":memory:" );
+		auto st = daw::sqlite::shared_prepared_statement(
+		  db, "SELECT ?1, typeof( ?1 ), ?2, typeof( ?2 );" );
+		auto const row = [&]( daw::sqlite::shared_prepared_statement &stmt ) {
+			auto const has_row = stmt.step( );
+			assert( has_row );
+			(void)has_row;
+			auto result = std::array<std::string, 4>( );
+			for( std::size_t n = 0; n < result.size( ); ++n ) {
+				result[n] = std::string( stmt.get_column_text( n ) );
+			}
+			stmt.reset( );
+			return result;
+		};
+		using row_t = std::array<std::string, 4>;
+
+		// Static binds refer to the caller's buffers
+		auto const text = std::string( "static text" );
+		auto const bytes = std::array{ std::byte{ 'a' }, std::byte{ 'b' } };
+		st.bind( 1, types::text_t( text ), bind_lifetime::Static );
+		st.bind( 2, types::blob_t( bytes.data( ), bytes.size( ) ), bind_lifetime::Static );
+		assert( ( row( st ) == row_t{ "static text", "text", "ab", "blob" } ) );
+
+		// Transient binds are copied, the buffer can change or go away
+		{
+			auto temp = std::string( "transient text long enough to be on the heap" );
+			st.bind( 1, types::text_t( temp ), bind_lifetime::Transient );
+			temp.assign( temp.size( ), 'x' );
+		}
+		assert( row( st )[0] == "transient text long enough to be on the heap" );
+
+		// Moved in buffers live as long as their binding, rebinding one index
+		// leaves the others in place
+		st.bind( 1, std::string( "owned text long enough to be on the heap" ) );
+		st.bind( 2, std::vector<std::byte>{ std::byte{ 'x' }, std::byte{ 'y' } } );
+		st.bind( 1, std::string( "rebound text long enough to be on the heap" ) );
+		auto const expected =
+		  row_t{ "rebound text long enough to be on the heap", "text", "xy", "blob" };
+		assert( row( st ) == expected );
+		// Bindings are kept when the statement is reset
+		assert( row( st ) == expected );
+		st.clear_bindings( );
+		assert( ( row( st ) == row_t{ "", "null", "", "null" } ) );
+
+		// Releasing a lease drops what was bound through it
+		{
+			auto leased = st.lease( );
+			leased.bind( 1, std::string( "leased text long enough to be on the heap" ) );
+			assert( row( leased )[0] == "leased text long enough to be on the heap" );
+			leased.bind( 1, std::string( "still bound when the lease is released" ) );
+		}
+		assert( row( st )[1] == "null" );
+
+		// Empty values are '' and x'', not NULL
+		st.bind( 1, types::text_t( ), bind_lifetime::Static );
+		st.bind( 2, types::blob_t( ), bind_lifetime::Static );
+		assert( ( row( st ) == row_t{ "", "text", "", "blob" } ) );
+		st.bind( 1, types::text_t( ), bind_lifetime::Transient );
+		st.bind( 2, std::vector<std::byte>( ) );
+		assert( ( row( st ) == row_t{ "", "text", "", "blob" } ) );
+		st.bind( 1, std::string( ) );
+		st.bind( 2, types::blob_t( ), bind_lifetime::Transient );
+		assert( ( row( st ) == row_t{ "", "text", "", "blob" } ) );
+	}
+
+	void test_integer_parameters( ) {
+		auto db = daw::sqlite::database( ":memory:" );
+		db.exec( "CREATE TABLE t( v INTEGER );" );
+		// int and unsigned arguments bind as integers
+		db.exec( "INSERT INTO t( v ) VALUES( ? ), ( ? );", 1, 2U );
+		auto sum = std::int64_t{ 0 };
+		for( auto v : db.query_as<std::int64_t>( "SELECT v FROM t WHERE v>?;", 0 ) ) {
+			sum += v;
+		}
+		assert( sum == 3 );
+		// Unsigned values bind when they fit a 64 bit signed integer
+		constexpr auto max = std::uint64_t{ std::numeric_limits<std::int64_t>::max( ) };
+		db.exec( "INSERT INTO t( v ) VALUES( ? );", max );
+		assert( query_integer( db, "SELECT max( v ) FROM t;" ) ==
+		        std::numeric_limits<std::int64_t>::max( ) );
+		auto threw = false;
+		try {
+			db.exec( "INSERT INTO t( v ) VALUES( ? );", max + 1 );
+		} catch( daw::sqlite::sqlite3_exception const & ) {
+			threw = true;
+		}
+		assert( threw );
+		assert( query_integer( db, "SELECT count( * ) FROM t;" ) == 3 );
+	}
+
+	void test_row_cursor( ) {
+		auto db = daw::sqlite::database( ":memory:" );
+		auto st = daw::sqlite::shared_prepared_statement(
+		  db, "SELECT 1, 2.5, 'abc', NULL UNION ALL SELECT 2, 0.5, 'de', NULL;" );
+		auto const cursor = daw::sqlite::row_cursor( st );
+		assert( cursor.get_column_count( ) == 4 );
+		auto total = std::int64_t{ 0 };
+		auto length = std::size_t{ 0 };
+		while( st.step( ) ) {
+			assert( cursor.get_column_type( 0 ) == daw::sqlite::column_type::Integer );
+			assert( cursor.get_column_type( 1 ) == daw::sqlite::column_type::Float );
+			assert( cursor.is_column_null( 3 ) );
+			total += cursor.get_column_integer( 0 );
+			length += cursor.get_column_text( 2 ).size( );
+		}
+		assert( total == 3 );
+		assert( length == 5 );
+		// An empty statement is rejected once, when the cursor is made
+		auto empty = daw::sqlite::shared_prepared_statement( );
+		auto threw = false;
+		try {
+			(void)daw::sqlite::row_cursor( empty );
+		} catch( daw::sqlite::sqlite3_exception const & ) {
+			threw = true;
+		}
+		assert( threw );
+	}
+
+	void test_bulk_inserter( ) {
+		auto db = daw::sqlite::database( ":memory:" );
+		db.exec( "CREATE TABLE t( a INTEGER, b TEXT );" );
+		using row_t = std::tuple<std::int64_t, std::string>;
+		{
+			auto rows = std::vector<row_t>{ { 1, "a" }, { 2, "b" }, { 3, "c" } };
+			auto options = daw::sqlite::bulk_insert_options{ };
+			options.rows_per_statement = 2;
+			auto inserter =
+			  daw::sqlite::bulk_inserter<row_t>( db, "t", { "a", "b" }, options );
+			inserter.insert( rows );
+			assert( inserter.finish( ) == 3 );
+		}
+		{
+			// Rows not finished are rolled back
+			auto inserter = daw::sqlite::bulk_inserter<row_t>( db, "t", { "a", "b" } );
+			inserter.insert( row_t{ 4, "d" } );
+		}
+		assert( not db.in_transaction( ) );
+		assert( query_integer( db, "SELECT count(*) FROM t;" ) == 3 );
+		assert( query_integer( db, "SELECT sum( length( b ) ) FROM t;" ) == 3 );
+		auto const rows = std::vector<row_t>{ { 5, "e" } };
+		assert( daw::sqlite::bulk_insert( db, "t", { "a", "b" }, rows ) == 1 );
+		assert( query_integer( db, "SELECT max( a ) FROM t;" ) == 5 );
+
+		// Empty text and blobs are inserted as '' and x'', not NULL
+		db.exec( "CREATE TABLE e( t TEXT, b BLOB );" );
+		using empty_row_t = std::tuple<std::string_view, std::vector<std::byte>>;
+		auto const empty_rows = std::vector<empty_row_t>{ { }, { } };
+		assert( daw::sqlite::bulk_insert( db, "e", { "t", "b" }, empty_rows ) == 2 );
+		assert( query_integer( db,
+		                       "SELECT count( * ) FROM e WHERE typeof( t ) = 'text' "
+		                       "AND typeof( b ) = 'blob';" ) == 2 );
+	}
+
+	void test_transactions( ) {
+		auto db = daw::sqlite::database( ":memory:" );
+		db.exec( "CREATE TABLE t( v INTEGER );" );
+		{
+			auto tx = daw::sqlite::transaction( db );
+			db.exec( "INSERT INTO t( v ) VALUES( 1 );" );
+			{
+				auto sp = daw::sqlite::savepoint( db );
+				db.exec( "INSERT INTO t( v ) VALUES( 2 );" );
+				sp.release( );
+			}
+			{
+				// Not released, rolled back
+				auto sp = daw::sqlite::savepoint( db );
+				db.exec( "INSERT INTO t( v ) VALUES( 3 );" );
+			}
+			tx.commit( );
+			assert( not tx.is_active( ) );
+		}
+		assert( query_integer( db, "SELECT sum( v ) FROM t;" ) == 3 );
+		{
+			// Not committed, rolled back
+			auto tx = daw::sqlite::transaction( db );
+			db.exec( "INSERT INTO t( v ) VALUES( 4 );" );
+		}
+		assert( not db.in_transaction( ) );
+		assert( query_integer( db, "SELECT sum( v ) FROM t;" ) == 3 );
+		{
+			// A commit that fails is reported by commit, the destructor rolls back
+			auto tx = daw::sqlite::transaction( db );
+			db.exec( "COMMIT;" );
+			auto threw = false;
+			try {
+				tx.commit( );
+			} catch( daw::sqlite::sqlite3_exception const & ) {
+				threw = true;
+			}
+			assert( threw );
+		}
+		assert( not db.in_transaction( ) );
+		{
+			// Names are given unquoted, and quoted in the SQL
+			auto outer = daw::sqlite::savepoint( db );
+			assert( outer.name( ) == "daw_sp_0" );
+			auto named = daw::sqlite::savepoint( db, "my \"sp\"" );
+			assert( named.name( ) == "my \"sp\"" );
+			db.exec( "INSERT INTO t( v ) VALUES( 5 );" );
+			named.rollback( );
+			outer.release( );
+		}
+		assert( not db.in_transaction( ) );
+		assert( query_integer( db, "SELECT sum( v ) FROM t;" ) == 3 );
+	}
+
+	void test_open_options( ) {
+		auto const file = temp_db_path( "open_options" );
+		{
+			auto db = daw::sqlite::database(
+			  file.path, daw::sqlite::open_options::read_heavy( ) );
+			auto st = daw::sqlite::shared_prepared_statement( db, "PRAGMA journal_mode;" );
+			auto const has_row = st.step( );
+			assert( has_row );
+			(void)has_row;
+			assert( st.get_column_text( 0 ) == "wal" );
+			assert( db.get_busy_policy( ).timeout.count( ) > 0 );
+		}
+		// An in memory database keeps its memory journal
+		auto db = daw::sqlite::database( ":memory:",
+		                                 daw::sqlite::open_options::read_heavy( ) );
+		assert( query_integer( db, "SELECT 1;" ) == 1 );
+
+		// An option that fails leaves the database as it was
+		auto const locked = temp_db_path( "open_options_locked" );
+		auto blocker = daw::sqlite::database( locked.path );
+		blocker.exec( "CREATE TABLE t( v INTEGER );" );
+		blocker.exec( "BEGIN EXCLUSIVE;" );
+		db.exec( "CREATE TABLE kept( v INTEGER );" );
+		auto options = daw::sqlite::open_options{ };
+		options.journal = daw::sqlite::journal_mode::WAL;
+		options.busy_timeout = std::chrono::milliseconds( 0 );
+		auto threw = false;
+		try {
+			db.open( locked.path, options );
+		} catch( daw::sqlite::sqlite3_exception const & ) {
+			threw = true;
+		}
+		assert( threw );
+		assert( db.has_table( "kept" ) );
+		blocker.exec( "COMMIT;" );
+		db.open( locked.path, options );
+		assert( db.has_table( "t" ) );
+		assert( not db.has_table( "kept" ) );
+	}
+
+	void test_connection_pool( ) {
+		auto const file = temp_db_path( "connection_pool" );
+		auto options = daw::sqlite::connection_pool_options{ };
+		options.reader_count = 2;
+		auto pool = daw::sqlite::connection_pool( file.path, options );
+		assert( pool.reader_count( ) == 2 );
+		{
+			auto writer = pool.acquire_writer( );
+			writer->exec( "CREATE TABLE t( v INTEGER );" );
+			writer->exec( "INSERT INTO t( v ) VALUES( 1 );" );
+			assert( not pool.try_acquire_writer( std::chrono::milliseconds( 1 ) ) );
+		}
+		{
+			// A transaction left open is rolled back when the lease ends
+			auto writer = pool.acquire_writer( );
+			writer->exec( "BEGIN;" );
+			writer->exec( "INSERT INTO t( v ) VALUES( 2 );" );
+		}
+		{
+			// A reader left inside a read transaction does not keep its snapshot
+			auto reader = pool.acquire_reader( );
+			reader->exec( "BEGIN;" );
+			assert( query_integer( *reader, "SELECT count(*) FROM t;" ) == 1 );
+			auto it = reader->exec( "SELECT v FROM t;" );
+			assert( not it.empty( ) );
+			reader.release( );
+			assert( not reader );
+		}
+		{
+			auto writer = pool.acquire_writer( );
+			assert( not writer->in_transaction( ) );
+			writer->exec( "INSERT INTO t( v ) VALUES( 3 );" );
+		}
+		auto first = pool.acquire_reader( );
+		auto second = pool.acquire_reader( );
+		assert( not pool.try_acquire_reader( std::chrono::milliseconds( 1 ) ) );
+		for( auto *reader : { &first, &second } ) {
+			assert( not ( *reader )->in_transaction( ) );
+			assert( query_integer( **reader, "SELECT sum( v ) FROM t;" ) == 4 );
+		}
+		// The pool needs a file it can switch to WAL
+		auto threw = false;
+		try {
+			(void)daw::sqlite::connection_pool( ":memory:", options );
+		} catch( daw::sqlite::sqlite3_exception const & ) {
+			threw = true;
+		}
+		assert( threw );
+	}
+
+	void test_buffered_rows( ) {
+		auto const file = temp_db_path( "buffered_rows" );
+		auto db = daw::sqlite::database( file.path );
+		db.exec( "CREATE TABLE t( v INTEGER, s TEXT );" );
+		db.exec( "INSERT INTO t VALUES( 1, 'a' ), ( 2, 'bb' ), ( 3, 'ccc' );" );
+		assert( db.has_table( "t" ) );
+		assert( not db.has_table( "missing" ) );
+		// has_table leaves no read lock behind
+		auto other = daw::sqlite::database( file.path );
+		other.exec( "INSERT INTO t VALUES( 4, 'dddd' );" );
+
+		auto it = db.exec( "SELECT v, s FROM t ORDER BY v;" );
+		++it;
+		// Counting buffers the remaining rows, which are then replayed
+		assert( it.count( ) == 3 );
+		auto sum = std::int64_t{ 0 };
+		auto length = std::size_t{ 0 };
+		for( ; it != it.end( ); ++it ) {
+			auto const &row = *it;
+			sum += row[0].value.get_integer( );
+			length += row[1].value.get_text( ).size( );
+		}
+		assert( sum == 9 );
+		assert( length == 9 );
+		assert( it.count( ) == 0 );
+		// Done with the statement, another connection can write
+		other.exec( "INSERT INTO t VALUES( 5, 'e' );" );
+	}
+
+	void test_fetch_batch( ) {
+		auto db = daw::sqlite::database( ":memory:" );
+		db.exec( "CREATE TABLE t( i INTEGER, f, s TEXT );" );
+		db.exec( "INSERT INTO t VALUES( NULL, 1, 'a' ), ( 2, 2.5, NULL ), "
+		         "( 3, NULL, 'bcd' );" );
+		auto it = db.exec( "SELECT i, f, s FROM t ORDER BY rowid;" );
+		auto batch = daw::sqlite::column_batch( );
+		assert( it.fetch_batch( batch, 2 ) == 2 );
+		assert( batch.column_count( ) == 3 );
+		assert( batch["i"].type( ) == daw::sqlite::column_type::Integer );
+		assert( batch["i"].is_null( 0 ) and batch["i"].integers( )[1] == 2 );
+		// A float after an integer widens the column
+		assert( batch["f"].type( ) == daw::sqlite::column_type::Float );
+		assert( batch["f"].floats( )[0] == 1.0 and batch["f"].floats( )[1] == 2.5 );
+		assert( batch["s"].text( 0 ) == "a" and batch["s"].is_null( 1 ) );
+		// Reused for the rest of the rows
+		assert( it.fetch_batch( batch, 2 ) == 1 );
+		assert( batch["s"].text( 0 ) == "bcd" );
+		assert( batch["f"].null_count( ) == 1 );
+		assert( it.fetch_batch( batch, 2 ) == 0 );
+		assert( not batch.get_index_of( "missing" ) );
+
+		// Text after an integer cannot be stored, the batch is left empty
+		auto mixed = db.exec( "SELECT 1 UNION ALL SELECT 'x';" );
+		auto threw = false;
+		try {
+			(void)mixed.fetch_batch( batch, 10 );
+		} catch( daw::sqlite::sqlite3_exception const & ) {
+			threw = true;
+		}
+		assert( threw );
+		assert( batch.empty( ) );
+	}
+
+	void test_column_metadata( ) {
+		auto names = std::vector<std::string>( );
+		for( int n = 0; n < 40; ++n ) {
+			names.push_back( "c" + std::to_string( n ) );
+		}
+		names.push_back( "c7" );
+		auto const metadata = daw::sqlite::column_metadata( names );
+		assert( metadata.size( ) == 41 );
+		for( std::size_t n = 0; n < 40; ++n ) {
+			assert( metadata.get_index_of( names[n] ) == n );
+		}
+		// A repeated name finds its first column
+		assert( metadata.get_index_of( "c7" ) == 7U );
+		assert( not metadata.get_index_of( "c40" ) );
+		assert( not metadata.get_index_of( "" ) );
+
+		// The rows of a query share one metadata
+		auto db = daw::sqlite::database( ":memory:" );
+		auto it = db.exec( "SELECT 1 AS a, 2 AS b UNION ALL SELECT 3, 4;" );
+		auto const first = *it;
+		++it;
+		auto const second = *it;
+		assert( first.metadata( ) == second.metadata( ) );
+		assert( second["b"].get_integer( ) == 4 );
+		assert( not second.get_index_of( "c" ) );
+	}
+
+	struct packed_point {
+		std::int32_t x;
+		std::int32_t y;
+	};
+
+	struct padded {
+		std::int8_t a;
+		std::int32_t b;
+	};
+
+	void test_kv_codec( ) {
+		static_assert( daw::db::KVDecodable<std::int64_t> );
+		static_assert( daw::db::KVDecodable<packed_point> );
+		static_assert( daw::db::KVEncodable<std::string_view> );
+		// Equal values must have equal bytes to be found again
+		static_assert( not daw::db::KVEncodable<double> );
+		static_assert( not daw::db::KVEncodable<padded> );
+		// Views and pointers would store an address
+		static_assert( not daw::db::KVEncodable<int *> );
+		static_assert( not daw::db::KVEncodable<std::span<int const>> );
+		static_assert( not daw::db::KVEncodable<daw::sqlite::types::blob_t> );
+
+		auto const bytes = daw::db::kv_encode( packed_point{ 1, -2 } );
+		assert( bytes.size( ) == sizeof( packed_point ) );
+		auto const point = daw::db::kv_codec<packed_point>::decode( bytes );
+		assert( point.x == 1 and point.y == -2 );
+		auto threw = false;
+		try {
+			(void)daw::db::kv_codec<std::int64_t>::decode( bytes.substr( 1 ) );
+		} catch( daw::sqlite::sqlite3_exception const & ) {
+			threw = true;
+		}
+		assert( threw );
+	}
+
+	void test_cached_kv_store( ) {
+		auto const file = temp_db_path( "cached_kv_store" );
+		auto options = daw::db::cached_kv_store_options{ };
+		options.shard_count = 4;
+		options.cache_bytes = 4096;
+		options.flush_interval = std::chrono::milliseconds( 5 );
+		options.store.open.busy_timeout = std::chrono::milliseconds( 0 );
+		auto store = daw::db::cached_kv_store( file.path, options );
+		for( std::int64_t n = 0; n < 100; ++n ) {
+			store.put( n, std::to_string( n ) );
+		}
+		store.erase( std::int64_t{ 7 } );
+		// Buffered writes are visible before they are flushed
+		assert( store.get<std::string>( std::int64_t{ 42 } ) == "42" );
+		assert( not store.contains( std::int64_t{ 7 } ) );
+		store.flush( );
+		assert( store.pending_writes( ) == 0 );
+		assert( store.stats( ).flushed_writes >= 100 );
+
+		// The background flush fails while another connection holds the write
+		// lock, the error is thrown by a later write
+		auto blocker = daw::sqlite::database( file.path );
+		blocker.exec( "BEGIN EXCLUSIVE;" );
+		store.put( std::int64_t{ 100 }, std::string( "100" ) );
+		auto threw = false;
+		for( int tries = 0; tries < 400 and not threw; ++tries ) {
+			std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+			try {
+				store.put( std::int64_t{ 100 }, std::string( "100" ) );
+			} catch( daw::sqlite::sqlite3_exception const &ex ) {
+				threw = ex.is_busy( );
+			}
+		}
+		assert( threw );
+		assert( store.stats( ).failed_flushes > 0 );
+		blocker.exec( "COMMIT;" );
+		store.put( std::int64_t{ 101 }, std::string( "101" ) );
+		// The failed writes stayed buffered
+		assert( store.get<std::string>( std::int64_t{ 100 } ) == "100" );
+		for( int tries = 0; tries < 400 and store.pending_writes( ) != 0; ++tries ) {
+			std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+		}
+		try {
+			store.flush( );
+		} catch( daw::sqlite::sqlite3_exception const & ) {
+			// A failure reported before the lock was released
+			store.flush( );
+		}
+		assert( store.pending_writes( ) == 0 );
+		auto const count = query_integer( blocker, "SELECT count(*) FROM kv_store;" );
+		assert( count == 101 );
+
+		// A write that fills the buffer does not throw when its flush fails, it
+		// is buffered and the error is thrown by the next write instead
+		auto const second_file = temp_db_path( "cached_kv_store_threshold" );
+		options.flush_interval = std::chrono::milliseconds( 0 );
+		options.max_pending_writes = 2;
+		auto second = daw::db::cached_kv_store( second_file.path, options );
+		auto second_blocker = daw::sqlite::database( second_file.path );
+		second_blocker.exec( "BEGIN EXCLUSIVE;" );
+		second.put( std::int64_t{ 1 }, std::string( "1" ) );
+		second.put( std::int64_t{ 2 }, std::string( "2" ) );
+		assert( second.stats( ).failed_flushes == 1 );
+		assert( second.pending_writes( ) == 2 );
+		assert( second.get<std::string>( std::int64_t{ 2 } ) == "2" );
+		threw = false;
+		try {
+			second.put( std::int64_t{ 3 }, std::string( "3" ) );
+		} catch( daw::sqlite::sqlite3_exception const &ex ) {
+			threw = ex.is_busy( );
+		}
+		assert( threw );
+		assert( not second.contains( std::int64_t{ 3 } ) );
+		second_blocker.exec( "COMMIT;" );
+		second.flush( );
+		assert( second.pending_writes( ) == 0 );
+		assert( query_integer( second_blocker, "SELECT count(*) FROM kv_store;" ) == 2 );
+	}
+
+	/***
+	 * @brief A coroutine that starts immediately and is not awaited
+	 */
+	struct detached_task {
+		struct promise_type {
+			detached_task get_return_object( ) {
+				return { };
+			}
+			std::suspend_never initial_suspend( ) noexcept {
+				return { };
+			}
+			std::suspend_never final_suspend( ) noexcept {
+				return { };
+			}
+			void return_void( ) {}
+			void unhandled_exception( ) {
+				std::terminate( );
+			}
+		};
+	};
+
+	detached_task sum_with_coroutine( daw::sqlite::async_database &db,
+	                                  std::promise<std::int64_t> result ) {
+		co_await db.co_exec( "INSERT INTO t( v ) VALUES( ? );", std::int64_t{ 10 } );
+		auto const rows = co_await db.co_query<std::int64_t>( "SELECT v FROM t;" );
+		auto sum = std::int64_t{ 0 };
+		for( auto v : rows ) {
+			sum += v;
+		}
+		try {
+			co_await db.co_exec( "SELECT * FROM missing;" );
+			sum = -1;
+		} catch( daw::sqlite::sqlite3_exception const & ) {
+		}
+		result.set_value( sum );
+	}
+
+	void test_async_database( ) {
+		auto db = daw::sqlite::async_database( ":memory:" );
+		db.async_exec( "CREATE TABLE t( v INTEGER );" ).get( );
+		// Operations run in the order they were queued
+		auto inserts = std::vector<std::future<void>>( );
+		for( std::int64_t n = 1; n <= 4; ++n ) {
+			inserts.push_back( db.async_exec( "INSERT INTO t( v ) VALUES( ? );", n ) );
+		}
+		auto rows = db.async_query<std::int64_t>( "SELECT v FROM t ORDER BY v;" );
+		assert( ( rows.get( ) == std::vector<std::int64_t>{ 1, 2, 3, 4 } ) );
+		for( auto &insert : inserts ) {
+			insert.get( );
+		}
+		auto const worker_id =
+		  db.submit( []( daw::sqlite::database & ) { return std::this_thread::get_id( ); } )
+		    .get( );
+		assert( worker_id != std::this_thread::get_id( ) );
+
+		// Errors reach the caller through the future
+		auto failed = db.async_exec( "SELECT * FROM missing;" );
+		auto threw = false;
+		try {
+			failed.get( );
+		} catch( daw::sqlite::sqlite3_exception const & ) {
+			threw = true;
+		}
+		assert( threw );
+
+		auto result = std::promise<std::int64_t>( );
+		auto sum = result.get_future( );
+		sum_with_coroutine( db, std::move( result ) );
+		assert( sum.get( ) == 20 );
+	}
+
+	template<typename T>
+	bool future_throws( std::future<T> &f ) {
+		try {
+			f.get( );
+		} catch( ... ) {
+			return true;
+		}
+		return false;
+	}
+
+	void test_write_queue( ) {
+		auto const file = temp_db_path( "write_queue" );
+		auto wq = daw::sqlite::write_queue( file.path );
+		wq.submit_exec( "CREATE TABLE t( v INTEGER );" ).get( );
+		{
+			// A write that throws is rolled back alone
+			auto first = wq.submit_exec( "INSERT INTO t( v ) VALUES( ? );", 1 );
+			auto bad = wq.submit( []( daw::sqlite::database &db ) {
+				db.exec( "INSERT INTO t( v ) VALUES( 100 );" );
+				throw std::runtime_error( "bad write" );
+			} );
+			auto last = wq.submit( []( daw::sqlite::database &db ) {
+				db.exec( "INSERT INTO t( v ) VALUES( 2 );" );
+				return db.changes( );
+			} );
+			first.get( );
+			assert( future_throws( bad ) );
+			assert( last.get( ) == 1 );
+		}
+		{
+			// A write that ends the batch transaction fails the writes of the
+			// batch, the rest are not run outside of it
+			auto started = std::promise<void>( );
+			auto gate = std::promise<void>( );
+			auto blocker = wq.submit(
+			  [&started, opened = gate.get_future( )]( daw::sqlite::database & ) {
+				  started.set_value( );
+				  opened.wait( );
+			  } );
+			// The writer is busy with the blocker's batch while the rest is queued
+			started.get_future( ).wait( );
+			auto before = wq.submit_exec( "INSERT INTO t( v ) VALUES( 3 );" );
+			auto ender = wq.submit( []( daw::sqlite::database &db ) {
+				db.exec( "ROLLBACK;" );
+				throw std::runtime_error( "rolled back" );
+			} );
+			auto after_ran = std::make_shared<bool>( false );
+			auto after = wq.submit( [after_ran]( daw::sqlite::database &db ) {
+				*after_ran = true;
+				db.exec( "INSERT INTO t( v ) VALUES( 4 );" );
+			} );
+			gate.set_value( );
+			blocker.get( );
+			assert( future_throws( before ) );
+			assert( future_throws( ender ) );
+			assert( future_throws( after ) );
+			assert( not *after_ran );
+		}
+		auto total = wq.submit( []( daw::sqlite::database &db ) {
+			return query_integer( db, "SELECT sum( v ) FROM t;" );
+		} );
+		assert( total.get( ) == 3 );
+		assert( wq.stats( ).failed_commits == 1 );
+	}
+
+	void test_busy_policy( ) {
+		auto const file = temp_db_path( "busy_policy" );
+		auto policy = daw::sqlite::busy_policy{ };
+		policy.step_retries = 2;
+		policy.backoff = daw::sqlite::busy_backoff{ };
+		policy.backoff->initial_delay = std::chrono::microseconds( 100 );
+		policy.backoff->max_delay = std::chrono::microseconds( 1000 );
+		auto options = daw::db::kv_store_options{ };
+		options.open.busy = policy;
+		auto kv = daw::db::kv_store( file.path, options );
+		auto &db = kv.get_database( );
+		kv.put( std::int64_t{ 1 }, std::string( "a" ) );
+
+		auto blocker = daw::sqlite::database( file.path );
+		blocker.exec( "BEGIN EXCLUSIVE;" );
+		db.reset_busy_stats( );
+		// The store's own statements retry and count under the busy policy
+		auto threw = false;
+		try {
+			kv.put( std::int64_t{ 2 }, std::string( "b" ) );
+		} catch( daw::sqlite::sqlite3_exception const &ex ) {
+			threw = ex.is_busy( );
+		}
+		assert( threw );
+		auto stats = db.get_busy_stats( );
+		assert( stats.step_retries == 2 );
+		assert( stats.busy_errors == 1 );
+
+		// With a timeout the handler waits with backoff for the lock
+		policy.timeout = std::chrono::milliseconds( 5'000 );
+		policy.step_retries = 0;
+		db.set_busy_policy( policy );
+		db.reset_busy_stats( );
+		auto release = std::thread( [&] {
+			std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+			blocker.exec( "COMMIT;" );
+		} );
+		kv.put( std::int64_t{ 2 }, std::string( "b" ) );
+		release.join( );
+		stats = db.get_busy_stats( );
+		assert( stats.handler_calls > 0 );
+		assert( stats.waited.count( ) > 0 );
+		assert( stats.busy_errors == 0 );
+		assert( kv.get<std::string>( std::int64_t{ 2 } ) == "b" );
+	}
+
+	void test_profiler( ) {
+		using daw::sqlite::normalize_sql;
+		assert( normalize_sql( "SELECT  *  FROM t WHERE a = 'it''s' -- note\n"
+		                       " AND b=x'0AFF'" ) ==
+		        "SELECT * FROM t WHERE a = ? AND b=?" );
+		assert( normalize_sql( "select a$b, ?12, :name, 1.5e-3, 0x1F from \"t 1\" "
+		                       "/* c */ where [c]=.5 and t1=X'00'" ) ==
+		        "select a$b, ?, :name, ?, ? from \"t 1\" where [c]=? and t1=?" );
+
+		auto histogram = daw::sqlite::latency_histogram( );
+		assert( histogram.percentile( 0.5 ).count( ) == 0 );
+		for( std::int64_t n = 1; n <= 100; ++n ) {
+			histogram.record( std::chrono::microseconds( n ) );
+		}
+		assert( histogram.count( ) == 100 );
+		assert( histogram.max( ) == std::chrono::microseconds( 100 ) );
+		// Within a bucket, 12.5%, above the exact value
+		auto const p50 = histogram.percentile( 0.5 );
+		assert( p50 >= std::chrono::microseconds( 50 ) and
+		        p50 <= std::chrono::nanoseconds( 56'250 ) );
+		auto const p99 = histogram.percentile( 0.99 );
+		assert( p99 >= std::chrono::microseconds( 99 ) and
+		        p99 <= histogram.max( ) );
+		assert( histogram.percentile( 1.0 ) == histogram.max( ) );
+
+		auto db = daw::sqlite::database( ":memory:" );
+		db.exec( "CREATE TABLE t( v INTEGER );" );
+		db.exec( "INSERT INTO t VALUES( 1 ), ( 2 ), ( 3 );" );
+		auto options = daw::sqlite::profiler_options{ };
+		options.max_statements = 2;
+		db.enable_profiling( options );
+		for( int n = 0; n < 3; ++n ) {
+			for( auto const &row : db.exec( "SELECT v FROM t WHERE v>=?;", n ) ) {
+				(void)row;
+			}
+		}
+		// Statements differing only in their literals are profiled together
+		(void)db.exec( "SELECT v FROM t WHERE v=1;" ).count( );
+		(void)db.exec( "SELECT v FROM t WHERE v=2;" ).count( );
+		auto const find = [&]( std::string_view sql ) {
+			for( auto const &profile : db.profile_snapshot( ) ) {
+				if( profile.sql == sql ) {
+					return profile;
+				}
+			}
+			return daw::sqlite::statement_profile{ };
+		};
+		auto profile = find( "SELECT v FROM t WHERE v>=?;" );
+		assert( profile.calls == 3 );
+		assert( profile.rows == 8 );
+		assert( find( "SELECT v FROM t WHERE v=?;" ).calls == 2 );
+		// Beyond max_statements they are counted together
+		(void)db.exec( "SELECT count(*) FROM t;" ).count( );
+		assert( find( "<other>" ).calls == 1 );
+
+		db.reset_profile( );
+		assert( db.profile_snapshot( ).empty( ) );
+		(void)db.exec( "SELECT v FROM t WHERE v>=?;", 3 ).count( );
+		profile = find( "SELECT v FROM t WHERE v>=?;" );
+		assert( profile.calls == 1 and profile.rows == 1 );
+	}
+
+	void test_backup_and_serialize( ) {
+		auto const file = temp_db_path( "backup_source" );
+		auto const copy = temp_db_path( "backup_copy" );
+		{
+			auto db = daw::sqlite::database( file.path );
+			db.exec( "CREATE TABLE t( v INTEGER, s TEXT );" );
+			db.exec( "WITH RECURSIVE n( i ) AS ( SELECT 1 UNION ALL SELECT i + 1 "
+			         "FROM n WHERE i < 200 ) INSERT INTO t SELECT i, "
+			         "printf( '%0500d', i ) FROM n;" );
+			// Stopped by the progress callback after the first step
+			auto options = daw::sqlite::backup_options{ };
+			options.pages_per_step = 1;
+			auto steps = std::size_t{ 0 };
+			options.progress = [&]( daw::sqlite::backup_progress const &progress ) {
+				++steps;
+				assert( progress.total_pages > 1 );
+				return false;
+			};
+			assert( not db.backup_to( copy.path, options ) );
+			assert( steps == 1 );
+			assert( db.backup_to( copy.path ) );
+		}
+		auto memory = daw::sqlite::database::load_into_memory( copy.path );
+		assert( query_integer( memory, "SELECT sum( v ) FROM t;" ) == 20'100 );
+		memory.exec( "DELETE FROM t WHERE v > 100;" );
+		// A database loaded into memory is one contiguous image
+		assert( not memory.serialize_view( ).empty( ) );
+
+		auto image = memory.serialize( );
+		assert( image and image.size( ) > 0 );
+		auto from_copy = daw::sqlite::database( ":memory:" );
+		from_copy.deserialize( image.bytes( ) );
+		assert( query_integer( from_copy, "SELECT count(*) FROM t;" ) == 100 );
+		auto from_image = daw::sqlite::database( ":memory:" );
+		from_image.deserialize( std::move( image ) );
+		// Taken over without a copy and still writable
+		from_image.exec( "INSERT INTO t( v ) VALUES( 1000 );" );
+		assert( query_integer( from_image, "SELECT max( v ) FROM t;" ) == 1000 );
+
+		// Restored over the file, replacing its contents
+		{
+			auto db = daw::sqlite::database( file.path );
+			assert( db.restore_from( from_image ) );
+			assert( query_integer( db, "SELECT count(*) FROM t;" ) == 101 );
+		}
+		auto reopened = daw::sqlite::database( file.path );
+		assert( query_integer( reopened, "SELECT max( v ) FROM t;" ) == 1000 );
+	}
+
+	template<typename Fn>
+	bool throws_sqlite_exception( Fn &&fn ) {
+		try {
+			fn( );
+		} catch( daw::sqlite::sqlite3_exception const & ) {
+			return true;
+		}
+		return false;
+	}
+
+	void test_blob_stream( ) {
+		auto db = daw::sqlite::database( ":memory:" );
+		db.exec( "CREATE TABLE t( b BLOB );" );
+		db.exec( "INSERT INTO t( rowid, b ) VALUES( 1, ? ), ( 2, x'0102' );",
+		         daw::sqlite::zeroblob{ 10 } );
+		auto stream = daw::sqlite::blob_stream(
+		  db, "t", "b", 1, daw::sqlite::blob_mode::ReadWrite );
+		assert( stream.size( ) == 10 );
+		auto next = std::uint8_t{ 0 };
+		auto const written =
+		  stream.write_all( [&]( std::span<std::byte> buffer ) {
+			  for( auto &b : buffer ) {
+				  b = static_cast<std::byte>( next++ );
+			  }
+			  return buffer.size( );
+		  },
+		                    3 );
+		assert( written == 10 and stream.remaining( ) == 0 );
+
+		auto bytes = std::vector<std::byte>( 4 );
+		stream.read_at( 6, bytes );
+		assert( bytes[0] == std::byte{ 6 } and bytes[3] == std::byte{ 9 } );
+		// Nothing past the end is read or written, including offsets that would
+		// overflow
+		auto const huge = std::numeric_limits<std::size_t>::max( );
+		assert( throws_sqlite_exception( [&] { stream.read_at( 7, bytes ); } ) );
+		assert( throws_sqlite_exception( [&] { stream.read_at( huge, bytes ); } ) );
+		assert( throws_sqlite_exception( [&] { stream.write_at( 8, bytes ); } ) );
+		assert( throws_sqlite_exception( [&] { stream.seek( 11 ); } ) );
+		stream.seek( 8 );
+		assert( stream.read( bytes ) == 2 and stream.remaining( ) == 0 );
+		assert( stream.read( bytes ) == 0 );
+		stream.read_at( 10, std::span<std::byte>( ) );
+
+		stream.reopen( 2 );
+		assert( stream.size( ) == 2 and stream.position( ) == 0 );
+		auto total = std::size_t{ 0 };
+		stream.read_all( [&]( std::span<std::byte const> chunk ) {
+			total += chunk.size( );
+		} );
+		assert( total == 2 );
+
+		auto read_only = daw::sqlite::blob_stream( db, "t", "b", 1 );
+		auto const one = std::array<std::byte, 1>{ };
+		assert( throws_sqlite_exception( [&] { read_only.write( one ); } ) );
+		assert( query_integer( db, "SELECT hex( b )='00010203040506070809' "
+		                           "FROM t WHERE rowid=1;" ) == 1 );
+	}
+
+	void test_result_set_sort( ) {
+		using daw::sqlite::cell_value;
+		using daw::sqlite::compare_cells;
+		auto const two53 = std::int64_t{ 1 } << 53;
+		// Beyond 2^53 an integer is not rounded to the nearest double
+		assert( compare_cells( cell_value( two53 + 1 ),
+		                       cell_value( static_cast<double>( two53 ) ) ) > 0 );
+		assert( compare_cells( cell_value( static_cast<double>( two53 ) ),
+		                       cell_value( two53 + 1 ) ) < 0 );
+		assert( compare_cells( cell_value( two53 ), cell_value( 9007199254740992.0 ) ) ==
+		        0 );
+		auto const max = std::numeric_limits<std::int64_t>::max( );
+		assert( compare_cells( cell_value( max ), cell_value( 9223372036854775808.0 ) ) <
+		        0 );
+		assert( compare_cells( cell_value( std::numeric_limits<std::int64_t>::min( ) ),
+		                       cell_value( -1e19 ) ) > 0 );
+		assert( compare_cells( cell_value( std::int64_t{ -1 } ), cell_value( -1.5 ) ) > 0 );
+		assert( compare_cells( cell_value( std::int64_t{ 2 } ), cell_value( 2.25 ) ) < 0 );
+
+		auto db = daw::sqlite::database( ":memory:" );
+		auto rows = db.fetch_all(
+		  "SELECT 3 UNION ALL SELECT 'b' UNION ALL SELECT NULL UNION ALL SELECT 2.5 "
+		  "UNION ALL SELECT x'00' UNION ALL SELECT 'a' UNION ALL SELECT 3.0;" );
+		rows.sort_by( 0 );
+		assert( rows[0][0].get_type( ) == daw::sqlite::column_type::Null );
+		assert( rows[1][0].get_float( ) == 2.5 );
+		// Equal values keep their order
+		assert( rows[2][0].get_type( ) == daw::sqlite::column_type::Integer );
+		assert( rows[3][0].get_type( ) == daw::sqlite::column_type::Float );
+		assert( rows[4][0].get_text( ) == "a" and rows[5][0].get_text( ) == "b" );
+		assert( rows[6][0].get_type( ) == daw::sqlite::column_type::Blob );
+		rows.sort_by( 0, false );
+		assert( rows[0][0].get_type( ) == daw::sqlite::column_type::Blob );
+	}
+
+	void test_parallel_scan( ) {
+		auto const partitions = daw::sqlite::make_partitions(
+		  std::numeric_limits<std::int64_t>::min( ),
+		  std::numeric_limits<std::int64_t>::max( ),
+		  3 );
+		assert( partitions.size( ) == 3 );
+		assert( partitions.back( ).last == std::numeric_limits<std::int64_t>::max( ) );
+		for( std::size_t n = 1; n < partitions.size( ); ++n ) {
+			assert( partitions[n].first == partitions[n - 1].last + 1 );
+		}
+
+		auto const file = temp_db_path( "parallel_scan" );
+		auto pool_options = daw::sqlite::connection_pool_options{ };
+		pool_options.reader_count = 3;
+		auto pool = daw::sqlite::connection_pool( file.path, pool_options );
+		{
+			auto writer = pool.acquire_writer( );
+			writer->exec( "CREATE TABLE t( v INTEGER );" );
+			writer->exec( "WITH RECURSIVE n( i ) AS ( SELECT 1 UNION ALL SELECT i + 1 "
+			              "FROM n WHERE i < 1000 ) INSERT INTO t SELECT i FROM n;" );
+		}
+		auto options = daw::sqlite::parallel_scan_options{ };
+		options.table = "t";
+		options.columns = "v";
+		options.partition_count = 17;
+		if( not daw::sqlite::parallel_scan_has_snapshots( ) ) {
+			assert( throws_sqlite_exception( [&] {
+				daw::sqlite::parallel_scan(
+				  pool, options, []( auto const &, auto const & ) {} );
+			} ) );
+			options.require_snapshot = false;
+		}
+		auto const reduce = [&] {
+			// Merged in key order, so the result is the same every time
+			return daw::sqlite::parallel_reduce(
+			  pool,
+			  options,
+			  [] { return std::vector<std::int64_t>( ); },
+			  []( std::vector<std::int64_t> &values,
+			      daw::sqlite::row_cursor const &row ) {
+				  values.push_back( row.get_column_integer( 0 ) );
+			  },
+			  []( std::vector<std::int64_t> &into, std::vector<std::int64_t> &&from ) {
+				  into.insert( into.end( ), from.begin( ), from.end( ) );
+			  } );
+		};
+		auto const values = reduce( );
+		assert( values.size( ) == 1000 );
+		assert( std::is_sorted( values.begin( ), values.end( ) ) );
+		assert( reduce( ) == values );
+
+		// Readers leased elsewhere are not waited for
+		auto held = pool.acquire_reader( );
+		auto other = pool.acquire_reader( );
+		auto count = std::atomic<std::size_t>( 0 );
+		daw::sqlite::parallel_scan(
+		  pool, options, [&]( auto const &, auto const & ) { ++count; } );
+		assert( count == 1000 );
+	}
+
+	/***
+	 * @brief Has any statement of db been stepped and not reset
+	 */
+	bool has_busy_statement( daw::sqlite::database &db ) {
+		for( auto *statement = sqlite3_next_stmt( db.get_handle( ), nullptr );
+		     statement != nullptr;
+		     statement = sqlite3_next_stmt( db.get_handle( ), statement ) ) {
+			if( sqlite3_stmt_busy( statement ) ) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	using daw::sqlite::static_impl::count_placeholders;
+	static_assert( count_placeholders( "SELECT a$b FROM t WHERE c=?" ) == 1 );
+	static_assert( count_placeholders( "SELECT '?', \"?\", [?] -- ?\n/* ? */ ?" ) ==
+	               1 );
+	static_assert( count_placeholders( "SELECT x$ FROM t" ) == 0 );
+
+	using insert_item = daw::sqlite::static_statement<
+	  "INSERT INTO items( id, na$me ) VALUES( ?, ? )",
+	  daw::sqlite::params<std::int64_t, std::string_view>>;
+	using find_item = daw::sqlite::static_statement<
+	  "SELECT na$me, id FROM items WHERE id=?", daw::sqlite::params<std::int64_t>,
+	  std::tuple<std::string, std::int64_t>>;
+	using find_id_as_text = daw::sqlite::static_statement<
+	  "SELECT id FROM items WHERE id=?", daw::sqlite::params<std::int64_t>,
+	  std::tuple<std::string>>;
+	using items_from = daw::sqlite::static_statement<
+	  "SELECT id FROM items WHERE id>=? ORDER BY id",
+	  daw::sqlite::params<std::int64_t>, std::int64_t>;
+
+	void test_static_statement( ) {
+		auto db = daw::sqlite::database( ":memory:" );
+		db.exec( "CREATE TABLE items( id INTEGER PRIMARY KEY, na$me TEXT );" );
+		for( std::int64_t n = 1; n <= 3; ++n ) {
+			auto const name = "item" + std::to_string( n );
+			insert_item::exec( db, n, name );
+		}
+		auto const item = find_item::query_one( db, 2 );
+		assert( item and std::get<0>( *item ) == "item2" and std::get<1>( *item ) == 2 );
+		assert( not find_item::query_one( db, 10 ) );
+		assert( not has_busy_statement( db ) );
+		auto sum = std::int64_t{ 0 };
+		for( auto id : items_from::query( db, 2 ) ) {
+			sum += id;
+		}
+		assert( sum == 5 );
+		// A row that cannot be decoded leaves the statement reset
+		assert( throws_sqlite_exception( [&] { (void)find_id_as_text::query_one( db, 1 ); } ) );
+		assert( not has_busy_statement( db ) );
+		assert( find_item::query_one( db, 3 ) );
+	}
+
+	void test_functions( ) {
+		auto db = daw::sqlite::database( ":memory:" );
+		auto options = daw::sqlite::function_options{ };
+		options.deterministic = true;
+		db.register_function(
+		  "add_ints", []( std::int64_t a, std::int64_t b ) { return a + b; }, options );
+		db.register_function( "shout", []( std::string_view text ) {
+			if( text.empty( ) ) {
+				throw std::runtime_error( "nothing to shout" );
+			}
+			return std::string( text ) + '!';
+		} );
+		assert( query_integer( db, "SELECT add_ints( 40, 2 );" ) == 42 );
+		assert( query_integer( db, "SELECT shout( 'hi' )='hi!';" ) == 1 );
+		// Arguments of the wrong type or count, and exceptions, are SQL errors
+		assert( throws_sqlite_exception(
+		  [&] { (void)query_integer( db, "SELECT add_ints( 'a', 2 );" ); } ) );
+		assert( throws_sqlite_exception(
+		  [&] { (void)db.exec( "SELECT add_ints( 1 );" ); } ) );
+		assert( throws_sqlite_exception(
+		  [&] { (void)query_integer( db, "SELECT shout( '' );" ); } ) );
+		// Integers that do not fit the parameter type are not narrowed
+		db.register_function( "twice", []( int x ) { return std::int64_t{ x } * 2; } );
+		db.register_function( "next_u8", []( std::uint8_t x ) { return x + 1; } );
+		db.register_function( "or_zero", []( std::optional<std::uint32_t> x ) {
+			return x.value_or( 0 );
+		} );
+		assert( query_integer( db, "SELECT twice( -2147483648 );" ) == -4294967296 );
+		assert( throws_sqlite_exception(
+		  [&] { (void)query_integer( db, "SELECT twice( 4294967297 );" ); } ) );
+		assert( query_integer( db, "SELECT next_u8( 255 );" ) == 256 );
+		assert( throws_sqlite_exception(
+		  [&] { (void)query_integer( db, "SELECT next_u8( -1 );" ); } ) );
+		assert( query_integer( db, "SELECT or_zero( NULL );" ) == 0 );
+		assert( throws_sqlite_exception(
+		  [&] { (void)query_integer( db, "SELECT or_zero( -1 );" ); } ) );
+
+		db.exec( "CREATE TABLE t( v INTEGER );" );
+		db.exec( "INSERT INTO t VALUES( 1 ), ( 2 ), ( 3 ), ( 4 );" );
+		db.register_aggregate(
+		  "product",
+		  [] { return std::int64_t{ 1 }; },
+		  []( std::int64_t &state, std::int64_t v ) { state *= v; },
+		  []( std::int64_t &state ) { return state; } );
+		assert( query_integer( db, "SELECT product( v ) FROM t;" ) == 24 );
+
+		auto inverse_calls = std::size_t{ 0 };
+		db.register_window_function(
+		  "sum_ints",
+		  [] { return std::int64_t{ 0 }; },
+		  []( std::int64_t &state, std::int64_t v ) { state += v; },
+		  [&]( std::int64_t &state, std::int64_t v ) {
+			  ++inverse_calls;
+			  state -= v;
+		  },
+		  []( std::int64_t &state ) { return state; } );
+		// Sums of each row and the one before it
+		auto sums = std::vector<std::int64_t>( );
+		for( auto v : db.query_as<std::int64_t>(
+		       "SELECT sum_ints( v ) OVER ( ORDER BY v ROWS BETWEEN 1 PRECEDING AND "
+		       "CURRENT ROW ) FROM t ORDER BY v;" ) ) {
+			sums.push_back( v );
+		}
+		assert( ( sums == std::vector<std::int64_t>{ 1, 3, 5, 7 } ) );
+		assert( inverse_calls > 0 );
+		assert( query_integer( db, "SELECT sum_ints( v ) FROM t;" ) == 10 );
+
+		db.remove_function( "add_ints", 2 );
+		assert( throws_sqlite_exception(
+		  [&] { (void)db.exec( "SELECT add_ints( 1, 2 );" ); } ) );
+	}
+
+	struct word {
+		std::string text;
+		std::int64_t length = 0;
+	};
+
+	/***
+	 * @brief The idxNum container_table chose for sql, from EXPLAIN QUERY PLAN,
+	 * and whether sqlite sorts the rows itself
+	 */
+	std::pair<int, bool> vtab_plan( daw::sqlite::database &db,
+	                                std::string const &sql ) {
+		auto st =
+		  daw::sqlite::shared_prepared_statement( db, "EXPLAIN QUERY PLAN " + sql );
+		auto plan = -1;
+		auto sorts = false;
+		while( st.step( ) ) {
+			auto const detail = std::string( st.get_column_text( 3 ) );
+			if( auto const pos = detail.find( "VIRTUAL TABLE INDEX " );
+			    pos != std::string::npos ) {
+				plan = std::stoi( detail.substr( pos + 20 ) );
+			}
+			sorts = sorts or detail.find( "TEMP B-TREE" ) != std::string::npos;
+		}
+		return { plan, sorts };
+	}
+
+	void test_container_table( ) {
+		// Sorted by text
+		auto const words = std::vector<word>{
+		  { "apple", 5 }, { "banana", 6 }, { "cherry", 6 }, { "date", 4 } };
+		auto const counts = std::map<std::string, std::int64_t>{
+		  { "Apple", 1 }, { "Pear", 3 }, { "apple", 2 } };
+		auto db = daw::sqlite::database( ":memory:" );
+		db.register_container(
+		  "words",
+		  words,
+		  daw::sqlite::vtab_column( "text", &word::text, daw::sqlite::vtab_index::Sorted ),
+		  daw::sqlite::vtab_column( "length", &word::length ) );
+		db.register_container(
+		  "counts",
+		  counts,
+		  daw::sqlite::vtab_column(
+		    "name",
+		    []( auto const &kv ) -> std::string const & { return kv.first; },
+		    daw::sqlite::vtab_index::Key ),
+		  daw::sqlite::vtab_column(
+		    "count", []( auto const &kv ) { return kv.second; } ) );
+		auto const kind = []( std::pair<int, bool> plan ) {
+			return plan.first & 0xFF;
+		};
+		auto const bounds = []( std::pair<int, bool> plan ) {
+			return ( plan.first >> 8 ) & 0xFF;
+		};
+		using namespace daw::sqlite::vtab_impl;
+
+		auto const by_rowid = "SELECT length FROM words WHERE rowid = 1";
+		assert( kind( vtab_plan( db, by_rowid ) ) == RowidEq );
+		assert( query_integer( db, by_rowid ) == 6 );
+
+		auto const by_key = "SELECT count FROM counts WHERE name = 'apple'";
+		assert( kind( vtab_plan( db, by_key ) ) == KeyEq );
+		assert( query_integer( db, by_key ) == 2 );
+		assert( query_integer(
+		          db, "SELECT count( * ) FROM counts WHERE name = 'plum'" ) == 0 );
+
+		auto const sorted_eq = "SELECT length FROM words WHERE text = 'cherry'";
+		assert( kind( vtab_plan( db, sorted_eq ) ) == SortedRange );
+		assert( bounds( vtab_plan( db, sorted_eq ) ) == HasEq );
+		assert( query_integer( db, sorted_eq ) == 6 );
+
+		auto const range =
+		  std::string( "SELECT count( * ) FROM words WHERE text > 'apple' AND "
+		               "text <= 'cherry'" );
+		assert( kind( vtab_plan( db, range ) ) == SortedRange );
+		assert( bounds( vtab_plan( db, range ) ) ==
+		        ( HasLower | HasUpper | UpperInclusive ) );
+		assert( query_integer( db, range ) == 2 );
+
+		// A bound of another type is not used for the search, sqlite still
+		// compares it, and every integer sorts before text
+		assert( query_integer( db, "SELECT count( * ) FROM words WHERE text >= 1" ) ==
+		        4 );
+		assert( query_integer( db, "SELECT count( * ) FROM words WHERE text < 1" ) ==
+		        0 );
+		assert( query_integer( db,
+		                       "SELECT count( * ) FROM words WHERE text = 'date' "
+		                       "AND text > 1.5" ) == 1 );
+
+		// Bounds outside the range of an int column, or between its values, are
+		// not searched for, the rows are checked by sqlite
+		auto const numbers = std::vector<int>{ 1, 5, 10 };
+		auto const ids = std::map<int, std::int64_t>{ { 1, 10 }, { 5, 50 } };
+		db.register_container(
+		  "numbers",
+		  numbers,
+		  daw::sqlite::vtab_column(
+		    "v", []( int v ) { return v; }, daw::sqlite::vtab_index::Sorted ) );
+		db.register_container(
+		  "ids",
+		  ids,
+		  daw::sqlite::vtab_column(
+		    "id", []( auto const &kv ) { return kv.first; }, daw::sqlite::vtab_index::Key ) );
+		auto const count = [&]( std::string const &where ) {
+			return query_integer( db, "SELECT count( * ) FROM numbers WHERE " + where );
+		};
+		assert( count( "v < 4294967297" ) == 3 );
+		assert( count( "v > -4294967297" ) == 3 );
+		assert( count( "v > 4294967297" ) == 0 );
+		assert( count( "v = 4294967301" ) == 0 );
+		assert( count( "v BETWEEN -4294967296 AND 4294967301" ) == 3 );
+		assert( count( "v < 5.5" ) == 2 );
+		assert( count( "v >= 4.5" ) == 2 );
+		assert( count( "v > 1.0 AND v <= 10.0" ) == 2 );
+		assert( count( "v = 5.0" ) == 1 );
+		assert( count( "v = 5.5" ) == 0 );
+		assert( query_integer( db, "SELECT count( * ) FROM ids WHERE id = 4294967297" ) ==
+		        0 );
+
+		// Container order is rowid order and the order of a Sorted column
+		assert( not vtab_plan( db, "SELECT text FROM words ORDER BY text" ).second );
+		assert( not vtab_plan( db, "SELECT text FROM words ORDER BY rowid" ).second );
+		assert( vtab_plan( db, "SELECT text FROM words ORDER BY text DESC" ).second );
+		assert( vtab_plan( db, "SELECT text FROM words ORDER BY length" ).second );
+		auto ordered = std::vector<std::string>( );
+		for( auto text :
+		     db.query_as<std::string>( "SELECT text FROM words ORDER BY text" ) ) {
+			ordered.push_back( text );
+		}
+		assert( ( ordered ==
+		          std::vector<std::string>{ "apple", "banana", "cherry", "date" } ) );
+
+		// Another collation cannot use the container's order
+		auto const nocase_key =
+		  "SELECT count( * ) FROM counts WHERE name = 'APPLE' COLLATE NOCASE";
+		assert( kind( vtab_plan( db, nocase_key ) ) == FullScan );
+		assert( query_integer( db, nocase_key ) == 2 );
+		auto const nocase_sorted =
+		  "SELECT count( * ) FROM words WHERE text >= 'B' COLLATE NOCASE";
+		assert( kind( vtab_plan( db, nocase_sorted ) ) == FullScan );
+		assert( query_integer( db, nocase_sorted ) == 3 );
+	}
+
+	void test_quote_identifier( ) {
+		using daw::sqlite::sql_impl::quote_identifier;
+		assert( quote_identifier( "items" ) == "\"items\"" );
+		assert( quote_identifier( "say \"hi\"" ) == "\"say \"\"hi\"\"\"" );
+		// Generated SQL accepts names that need quoting
+		auto const file = temp_db_path( "quote_identifier" );
+		auto options = daw::db::kv_store_options{ };
+		options.table = "odd \"kv\" table";
+		auto kv = daw::db::kv_store( file.path, options );
+		kv.put( std::int64_t{ 1 }, std::string( "a" ) );
+		assert( kv.get_database( ).has_table( "odd \"kv\" table" ) );
+		assert( query_integer( kv.get_database( ),
+		                       "SELECT count( * ) FROM \"odd \"\"kv\"\" table\";" ) == 1 );
+	}
+} // namespace
+
 int main( ) {
+	test_statement_cache_release( );
+	test_zero_copy_binds( );
+	test_integer_parameters( );
+	test_row_cursor( );
+	test_bulk_inserter( );
+	test_transactions( );
+	test_open_options( );
+	test_connection_pool( );
+	test_buffered_rows( );
+	test_fetch_batch( );
+	test_column_metadata( );
+	test_kv_codec( );
+	test_cached_kv_store( );
+	test_async_database( );
+	test_write_queue( );
+	test_busy_policy( );
+	test_profiler( );
+	test_backup_and_serialize( );
+	test_blob_stream( );
+	test_result_set_sort( );
+	test_parallel_scan( );
+	test_static_statement( );
+	test_functions( );
+	test_container_table( );
+	test_quote_identifier( );
+
 	// auto db = database( "db.sqlite" );
 	auto db = daw::sqlite::database( ":memory:" );
 	if( not db.has_table( "tbl" ) ) {
@@ -24,8 +1382,30 @@ int main( ) {
 		std::cout << tbl << '\n';
 	}
 
+	{
+		// Repeated exec of the same sql reuses the cached prepared statement
+		auto &cache = db.get_statement_cache( );
+		cache.reset_stats( );
+		for( std::int64_t n = 0; n < 3; ++n ) {
+			db.exec( "INSERT INTO tbl( ID, FOO ) VALUES( ?, ? );", n, "cached" );
+		}
+		assert( cache.stats( ).misses == 1 );
+		assert( cache.stats( ).hits == 2 );
+	}
+	{
+		// Rows decoded directly into a tuple
+		std::int64_t sum = 0;
+		for( auto [id, foo] :
+		     db.query_as<std::tuple<std::int64_t, std::string_view>>(
+		       "SELECT ID, FOO FROM tbl WHERE FOO=?;", "cached" ) ) {
+			assert( foo == "cached" );
+			sum += id;
+		}
+		assert( sum == 3 );
+	}
+
 	static constexpr daw::string_view sql =
-	  "SELECT name FROM sqlite_schema WHERE type='?' ORDER BY name;";
+	  "SELECT name FROM sqlite_schema WHERE type=? ORDER BY name;";
 	{
 		// Test that an error occurs when more than 1 row is returned from db.exec
 		// without callback and without specifying to ignore them
@@ -33,6 +1413,18 @@ int main( ) {
 		auto const d = std::distance( it, it.end( ) );
 		assert( d == 2 );
 
+		// Counting buffers the rows, iterating afterwards replays them
+		auto counted = db.exec( sql, "table" );
+		assert( counted.count( ) == 2 );
+		assert( counted.front( ).front( ).value.get_text( ) == "tbl" );
+		++counted;
+		assert( counted.count( ) == 1 );
+		assert( counted.front( ).front( ).value.get_text( ) == "tbl2" );
+		++counted;
+		assert( counted.empty( ) );
+		counted.reset( );
+		assert( std::distance( counted, counted.end( ) ) == 2 );
+
 		std::cout << "Table names 2\n";
 		for( auto const &row : db.exec( sql, "table" ) ) {
 			auto value = row["name"];